@@ -33,6 +33,15 @@
  * |   Date	    | Description                                    |
  * |:----------:|:-----------------------------------------------|
  * | 18/01/2024 | Document creation		                         |
+ * | 17/10/2026 | SPI device kept open between transfers         |
+ * | 17/10/2026 | Double buffered DMA pixel transfers            |
+ * | 17/10/2026 | Lines, circles and triangles drawn in spans    |
+ * | 17/10/2026 | Glyph cache, one address window per text line  |
+ * | 17/10/2026 | Vertical scrolling                             |
+ * | 17/10/2026 | Compressed pictures                            |
+ * | 17/10/2026 | Fixed point convex polygons                    |
+ * | 17/10/2026 | Window and pixels sent as one transfer list    |
+ * | 17/10/2026 | One transfer done callback for each drawing    |
  *
  */
 
@@ -46,6 +55,9 @@
 #define ILI9341_WIDTH       240			/*!< LCD width in pixels */
 #define ILI9341_HEIGHT      320			/*!< LCD height in pixels */
 #define ILI9341_PIXEL_MAX	76800
+#define ILI9341_BUFFER_SIZE	SPI_MAX_TRANSFER_SIZE	/*!< Size in bytes of each DMA pixel buffer */
+#define ILI9341_GLYPH_CACHE_SIZE	16384	/*!< Bytes of RAM used to keep characters expanded to RGB565 */
+#define ILI9341_GLYPH_CACHE_ENTRIES	32		/*!< Maximum number of characters kept in the glyph cache */
 /* 16bits colors (RGB565) */			/*	 R,   G,   B */
 #define ILI9341_BLACK          	0x0000  /*   0,   0,   0 */
 #define ILI9341_NAVY           	0x000F 	/*   0,   0, 128 */
@@ -80,6 +92,14 @@ typedef enum ili9341_orientation {
 	ILI9341_Landscape_1, 	/*!< Landscape orientation mode 1 */
 	ILI9341_Landscape_2  	/*!< Landscape orientation mode 2 */
 } ili9341_orientation_t;
+
+/**
+ * @brief  Point on the LCD
+ */
+typedef struct {
+	int16_t x;		/*!< X coordinate */
+	int16_t y;		/*!< Y coordinate */
+} ili9341_point_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -115,8 +135,17 @@ void ILI9341Fill(uint16_t color);
  */
 void ILI9341Rotate(ili9341_orientation_t orientation);
 
+/**
+ * @brief  		Gets current LCD orientation
+ * @retval 		LCD orientation
+ */
+ili9341_orientation_t ILI9341GetOrientation(void);
+
 /**
  * @brief  		Draw a single character on the LCD
+ * @note		Characters are expanded to RGB565 once for each font and colors pair,
+ * 				and kept in a cache of ILI9341_GLYPH_CACHE_SIZE bytes. Least recently
+ * 				used characters are discarded when the cache is full.
  * @param[in]  	x: X position of top left corner
  * @param[in]  	y: Y position of top left corner
  * @param[in] 	data: Character to be displayed
@@ -154,6 +183,9 @@ void ILI9341DrawInt(uint16_t x, uint16_t y, uint32_t num, uint8_t dig, Font_t* f
 
 /**
  * @brief  		Draw a string on the LCD
+ * @note		Each line of text is sent with a single address window; the 1 pixel gap
+ * 				between characters is drawn with the background color. Text that does not
+ * 				fit in the LCD width continues on a new line.
  * @param[in] 	x: X position of top left corner of first character in string
  * @param[in]  	y: Y position of top left corner of first character in string
  * @param[in]  	str: Pointer to first character
@@ -253,6 +285,29 @@ void ILI9341DrawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t
  */
 void ILI9341DrawFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 
+/**
+ * @brief  		Draws polygon on the LCD
+ * @param[in]  	points: Vertices, in order along the outline
+ * @param[in]  	count: Number of vertices
+ * @param[in]  	color: Polygon color (RGB565)
+ * @retval 		None
+ */
+void ILI9341DrawPolygon(const ili9341_point_t *points, uint8_t count, uint16_t color);
+
+/**
+ * @brief  		Draws filled convex polygon on the LCD
+ * @note		Each row is filled between the two edges that cross it, stepped in 16.16
+ * 				fixed point (one division per edge). Drawing a convex shape this way
+ * 				instead of as triangles sets up each outline edge once and never the
+ * 				edges between triangles. Concave polygons are not filled correctly.
+ * 				Only the rows on the LCD are walked, whatever the vertex coordinates.
+ * @param[in]  	points: Vertices, in order along the outline (clockwise or counterclockwise)
+ * @param[in]  	count: Number of vertices
+ * @param[in]  	color: Polygon color (RGB565)
+ * @retval 		None
+ */
+void ILI9341DrawFilledPolygon(const ili9341_point_t *points, uint8_t count, uint16_t color);
+
 /**
  * @brief  		Draw a picture on the LCD
  * @note		Pictures must be converted to uint8_t array. 
@@ -267,6 +322,84 @@ void ILI9341DrawFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, i
  */
 void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pic);
 
+/**
+ * @brief  		Draw a compressed picture on the LCD
+ * @note		Pictures are converted with firmware/tools/img565.py (see img565.h). They are
+ * 				decoded straight into the DMA pixel buffers while the previous one is sent.
+ * @param[in] 	x: X position of top left corner of picture
+ * @param[in]  	y: Y position of top left corner of picture
+ * @param[in]  	img: Pointer to first byte of compressed picture
+ * @retval 		1 when success, 0 when fails (not a compressed picture)
+ */
+uint8_t ILI9341DrawCompressedPicture(uint16_t x, uint16_t y, const uint8_t* img);
+
+/**
+ * @brief  		Define the LCD area to be written with the following pixel buffers
+ * @note		Pixels are written left to right and top to bottom, 2 bytes each (RGB565, high byte first)
+ * @param[in]  	x0: X coordinate of top left point
+ * @param[in]  	y0: Y coordinate of top left point
+ * @param[in]  	x1: X coordinate of bottom right point
+ * @param[in]  	y1: Y coordinate of bottom right point
+ * @retval 		None
+ */
+void ILI9341SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
+/**
+ * @brief  		Get a free DMA pixel buffer to fill
+ * @note		The driver uses two buffers: one can be filled while the other one is being sent.
+ * 				If the buffer is still being sent, waits for its transfer to end.
+ * @param[out]  size: Pointer to variable to store buffer size in bytes (ILI9341_BUFFER_SIZE)
+ * @retval 		Pointer to pixel buffer
+ */
+uint8_t* ILI9341GetPixelBuffer(uint32_t *size);
+
+/**
+ * @brief  		Queue the buffer returned by the last ILI9341GetPixelBuffer() to be sent to the LCD
+ * @note		Returns without waiting for the transfer. Any other command to the LCD waits 
+ * 				for queued buffers to be sent first.
+ * @param[in]  	size: Number of bytes to send
+ * @param[in]  	last: true on the last buffer of a drawing (calls transfer done callback when sent)
+ * @retval 		None
+ */
+void ILI9341PushPixelBuffer(uint32_t size, bool last);
+
+/**
+ * @brief  		Wait until all queued pixel buffers are sent
+ * @retval 		None
+ */
+void ILI9341WaitTransfer(void);
+
+/**
+ * @brief  		Set a function to be called when the last buffer of a drawing has been sent
+ * @note		Drawing functions may return before their last pixels are sent. The callback is
+ * 				called once for each drawing function (shapes made of others included), always
+ * 				from the SPI interrupt that ends its last transfer, and not at all for drawings
+ * 				completely outside the LCD. ILI9341PushPixelBuffer() calls it for buffers queued
+ * 				with last set.
+ * @param[in]  	func_p: Pointer to callback function (NULL to disable)
+ * @param[in]  	param_p: Pointer to callback function parameter
+ * @retval 		None
+ */
+void ILI9341SetTransferDoneCallback(void *func_p, void *param_p);
+
+/**
+ * @brief  		Define the vertical scrolling area
+ * @note		Scrolling works on the 320 pixels side of the LCD (rows in portrait,
+ * 				columns in landscape), in LCD memory order: Portrait_2 and Landscape_2
+ * 				orientations count lines from the opposite side.
+ * @param[in]  	top: Number of fixed lines before the scrolling area
+ * @param[in]  	length: Number of lines of the scrolling area
+ * @retval 		None
+ */
+void ILI9341SetScrollArea(uint16_t top, uint16_t length);
+
+/**
+ * @brief  		Set the memory line shown on the first line of the scrolling area
+ * @param[in]  	line: Memory line (from top to top + length - 1)
+ * @retval 		None
+ */
+void ILI9341Scroll(uint16_t line);
+
 /**
  * @brief  	De-initializes ILI9341 LCD
  * @param	None
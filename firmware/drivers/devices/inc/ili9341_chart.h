@@ -0,0 +1,99 @@
+#ifndef ILI9341_CHART_H_
+#define ILI9341_CHART_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Drivers_Devices Drivers devices
+ ** @{ */
+/** \addtogroup ILI9341_CHART ILI9341 strip chart
+ ** @{
+ * @brief  Strip chart (oscilloscope like trace) for the ILI9341 LCD, using hardware scrolling
+ *
+ * @note Each sample is a line of the LCD memory along its 320 pixels side. New samples
+ * are written over the oldest ones and the LCD scrolling start line is moved, so the
+ * trace scrolls without redrawing it. Only the pixels between the old and the new
+ * trace of each line are sent, and consecutive lines are sent with a single window.
+ *
+ * @note In Landscape_1 orientation new samples enter on the right side and the trace
+ * scrolls to the left. Hardware scrolling moves whole lines: anything drawn across the
+ * chart lines (from start to start + length - 1) scrolls with the trace.
+ *
+ * @note Only one chart can be shown at a time.
+ *
+ * @author Albano Peñalva
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    |
+ * |:----------:|:-----------------------------------------------|
+ * | 17/10/2026 | Document creation		                         |
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "ili9341.h"
+/*==================[macros]=================================================*/
+
+/*==================[typedef]================================================*/
+/**
+ * @brief  Strip chart configuration
+ */
+typedef struct {
+	uint16_t start;			/*!< First line of the chart along the 320 pixels side (LCD memory order, see ILI9341SetScrollArea()) */
+	uint16_t length;		/*!< Number of lines of the chart (samples shown) */
+	uint16_t amp_start;		/*!< First pixel of the trace along the 240 pixels side */
+	uint16_t amp_size;		/*!< Number of pixels of the trace along the 240 pixels side */
+	float min;				/*!< Sample value shown at amp_start + amp_size - 1 */
+	float max;				/*!< Sample value shown at amp_start */
+	uint16_t color;			/*!< Trace color (RGB565) */
+	uint16_t background;	/*!< Background color (RGB565) */
+} ili9341_chart_config_t;
+
+/**
+ * @brief  Strip chart state
+ */
+typedef struct {
+	ili9341_chart_config_t config;	/*!< Configuration */
+	float scale;					/*!< Pixels per sample unit */
+	uint16_t position;				/*!< Next line to be written */
+	uint8_t last;					/*!< Trace pixel of the last sample */
+	bool started;					/*!< A sample has already been drawn */
+	uint8_t low[ILI9341_HEIGHT];	/*!< First trace pixel of each line */
+	uint8_t high[ILI9341_HEIGHT];	/*!< Last trace pixel of each line */
+} ili9341_chart_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief  		Initializes a strip chart: sets the scrolling area and clears the chart lines
+ * @note		ILI9341Init() must be called first.
+ * @param[in]  	chart: Pointer to chart state
+ * @param[in]  	config: Pointer to chart configuration
+ * @retval 		1 when success, 0 when fails (chart out of the LCD)
+ */
+uint8_t ILI9341ChartInit(ili9341_chart_t *chart, ili9341_chart_config_t *config);
+
+/**
+ * @brief  		Adds a block of samples to the chart and scrolls it
+ * @param[in]  	chart: Pointer to chart state
+ * @param[in]  	samples: Samples (as given by the signal processing functions)
+ * @param[in]  	count: Number of samples
+ * @retval 		None
+ */
+void ILI9341ChartAddSamples(ili9341_chart_t *chart, const float *samples, uint32_t count);
+
+/**
+ * @brief  		De-initializes the chart, restoring the LCD without scrolling
+ * @param[in]  	chart: Pointer to chart state
+ * @retval 		1 when success, 0 when fails
+ */
+uint8_t ILI9341ChartDeInit(ili9341_chart_t *chart);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* ILI9341_CHART_H_ */
+
+/*==================[end of file]============================================*/
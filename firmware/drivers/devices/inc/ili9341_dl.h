@@ -0,0 +1,125 @@
+#ifndef ILI9341_DL_H_
+#define ILI9341_DL_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Drivers_Devices Drivers devices
+ ** @{ */
+/** \addtogroup ILI9341_DL ILI9341 display list
+ ** @{
+ * @brief  Display list for the ILI9341 LCD: record a screen and send it in one pass
+ *
+ * @note Drawings are recorded in a buffer given by the user, and sent by ILI9341DlReplay():
+ * - Drawings completely covered by a later filled rectangle, string or icon are skipped.
+ * - Drawings are sorted from top to bottom and left to right, without changing the
+ * order of the ones that overlap.
+ * - Filled rectangles of the same color that make a bigger rectangle are sent as one.
+ * Strings of the same font and colors that continue each other on a line (1 pixel
+ * apart, as ILI9341DrawString() leaves between characters) are sent as one when a
+ * drawing sent after them covers that pixel column, since the joined string paints
+ * it with the background.
+ *
+ * @note The list can be replayed as many times as needed, and different lists from
+ * different tasks (one LCD access at a time).
+ *
+ * @author Albano Peñalva
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    |
+ * |:----------:|:-----------------------------------------------|
+ * | 17/10/2026 | Document creation		                         |
+ * | 17/10/2026 | Strings joined only over a covered gap         |
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "ili9341.h"
+/*==================[macros]=================================================*/
+#define ILI9341_DL_MAX_CMDS		64		/*!< Maximum number of drawings in a display list */
+#define ILI9341_DL_MAX_TEXT		64		/*!< Maximum length of strings sent as one */
+/*==================[typedef]================================================*/
+/**
+ * @brief  Display list
+ */
+typedef struct {
+	uint8_t *buffer;						/*!< Recorded drawings */
+	uint32_t size;							/*!< Buffer size in bytes */
+	uint32_t used;							/*!< Bytes used of buffer */
+	uint16_t count;							/*!< Number of drawings */
+	void *order[ILI9341_DL_MAX_CMDS];		/*!< Replay order */
+} ili9341_dl_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief  		Initializes an empty display list
+ * @param[in]  	dl: Pointer to display list
+ * @param[in]  	buffer: Memory for recorded drawings (about 24 bytes each, plus string lengths).
+ * 				Bytes before the first pointer aligned address are not used.
+ * @param[in]  	size: Buffer size in bytes
+ * @retval 		None
+ */
+void ILI9341DlInit(ili9341_dl_t *dl, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief  		Removes all drawings from a display list
+ * @param[in]  	dl: Pointer to display list
+ * @retval 		None
+ */
+void ILI9341DlClear(ili9341_dl_t *dl);
+
+/**
+ * @brief  		Records a filled rectangle (see ILI9341DrawFilledRectangle())
+ * @param[in]  	dl: Pointer to display list
+ * @param[in]  	x0: X coordinate of top left point
+ * @param[in]  	y0: Y coordinate of top left point
+ * @param[in]  	x1: X coordinate of bottom right point
+ * @param[in]  	y1: Y coordinate of bottom right point
+ * @param[in]  	color: Rectangle color (RGB565)
+ * @retval 		1 when success, 0 when fails (display list full)
+ */
+uint8_t ILI9341DlFilledRectangle(ili9341_dl_t *dl, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
+
+/**
+ * @brief  		Records a string (see ILI9341DrawString()). The string is copied.
+ * @param[in]  	dl: Pointer to display list
+ * @param[in] 	x: X position of top left corner of first character in string
+ * @param[in]  	y: Y position of top left corner of first character in string
+ * @param[in]  	str: Pointer to first character
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for string (RGB565)
+ * @param[in]  	background: Color for string background (RGB565)
+ * @retval 		1 when success, 0 when fails (display list full, or string of 65535
+ * 				characters or more)
+ */
+uint8_t ILI9341DlString(ili9341_dl_t *dl, uint16_t x, uint16_t y, char* str, Font_t *font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Records an icon (see ILI9341DrawIcon())
+ * @param[in]  	dl: Pointer to display list
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in] 	icon: Icon to be displayed
+ * @param[in]  	icon_font: Pointer to used font
+ * @param[in]  	foreground: Color for icon (RGB565)
+ * @param[in]  	background: Color for icon background (RGB565)
+ * @retval 		1 when success, 0 when fails (display list full)
+ */
+uint8_t ILI9341DlIcon(ili9341_dl_t *dl, uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Sends the drawings of a display list to the LCD
+ * @param[in]  	dl: Pointer to display list
+ * @retval 		Number of drawings sent, after skipping and joining them
+ */
+uint16_t ILI9341DlReplay(ili9341_dl_t *dl);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* ILI9341_DL_H_ */
+
+/*==================[end of file]============================================*/
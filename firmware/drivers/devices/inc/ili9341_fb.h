@@ -0,0 +1,196 @@
+#ifndef ILI9341_FB_H_
+#define ILI9341_FB_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Drivers_Devices Drivers devices
+ ** @{ */
+/** \addtogroup ILI9341_FB ILI9341 framebuffer
+ ** @{
+ * @brief  Partial framebuffer for the ILI9341 LCD
+ *
+ * @note A rectangular area of the LCD (for example a strip of lines with live values)
+ * is kept in internal RAM. Drawing functions of this module only write RAM, and record
+ * the rectangles where pixels really changed. Overlapping or adjacent rectangles are
+ * merged. ILI9341FbFlush() sends only those rectangles to the LCD, with a single
+ * address window each.
+ *
+ * @note Coordinates are LCD coordinates. Anything outside the framebuffer area is clipped.
+ *
+ * @note A 240x40 pixels strip takes 19200 bytes of RAM.
+ *
+ * @note In palette mode (ILI9341FbInitPalette()) each pixel is an 8 bits index to a table
+ * of 256 RGB565 colors, so a full 240x320 screen takes 76800 bytes. Drawing functions take
+ * palette indexes instead of colors, and pixels are expanded to RGB565 as they are copied
+ * to the DMA buffers. Changing the palette recolors the whole area on next flush.
+ *
+ * @author Albano Peñalva
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    |
+ * |:----------:|:-----------------------------------------------|
+ * | 17/10/2026 | Document creation		                         |
+ * | 17/10/2026 | 8 bits palette mode                            |
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include "ili9341.h"
+/*==================[macros]=================================================*/
+#define ILI9341_FB_MAX_DIRTY	8		/*!< Maximum number of dirty rectangles kept between flushes */
+#define ILI9341_FB_PALETTE_SIZE	256		/*!< Number of colors of the palette */
+/*==================[typedef]================================================*/
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief  		Initializes the framebuffer over an area of the LCD
+ * @note		ILI9341Init() must be called first. The whole area is sent on the first flush.
+ * @param[in]  	x: X position of top left corner of the area
+ * @param[in]  	y: Y position of top left corner of the area
+ * @param[in]  	width: Area width in pixels
+ * @param[in]  	height: Area height in pixels
+ * @retval 		1 when success, 0 when fails (not enough memory)
+ */
+uint8_t ILI9341FbInit(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+/**
+ * @brief  		Initializes the framebuffer in palette mode (1 byte per pixel)
+ * @note		The default palette has index bits as RRRGGGBB.
+ * @param[in]  	x: X position of top left corner of the area
+ * @param[in]  	y: Y position of top left corner of the area
+ * @param[in]  	width: Area width in pixels
+ * @param[in]  	height: Area height in pixels
+ * @retval 		1 when success, 0 when fails (not enough memory)
+ */
+uint8_t ILI9341FbInitPalette(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+/**
+ * @brief  		Changes palette colors
+ * @param[in]  	first: First palette index to change
+ * @param[in]  	count: Number of colors
+ * @param[in]  	colors: RGB565 colors
+ * @retval 		None
+ */
+void ILI9341FbSetPalette(uint8_t first, uint16_t count, const uint16_t *colors);
+
+/**
+ * @brief  		Fills the entire framebuffer with color
+ * @param[in]	color: Color to be used in fill (RGB565, or palette index)
+ * @retval 		None
+ */
+void ILI9341FbFill(uint16_t color);
+
+/**
+ * @brief  		Draws single pixel to framebuffer
+ * @param[in]  	x: X position for pixel
+ * @param[in]  	y: Y position for pixel
+ * @param[in]  	color: Color of pixel (RGB565, or palette index)
+ * @retval 		None
+ */
+void ILI9341FbDrawPixel(int16_t x, int16_t y, uint16_t color);
+
+/**
+ * @brief  		Draws line on the framebuffer
+ * @param[in]  	x0: X coordinate of starting point
+ * @param[in]  	y0: Y coordinate of starting point
+ * @param[in]  	x1: X coordinate of ending point
+ * @param[in]  	y1: Y coordinate of ending point
+ * @param[in]  	color: Line color (RGB565, or palette index)
+ * @retval 		None
+ */
+void ILI9341FbDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief  		Draws rectangle on the framebuffer
+ * @param[in]  	x0: X coordinate of top left point
+ * @param[in]  	y0: Y coordinate of top left point
+ * @param[in]  	x1: X coordinate of bottom right point
+ * @param[in]  	y1: Y coordinate of bottom right point
+ * @param[in]  	color: Rectangle color (RGB565, or palette index)
+ * @retval 		None
+ */
+void ILI9341FbDrawRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief  		Draws filled rectangle on the framebuffer
+ * @param[in]  	x0: X coordinate of top left point
+ * @param[in]  	y0: Y coordinate of top left point
+ * @param[in]  	x1: X coordinate of bottom right point
+ * @param[in]  	y1: Y coordinate of bottom right point
+ * @param[in]  	color: Rectangle color (RGB565, or palette index)
+ * @retval 		None
+ */
+void ILI9341FbDrawFilledRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief  		Draw a single character on the framebuffer
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in] 	data: Character to be displayed
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for char (RGB565, or palette index)
+ * @param[in]  	background: Color for char background (RGB565, or palette index)
+ * @retval		None
+ */
+void ILI9341FbDrawChar(int16_t x, int16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Draw a string on the framebuffer
+ * @param[in] 	x: X position of top left corner of first character in string
+ * @param[in]  	y: Y position of top left corner of first character in string
+ * @param[in]  	str: Pointer to first character
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for string (RGB565, or palette index)
+ * @param[in]  	background: Color for string background (RGB565, or palette index)
+ * @retval 		None
+ */
+void ILI9341FbDrawString(int16_t x, int16_t y, char* str, Font_t *font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Draw an integer on the framebuffer
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in] 	num: Number to be displayed
+ * @param[in] 	dig: Number of digits to display
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for char (RGB565, or palette index)
+ * @param[in]  	background: Color for char background (RGB565, or palette index)
+ * @retval		None
+ */
+void ILI9341FbDrawInt(int16_t x, int16_t y, uint32_t num, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Draw an icon on the framebuffer
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in] 	icon: Icon to be displayed
+ * @param[in]  	icon_font: Pointer to used font
+ * @param[in]  	foreground: Color for icon (RGB565, or palette index)
+ * @param[in]  	background: Color for icon background (RGB565, or palette index)
+ * @retval		None
+ */
+void ILI9341FbDrawIcon(int16_t x, int16_t y, icon_t icon, icon_font_t* icon_font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Send the changed areas of the framebuffer to the LCD
+ * @note		Returns when the last area is queued (see ILI9341WaitTransfer()).
+ * @retval 		Number of pixel bytes sent
+ */
+uint32_t ILI9341FbFlush(void);
+
+/**
+ * @brief  	De-initializes the framebuffer and frees its memory
+ * @param	None
+ * @retval 	1 when success, 0 when fails
+ */
+uint8_t ILI9341FbDeInit(void);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* ILI9341_FB_H_ */
+
+/*==================[end of file]============================================*/
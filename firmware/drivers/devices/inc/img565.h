@@ -0,0 +1,84 @@
+#ifndef IMG565_H_
+#define IMG565_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Drivers_Devices Drivers devices
+ ** @{ */
+/** \addtogroup IMG565 Compressed RGB565 images
+ ** @{
+ * @brief  Compressed RGB565 image format and streaming decoder
+ *
+ * @note Images are created from PNG/BMP files (or raw RGB565 arrays) with
+ * firmware/tools/img565.py, which writes a C array ready to be added to a project.
+ *
+ * @note Format: an 8 bytes header ("R565", width and height as 16 bits big endian)
+ * followed by one opcode for each new color or run of colors. Pixels are coded
+ * from left to right and from top to bottom:
+ *
+ * |   Opcode	   			| Bytes | Description                                              	|
+ * |:----------------------:|:-----:|:----------------------------------------------------------|
+ * | 00iiiiii		  		| 1		| Color i of the table of last 64 colors (indexed by hash)	|
+ * | 01rrggbb		  		| 1		| Previous color plus r, g, b (-2..1)						|
+ * | 10gggggg rrrrbbbb 		| 2		| Previous color plus g (-32..31), r and b (-8..7) + g/2	|
+ * | 11nnnnnn		  		| 1		| Previous color repeated n + 1 times (1..62)				|
+ * | 11111110 color 		| 3		| RGB565 color (big endian)									|
+ * | 11111111 n		 		| 3		| Previous color repeated n + 1 times (n 16 bits big endian)|
+ *
+ * @note Previous color starts as black, and the table of colors as all black.
+ * Color c is stored in table at (3 * R + 5 * G + 7 * B) % 64.
+ *
+ * @author Albano Peñalva
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    |
+ * |:----------:|:-----------------------------------------------|
+ * | 17/10/2026 | Document creation		                         |
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+/*==================[macros]=================================================*/
+#define IMG565_HEADER_SIZE	8		/*!< Size in bytes of image header */
+#define IMG565_INDEX_SIZE	64		/*!< Number of colors in the table of last colors */
+/*==================[typedef]================================================*/
+/**
+ * @brief  Decoder state, so an image can be decoded in pieces
+ */
+typedef struct {
+	const uint8_t *data;					/*!< Next opcode */
+	uint32_t pixels;						/*!< Pixels left to decode */
+	uint32_t run;							/*!< Pixels left of the current color */
+	uint16_t previous;						/*!< Previous color */
+	uint16_t index[IMG565_INDEX_SIZE];		/*!< Table of last colors */
+} img565_decoder_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief  		Initializes a decoder and reads image size
+ * @param[in]  	decoder: Pointer to decoder state
+ * @param[in]  	img: Pointer to first byte of compressed image
+ * @param[out] 	width: Image width in pixels
+ * @param[out] 	height: Image height in pixels
+ * @retval 		1 when success, 0 when fails (not a compressed image)
+ */
+uint8_t Img565Init(img565_decoder_t *decoder, const uint8_t *img, uint16_t *width, uint16_t *height);
+
+/**
+ * @brief  		Decodes the next pixels of the image
+ * @param[in]  	decoder: Pointer to decoder state
+ * @param[out] 	pixels: Buffer for RGB565 pixels (LCD byte order, high byte first)
+ * @param[in]  	size: Buffer size in bytes
+ * @retval 		Number of bytes written to buffer (0 when the image is complete)
+ */
+uint32_t Img565Decode(img565_decoder_t *decoder, uint8_t *pixels, uint32_t size);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* IMG565_H_ */
+
+/*==================[end of file]============================================*/
@@ -10,6 +10,20 @@
 /** \brief MPU6050 sensor module is a 6-axis Motion Tracking Device. It combines 3-axis Accelerometer and 3-axis Gyroscope. It communicates with the EDU-ESP
  * board via I2C.
  * 
+ * @note Functions without a sensor parameter work on one sensor (MPU6050_initialize(),
+ * MPU6050_Address()). Two sensors (MPU6050_ADDRESS_AD0_LOW and MPU6050_ADDRESS_AD0_HIGH)
+ * can share the bus as instances (mpu6050_t, MPU6050_deviceInit()), and be sampled
+ * together as a group (mpu6050_group_t): register reads queued back to back with a
+ * common timestamp (MPU6050_groupSample()), or FIFOs read alternately and matched
+ * by timestamp (MPU6050_groupStreamRead(), MPU6050_groupStreamGet()). Streams keep
+ * the address of their sensor, so different streams can be read from different tasks.
+ *
+ * @note Only the MPU6050_device..., MPU6050_group... and stream functions take a
+ * sensor. The register getters and setters, the DMP functions and MPU6050_ReadRegister()
+ * work on the sensor selected with MPU6050_Address(), a setting shared by every task:
+ * using them on two sensors means calling MPU6050_Address() before each one, from a
+ * single task.
+ * 
  * @author Juan Ignacio Cerrudo
  *
  * @section changelog
@@ -17,6 +31,13 @@
  * |   Date	| Description                                    			|
  * |:----------:|:----------------------------------------------------------------------|
  * | 30/01/2024 | Document creation		                         		|
+ * | 17/10/2026 | Register shadow copy, configuration in bursts				|
+ * | 17/10/2026 | FIFO streaming of timestamped samples					|
+ * | 17/10/2026 | Sampling on data ready interrupt						|
+ * | 17/10/2026 | DMP memory access, firmware upload and packets				|
+ * | 17/10/2026 | Sensor instances, group sampling of two sensors				|
+ * | 17/10/2026 | Declarative configuration, written in bursts and verified		|
+ * | 17/10/2026 | Data ready sampling of sensor instances, checked instance reads	|
  * 
  **/
 
@@ -407,9 +428,88 @@
 #define MPU6050_DMP_MEMORY_BANKS        8
 #define MPU6050_DMP_MEMORY_BANK_SIZE    256
 #define MPU6050_DMP_MEMORY_CHUNK_SIZE   16
-// note: DMP code memory blocks defined at end of header file
+#define MPU6050_DMP_PACKET_SIZE         42      // MotionApps 2.0 FIFO packet: quaternion, gyroscope, accelerometer
+// note: DMP firmware is not included, it is given to MPU6050_dmpLoadFirmware()
+
+#define MPU6050_FIFO_SIZE           1024
+#define MPU6050_GROUP_SIZE          2       /*!< Maximum number of sensors in a group (one for each address) */
+
+/** Configuration of MPU6050_initialize(): PLL with X gyro reference, +/- 250 deg/s, +/- 2 g, awake */
+#define MPU6050_CONFIG_DEFAULT      {0, MPU6050_DLPF_BW_256, MPU6050_GYRO_FS_250, MPU6050_ACCEL_FS_2, MPU6050_CLOCK_PLL_XGYRO, 0, 0, 0, false}
+#define MPU6050_STREAM_ACCEL        (1 << MPU6050_ACCEL_FIFO_EN_BIT)    /*!< Accelerometer in the FIFO */
+#define MPU6050_STREAM_GYRO         ((1 << MPU6050_XG_FIFO_EN_BIT) | (1 << MPU6050_YG_FIFO_EN_BIT) | (1 << MPU6050_ZG_FIFO_EN_BIT))   /*!< Gyroscope in the FIFO */
 
 /*==================[typedef]================================================*/
+/**
+ * @brief Sample read from the FIFO
+ */
+typedef struct {
+	int64_t timestamp;			/*!< Sampling time (microseconds, esp_timer_get_time() clock) */
+	int16_t accel[3];			/*!< Accelerometer X, Y, Z (0 if not in the FIFO) */
+	int16_t gyro[3];			/*!< Gyroscope X, Y, Z (0 if not in the FIFO) */
+} mpu6050_sample_t;
+
+/**
+ * @brief FIFO streaming state, with a ring buffer of samples given by the caller
+ */
+typedef struct {
+	mpu6050_sample_t *samples;	/*!< Ring buffer */
+	uint16_t size;				/*!< Ring buffer size (holds size - 1 samples) */
+	volatile uint16_t head;		/*!< Next place to write */
+	volatile uint16_t tail;		/*!< Next sample to read */
+	uint8_t contents;			/*!< FIFO contents (MPU6050_STREAM_ACCEL and/or MPU6050_STREAM_GYRO) */
+	uint8_t frame_size;			/*!< Bytes of each sample in the FIFO */
+	uint32_t period;			/*!< Sample period (microseconds) */
+	uint32_t overflows;			/*!< FIFO overflows (samples lost) */
+	uint8_t devAddr;			/*!< I2C address of the sensor */
+	int64_t next_time;			/*!< Timestamp of the next sample in the FIFO (0: unknown) */
+} mpu6050_stream_t;
+
+/**
+ * @brief Whole sensor configuration. Fields are full register values or fields of
+ * registers whose other bits are left at 0 (external sync, self test, high pass filter).
+ */
+typedef struct {
+	uint8_t rate;				/*!< Sample rate divider (see MPU6050_setRate()) */
+	uint8_t dlpf;				/*!< Digital low pass filter (MPU6050_DLPF_BW_x) */
+	uint8_t gyro_range;			/*!< Gyroscope full scale (MPU6050_GYRO_FS_x) */
+	uint8_t accel_range;		/*!< Accelerometer full scale (MPU6050_ACCEL_FS_x) */
+	uint8_t clock_source;		/*!< Clock source (MPU6050_CLOCK_x) */
+	uint8_t fifo_contents;		/*!< FIFO_EN register (i.e. MPU6050_STREAM_ACCEL | MPU6050_STREAM_GYRO, 0 for none) */
+	uint8_t int_pin_cfg;		/*!< INT_PIN_CFG register (interrupt pin mode, latch and clear) */
+	uint8_t int_enable;			/*!< INT_ENABLE register (interrupt sources) */
+	bool sleep;					/*!< true to leave the sensor in sleep mode */
+} mpu6050_config_t;
+
+/**
+ * @brief Sensor instance
+ */
+typedef struct {
+	uint8_t devAddr;			/*!< I2C address */
+	i2c_shadow_t shadow;		/*!< Register shadow copy */
+} mpu6050_t;
+
+/**
+ * @brief Sensors sampled together
+ */
+typedef struct {
+	uint8_t count;										/*!< Number of sensors */
+	mpu6050_t *devices[MPU6050_GROUP_SIZE];				/*!< Sensors */
+	mpu6050_stream_t streams[MPU6050_GROUP_SIZE];		/*!< FIFO stream of each sensor */
+	i2c_trans_t trans[MPU6050_GROUP_SIZE];				/*!< Queued register reads */
+	uint8_t data[MPU6050_GROUP_SIZE][14];				/*!< Register read buffers */
+	uint32_t dropped;									/*!< Samples without a match in the other streams */
+} mpu6050_group_t;
+
+/**
+ * @brief DMP FIFO packet (MotionApps 2.0 layout)
+ */
+typedef struct {
+	int32_t quat[4];			/*!< Orientation quaternion W, X, Y, Z (Q30: 1.0 = 1 << 30) */
+	int16_t gravity[3];			/*!< Gravity direction X, Y, Z, from the quaternion (Q14: 1 g = 16384) */
+	int16_t gyro[3];			/*!< Gyroscope X, Y, Z */
+	int16_t accel[3];			/*!< Accelerometer X, Y, Z */
+} mpu6050_dmp_packet_t;
 
 /*==================[external data declaration]==============================*/
 
@@ -422,6 +522,11 @@
  */
 void MPU6050_Address(uint8_t address);
 
+/** Read consecutive registers in a single burst.
+ * @param reg First register
+ * @param data Buffer for the values read
+ * @param len Number of registers
+ */
 void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len);
 
 /** Power on and prepare for general usage.
@@ -433,6 +538,32 @@ void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len);
  */
 void MPU6050_initialize();
 
+/** Start a configuration block.
+ * Configuration registers are kept in a shadow copy (see I2C_shadowInit()), so
+ * setters don't read the device. Until MPU6050_commitConfig() setters only change
+ * the copy; changed registers are then written in bursts of consecutive registers.
+ * Setters of volatile registers (power management, resets, FIFO, DMP memory) are
+ * written at once, after the pending changes.
+ */
+void MPU6050_beginConfig();
+
+/** Write the configuration changed since MPU6050_beginConfig().
+ * @return Status of operation (true = success, also when the sensor has no shadow copy)
+ */
+bool MPU6050_commitConfig();
+
+/** Set the whole configuration of the sensor.
+ * The configuration is turned into register values. PWR_MGMT_1 is written first, the
+ * rest through the shadow copy, so only changed registers are sent, each run of
+ * consecutive ones in one burst: SMPLRT_DIV to ACCEL_CONFIG, FIFO_EN and INT_PIN_CFG
+ * to INT_ENABLE. SMPLRT_DIV to INT_ENABLE are then read back in a single burst
+ * (refreshing the shadow copy) and the written registers compared. The burst also
+ * reads I2C_MST_STATUS, which clears its flags (auxiliary I2C master only).
+ * @param config Configuration (see MPU6050_CONFIG_DEFAULT)
+ * @return true if the read back registers match the configuration
+ */
+bool MPU6050_configure(const mpu6050_config_t *config);
+
 /** Verify the I2C connection.
  * Make sure the device is connected and responds as expected.
  * @return True if connection is valid, false otherwise
@@ -2648,6 +2779,305 @@ void MPU6050_setFIFOByte(uint8_t data);
  */
 void MPU6050_getFIFOBytes(uint8_t *data, uint8_t length);
 
+/** Start streaming samples through the FIFO.
+ * Sets the sample rate, DLPF and FIFO contents, and enables an empty FIFO. Samples are
+ * then taken by the sensor at the sample rate, and moved to the ring buffer by
+ * MPU6050_streamRead(), which must be called before the FIFO fills (1024 bytes: 85
+ * samples of accelerometer and gyroscope, 85 ms at 1 kHz).
+ * @param stream Streaming state
+ * @param samples Ring buffer memory (must be kept while streaming)
+ * @param size Ring buffer size in samples (at least 2)
+ * @param contents MPU6050_STREAM_ACCEL, MPU6050_STREAM_GYRO or both
+ * @param dlpf Digital low pass filter (see MPU6050_setDLPFMode())
+ * @param rate Sample rate divider (see MPU6050_setRate()): 1 kHz / (1 + rate), 8 kHz / (1 + rate) without DLPF
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_streamStart(mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate);
+
+/** Move the samples in the FIFO to the ring buffer.
+ * The FIFO count is read once and the samples in bursts of up to 255 bytes. Samples
+ * are timestamped one sample period apart. The newest one was taken within the last
+ * period before the count read: the timestamps follow that estimate smoothly (a
+ * quarter of the difference on each read), so they are steady and follow the
+ * sensor clock. Samples that don't fit in the ring buffer are left in the FIFO.
+ * A full FIFO means samples were lost: it is emptied and overflows is incremented.
+ * When a read fails the samples not moved are left in the FIFO and timestamps don't
+ * advance, so the next call takes them.
+ * @param stream Streaming state
+ * @return Number of samples moved
+ */
+uint16_t MPU6050_streamRead(mpu6050_stream_t *stream);
+
+/** Take the oldest sample from the ring buffer.
+ * Can be called from a task other than the one calling MPU6050_streamRead().
+ * @param stream Streaming state
+ * @param sample Sample taken
+ * @return true if there was a sample
+ */
+bool MPU6050_streamGet(mpu6050_stream_t *stream, mpu6050_sample_t *sample);
+
+/** Stop streaming samples through the FIFO.
+ */
+void MPU6050_streamStop();
+
+/** Power on and prepare a sensor instance for general usage.
+ * Sets MPU6050_CONFIG_DEFAULT (see MPU6050_configure()), with its own register shadow copy.
+ * MPU6050_initialize() uses this on an internal instance for the functions without
+ * a sensor parameter.
+ * @param dev Sensor instance (must be kept while in use)
+ * @param address I2C address (MPU6050_ADDRESS_AD0_LOW or MPU6050_ADDRESS_AD0_HIGH)
+ * @return true if the configuration was verified
+ */
+bool MPU6050_deviceInit(mpu6050_t *dev, uint8_t address);
+
+/** Set the whole configuration of a sensor instance (see MPU6050_configure()).
+ * @param dev Sensor instance
+ * @param config Configuration
+ * @return true if the read back registers match the configuration
+ */
+bool MPU6050_deviceConfigure(mpu6050_t *dev, const mpu6050_config_t *config);
+
+/** Read consecutive registers of a sensor instance in a single burst.
+ * @param dev Sensor instance
+ * @param reg First register
+ * @param data Buffer for the values read
+ * @param len Number of registers
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_deviceRead(const mpu6050_t *dev, uint8_t reg, uint8_t *data, uint8_t len);
+
+/** Read accelerometer and gyroscope of a sensor instance in a single burst.
+ * @param dev Sensor instance
+ * @param sample Sample read, timestamped with the time of the read (unchanged if the read fails)
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_deviceGetMotion6(const mpu6050_t *dev, mpu6050_sample_t *sample);
+
+/** Start streaming samples of a sensor instance through its FIFO.
+ * Same as MPU6050_streamStart(). The stream is then read with MPU6050_streamRead()
+ * and MPU6050_streamGet().
+ * @param dev Sensor instance
+ * @param stream Streaming state
+ * @param samples Ring buffer memory (must be kept while streaming)
+ * @param size Ring buffer size in samples (at least 2)
+ * @param contents MPU6050_STREAM_ACCEL, MPU6050_STREAM_GYRO or both
+ * @param dlpf Digital low pass filter (see MPU6050_setDLPFMode())
+ * @param rate Sample rate divider (see MPU6050_setRate())
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_deviceStreamStart(mpu6050_t *dev, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate);
+
+/** Stop streaming samples of a sensor instance through its FIFO.
+ * @param dev Sensor instance
+ */
+void MPU6050_deviceStreamStop(mpu6050_t *dev);
+
+/** Start sampling a sensor instance on its data ready interrupt.
+ * Same as MPU6050_dataReadyStart(). There is one data ready task and interrupt: starting
+ * another sensor replaces the stream of the previous one, and needs its INT pin wired to
+ * the same GPIO.
+ * @param dev Sensor instance
+ * @param stream Streaming state
+ * @param samples Ring buffer memory (must be kept while sampling)
+ * @param size Ring buffer size in samples (at least 2)
+ * @param dlpf Digital low pass filter (see MPU6050_setDLPFMode())
+ * @param rate Sample rate divider (see MPU6050_setRate())
+ * @param int_pin GPIO connected to the INT pin
+ * @param priority Priority of the task that reads the samples
+ * @return Status of operation (true = success, false for another int_pin than the first time)
+ */
+bool MPU6050_deviceDataReadyStart(mpu6050_t *dev, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t dlpf, uint8_t rate, gpio_t int_pin, uint8_t priority);
+
+/** Stop sampling a sensor instance on its data ready interrupt.
+ * @param dev Sensor instance
+ */
+void MPU6050_deviceDataReadyStop(mpu6050_t *dev);
+
+/** Prepare a group of sensors sampled together.
+ * @param group Group state
+ * @param devices Sensor instances, already initialized (MPU6050_deviceInit())
+ * @param count Number of sensors (1 to MPU6050_GROUP_SIZE)
+ * @param priority Priority of the register reads in the I2C queue (see I2C_queueTransfer())
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_groupInit(mpu6050_group_t *group, mpu6050_t *const devices[], uint8_t count, uint8_t priority);
+
+/** Read accelerometer and gyroscope of all the sensors of a group.
+ * The burst reads of all sensors are queued together (I2C_queueTransfers()), so they
+ * are made back to back. Every sample gets the same timestamp, the time they were
+ * queued. The I2C queue task must be running (I2C_queueInit()). Waits for the reads.
+ * @param group Group state
+ * @param samples One sample for each sensor, in group order
+ * @return Status of operation (true = success, false if a read failed or the I2C task is not running)
+ */
+bool MPU6050_groupSample(mpu6050_group_t *group, mpu6050_sample_t samples[]);
+
+/** Start streaming samples of all the sensors of a group through their FIFOs.
+ * All sensors are configured first and their FIFOs then enabled one right after the other.
+ * @param group Group state
+ * @param samples Ring buffer memory of each sensor, in group order (must be kept while streaming)
+ * @param size Ring buffer size in samples of each sensor (at least 2)
+ * @param contents MPU6050_STREAM_ACCEL, MPU6050_STREAM_GYRO or both
+ * @param dlpf Digital low pass filter (see MPU6050_setDLPFMode())
+ * @param rate Sample rate divider (see MPU6050_setRate())
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_groupStreamStart(mpu6050_group_t *group, mpu6050_sample_t *const samples[], uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate);
+
+/** Move the samples in the FIFOs of a group to their ring buffers.
+ * The FIFO counts of all sensors are read one after the other, and then one burst
+ * of each sensor in turn, so no FIFO waits for the whole reading of another.
+ * @param group Group state
+ * @return Number of samples moved (all sensors)
+ */
+uint16_t MPU6050_groupStreamRead(mpu6050_group_t *group);
+
+/** Take the oldest set of matching samples of a group, one for each sensor.
+ * Sensors sample with their own clocks, so their samples are matched by timestamp:
+ * a sample more than 3/4 of a sample period older than the oldest of another sensor
+ * has no match, it is dropped (dropped is incremented). The margin over half a period
+ * keeps the pairing while the clocks drift, instead of dropping samples of each sensor
+ * in turn on timestamp estimate noise: one sample is dropped each time the clocks
+ * drift a whole period apart. Every sample of the set gets the average timestamp of
+ * the set.
+ * @param group Group state
+ * @param samples One sample for each sensor, in group order
+ * @return true if every sensor had a matching sample
+ */
+bool MPU6050_groupStreamGet(mpu6050_group_t *group, mpu6050_sample_t samples[]);
+
+/** Stop streaming samples of all the sensors of a group.
+ * @param group Group state
+ */
+void MPU6050_groupStreamStop(mpu6050_group_t *group);
+
+/** Start sampling on the data ready interrupt.
+ * The INT pin of the sensor is connected to a GPIO. On each sample the interrupt keeps
+ * the time (esp_timer_get_time()) and wakes up a task, which reads accelerometer and
+ * gyroscope in a single burst and puts them in the ring buffer with that time.
+ * Samples are taken with MPU6050_streamGet(). Interrupts missed because the task
+ * didn't run in time, failed reads, and samples that don't fit in the ring buffer,
+ * increment overflows. Calling it again (i.e. to change the sample rate) reuses the
+ * task and the interrupt, so int_pin must be the same as the first time.
+ * @param stream Streaming state
+ * @param samples Ring buffer memory (must be kept while sampling)
+ * @param size Ring buffer size in samples (at least 2)
+ * @param dlpf Digital low pass filter (see MPU6050_setDLPFMode())
+ * @param rate Sample rate divider (see MPU6050_setRate())
+ * @param int_pin GPIO connected to the INT pin
+ * @param priority Priority of the task that reads the samples
+ * @return Status of operation (true = success, false for another int_pin than the first time)
+ */
+bool MPU6050_dataReadyStart(mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t dlpf, uint8_t rate, gpio_t int_pin, uint8_t priority);
+
+/** Stop sampling on the data ready interrupt.
+ */
+void MPU6050_dataReadyStop();
+
+// BANK_SEL, MEM_START_ADDR and MEM_R_W registers
+/** Select a DMP memory bank.
+ * @param bank Memory bank (0 to MPU6050_DMP_MEMORY_BANKS - 1)
+ * @param prefetchEnabled true to enable prefetch
+ * @param userBank true to select the user bank
+ * @see MPU6050_RA_BANK_SEL
+ */
+void MPU6050_setMemoryBank(uint8_t bank, bool prefetchEnabled, bool userBank);
+
+/** Set the address of the next DMP memory access in the selected bank.
+ * @param address Memory address
+ * @see MPU6050_RA_MEM_START_ADDR
+ */
+void MPU6050_setMemoryStartAddress(uint8_t address);
+
+/** Read a byte of DMP memory (selected bank and address, address incremented).
+ * @return Byte read
+ * @see MPU6050_RA_MEM_R_W
+ */
+uint8_t MPU6050_readMemoryByte();
+
+/** Write a byte of DMP memory (selected bank and address, address incremented).
+ * @param data Byte to write
+ * @see MPU6050_RA_MEM_R_W
+ */
+void MPU6050_writeMemoryByte(uint8_t data);
+
+/** Read a block of DMP memory, which may span several banks.
+ * @param data Buffer for the data read
+ * @param dataSize Number of bytes
+ * @param bank First memory bank
+ * @param address First memory address in the bank
+ * @return Status of operation (true = success, false = block doesn't fit or a read failed)
+ */
+bool MPU6050_readMemoryBlock(uint8_t *data, uint16_t dataSize, uint8_t bank, uint8_t address);
+
+/** Write a block of DMP memory, which may span several banks.
+ * Data is written in chunks of MPU6050_DMP_MEMORY_CHUNK_SIZE bytes, each read back when verifying.
+ * @param data Data to write
+ * @param dataSize Number of bytes
+ * @param bank First memory bank
+ * @param address First memory address in the bank
+ * @param verify true to read back and compare each chunk
+ * @return Status of operation (true = success, false = block doesn't fit or verification failed)
+ */
+bool MPU6050_writeMemoryBlock(const uint8_t *data, uint16_t dataSize, uint8_t bank, uint8_t address, bool verify);
+
+// USER_CTRL, DMP_CFG_1 and DMP_CFG_2 registers
+/** Get DMP enabled status.
+ * @return Current DMP enabled status
+ * @see MPU6050_RA_USER_CTRL
+ * @see MPU6050_USERCTRL_DMP_EN_BIT
+ */
+bool MPU6050_getDMPEnabled();
+
+/** Set DMP enabled status.
+ * @param enabled New DMP enabled status
+ * @see MPU6050_RA_USER_CTRL
+ * @see MPU6050_USERCTRL_DMP_EN_BIT
+ */
+void MPU6050_setDMPEnabled(bool enabled);
+
+/** Reset the DMP (bit cleared by the device).
+ * @see MPU6050_RA_USER_CTRL
+ * @see MPU6050_USERCTRL_DMP_RESET_BIT
+ */
+void MPU6050_resetDMP();
+
+/** Set the DMP program start address.
+ * @param address Program start address
+ * @see MPU6050_RA_DMP_CFG_1
+ * @see MPU6050_RA_DMP_CFG_2
+ */
+void MPU6050_setDMPProgramStart(uint16_t address);
+
+/** Set DMP interrupt enabled status.
+ * @param enabled New DMP interrupt enabled status
+ * @see MPU6050_RA_INT_ENABLE
+ * @see MPU6050_INTERRUPT_DMP_INT_BIT
+ */
+void MPU6050_setIntDMPEnabled(bool enabled);
+
+/** Upload the DMP firmware and set its program start address.
+ * The firmware image (i.e. InvenSense MotionApps 2.0, 1929 bytes, start 0x0400) is
+ * given by the caller, it is not part of this driver. The DMP is stopped and reset,
+ * and the image written from bank 0, address 0, and verified. Firmware configuration
+ * writes, if any, can then be made with MPU6050_writeMemoryBlock(). The DMP is
+ * started with MPU6050_setDMPEnabled(), with the FIFO enabled (MPU6050_setFIFOEnabled()).
+ * @param firmware Firmware image
+ * @param size Image size in bytes (up to MPU6050_DMP_MEMORY_BANKS * MPU6050_DMP_MEMORY_BANK_SIZE)
+ * @param start Program start address
+ * @return Status of operation (true = success, false = image too big or verification failed)
+ */
+bool MPU6050_dmpLoadFirmware(const uint8_t *firmware, uint16_t size, uint16_t start);
+
+/** Take the oldest DMP packet from the FIFO.
+ * Reads the FIFO count and, if there is a whole packet, the packet in one burst. A full
+ * FIFO has lost data and can't be parsed: it is reset and no packet is returned. So is
+ * it after a failed packet read, since part of the packet may have been taken.
+ * @param packet Packet read: quaternion, gravity computed from it (integer only), gyroscope and accelerometer
+ * @return true if there was a packet
+ */
+bool MPU6050_dmpGetPacket(mpu6050_dmp_packet_t *packet);
+
 // WHO_AM_I register
 /** Get Device ID.
  * This register is used to verify the identity of the device (0b110100, 0x34).
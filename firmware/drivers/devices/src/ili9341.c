@@ -12,10 +12,15 @@
 /*==================[inclusions]=============================================*/
 #include "ili9341.h"
 #include "fonts.h"
+#include "img565.h"
 #include "spi_mcu.h"
 #include "gpio_mcu.h"
 #include "delay_mcu.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include <string.h>
 /*==================[macros and definitions]=================================*/
+#undef NULL
 #define NULL 0
 
 #define SPI_BR 20000000				/*!< Frequency of sck for SPI communication */
@@ -23,6 +28,7 @@
 #define MSK_BIT16 0x8000			/*!< 16th bit mask */
 #define MSK_BIT8 0x80				/*!< 8th bit mask */
 #define MAX_VALUE_SIZE 256			/*!< Maximum length of a data array to prevent excessive use of memory */
+#define MAX_LINE_CHARS 64			/*!< Maximum number of characters sent in a single address window */
 #define LEFT -1						/*!< Horizontal grow direction */
 #define RIGHT 1						/*!< Horizontal grow direction */
 #define DOWN 1						/*!< Vertical grow direction */
@@ -40,7 +46,9 @@
 #define COLUMN_ADDR_SET		0x2A 	/*!< Define columns of frame memory where MCU can access */
 #define PAGE_ADDR_SET		0x2B 	/*!< Define rows of frame memory where MCU can access */
 #define MEM_WRITE			0x2C 	/*!< Transfer data from MCU to frame memory */
+#define VERT_SCROLL_DEF		0x33 	/*!< Defines the vertical scrolling area of the display */
 #define MEM_ACC_CTRL		0x36 	/*!< Defines read/write scanning direction of frame memory */
+#define VERT_SCROLL_ADDR	0x37 	/*!< Defines which line of frame memory is written as first line of the scrolling area */
 #define PIXEL_FORMAT_SET	0x3A 	/*!< Sets the pixel format for the RGB image data used by the interface */
 #define WRITE_DISP_BRIGHT	0x51 	/*!< Adjust the brightness value of the display */
 #define WRITE_CTRL_DISP		0x53 	/*!< Control display brightness */
@@ -64,6 +72,9 @@
 
 #define HighByte(x) x >> 8			/*!< High byte of a 16 bits data */
 #define LowByte(x) x & 0xFF			/*!< Low byte of a 16 bits data */
+
+#define ToFixed(x) ((int64_t)(x) * 0x10000)				/*!< Integer to 16.16 fixed point (64 bits: any int16_t difference fits) */
+#define FromFixed(x) ((int16_t)(((x) + 0x8000) >> 16))	/*!< 16.16 fixed point to nearest integer */
 /*==================[typedef]================================================*/
 /**
  * @brief  Structure with LCD orientation properties
@@ -82,6 +93,76 @@ typedef struct {
     uint32_t databytes; 	/*!< Number of bytes of data to transmit */
     uint8_t *data;			/*!< Pointer to data or parameters array */
 } lcd_cmd_t;
+
+/**
+ * @brief Last transfer of a drawing, held back so that only the last one calls the
+ * transfer done callback
+ */
+typedef struct {
+	uint16_t x0, y0, x1, y1;	/*!< Address window, sent with the pixels (span only) */
+	uint32_t size;			/*!< Number of bytes, 0 if nothing is pending */
+	uint8_t index;			/*!< Pixel buffer */
+	bool span;				/*!< true: window and pixels in one transfer list, false: queued buffer */
+} pending_t;
+
+/**
+ * @brief LCD session: SPI device and control lines, set up once by ILI9341Init()
+ */
+typedef struct {
+	spi_dev_t spi;			/*!< uC SPI device */
+	gpio_t dc;				/*!< uC GPIO used as data/command */
+	gpio_t rst;				/*!< uC GPIO used as hardware reset */
+	uint8_t *buffer[2];		/*!< DMA pixel buffers */
+	uint32_t ticket[2];		/*!< Number of queued transfers when each buffer was last queued */
+	uint32_t queued;		/*!< Number of pixel transfers queued since init */
+	uint8_t next;			/*!< Buffer to be returned by next ILI9341GetPixelBuffer() */
+	uint8_t drawing;		/*!< Nesting level of drawing functions (i.e. lines of a rectangle) */
+	pending_t pending;		/*!< Last transfer of the current drawing */
+	void (*done_func_p)(void*);		/*!< Transfer done callback */
+	void *done_param_p;				/*!< Transfer done callback parameter */
+} ili9341_session_t;
+
+/**
+ * @brief Pixels written in sequence to the DMA pixel buffers
+ */
+typedef struct {
+	uint8_t *buffer;		/*!< Current pixel buffer */
+	uint32_t size;			/*!< Current pixel buffer size */
+	uint32_t used;			/*!< Bytes written to current pixel buffer */
+} pixel_stream_t;
+
+/**
+ * @brief Character expanded to RGB565 (LCD byte order), rows one after another
+ */
+typedef struct {
+	Font_t *font;			/*!< Font */
+	char data;				/*!< Character */
+	uint16_t foreground;	/*!< Color for char */
+	uint16_t background;	/*!< Color for char background */
+	uint32_t offset;		/*!< Position in cache pool */
+	uint32_t size;			/*!< Size in bytes, 0 if the entry is free */
+	uint32_t last_use;		/*!< Drawing where it was last used */
+} glyph_t;
+
+/**
+ * @brief Glyph cache: entries are kept one after another at the beginning of the pool
+ */
+typedef struct {
+	uint8_t *pool;			/*!< Expanded characters */
+	uint32_t used;			/*!< Bytes used of the pool */
+	uint32_t clock;			/*!< Drawings count, used as LRU time */
+	glyph_t glyph[ILI9341_GLYPH_CACHE_ENTRIES];		/*!< Entries */
+} glyph_cache_t;
+
+/**
+ * @brief Polygon edge, walked one row at a time
+ */
+typedef struct {
+	int64_t x;				/*!< X coordinate at current row (16.16 fixed point) */
+	int64_t step;			/*!< X increment per row (16.16 fixed point, up to 65535 pixels) */
+	int16_t y_end;			/*!< Row of the end vertex */
+	uint8_t end;			/*!< Index of the end vertex */
+} edge_t;
 /*==================[internal data declaration]==============================*/
 
 /*==================[internal functions declaration]=========================*/
@@ -94,14 +175,19 @@ typedef struct {
 void WriteLCD(lcd_cmd_t * data);
 
 /**
- * @brief  		Define an area of frame memory where MCU can access
+ * @brief  		Define an area of frame memory where MCU can access and start writing it
+ * @note		Column and row addresses, memory write command and pixels are sent as one
+ * 				SPI transfer list
  * @param[in]  	x1: Start column
  * @param[in]  	y1: Start row
  * @param[in]  	x2: End column
  * @param[in]  	y2: End row
+ * @param[in]  	pixels: Pixels to write (NULL to send them later)
+ * @param[in]  	size: Number of pixel bytes (up to ILI9341_BUFFER_SIZE)
+ * @param[in]  	notify: true to call the transfer done callback when it has been sent
  * @retval 		None
  */
-void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+void WriteWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t *pixels, uint32_t size, bool notify);
 
 /**
  * @brief  		Fill an srea of LCD with a determined color
@@ -114,6 +200,165 @@ void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
  */
 void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
 
+/**
+ * @brief  		Fill an horizontal or vertical run (or any area) clipped to the LCD
+ * @note		Areas completely outside the LCD produce no SPI traffic
+ * @param[in]  	x1: Start column
+ * @param[in]  	y1: Start row
+ * @param[in]  	x2: End column
+ * @param[in]  	y2: End row
+ * @param[in]	color: color
+ * @retval 		None
+ */
+void FillSpan(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief  		Draw a line as horizontal (or vertical) runs of pixels
+ * @param[in]  	x0: X coordinate of starting point
+ * @param[in]  	y0: Y coordinate of starting point
+ * @param[in]  	x1: X coordinate of ending point
+ * @param[in]  	y1: Y coordinate of ending point
+ * @param[in]  	color: Line color
+ * @retval 		None
+ */
+void Line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief  		Draw one run of midpoint circle points in the 8 octants
+ * @param[in]  	x0: X coordinate of center
+ * @param[in]  	y0: Y coordinate of center
+ * @param[in]  	x_start: First x of the run (relative to center)
+ * @param[in]  	x_end: Last x of the run (relative to center)
+ * @param[in]  	y: y of the run (relative to center)
+ * @param[in]  	color: Circle color
+ * @retval 		None
+ */
+void CircleRuns(int16_t x0, int16_t y0, int16_t x_start, int16_t x_end, int16_t y, uint16_t color);
+
+/**
+ * @brief  		Move a polygon edge to the next side of the outline
+ * @param[in]  	edge: Edge, starting at its current end vertex
+ * @param[in]  	points: Polygon vertices
+ * @param[in]  	count: Number of vertices
+ * @param[in]  	direction: 1 to walk the outline forward, -1 backward
+ * @param[in]  	y: Current row
+ * @retval 		None
+ */
+void EdgeNext(edge_t *edge, const ili9341_point_t *points, uint8_t count, int8_t direction, int16_t y);
+
+/**
+ * @brief  		Queue one of the DMA pixel buffers to be sent to the LCD
+ * @param[in]  	index: Buffer number (0 or 1)
+ * @param[in]  	size: Number of bytes to send
+ * @param[in]	last: true on the last buffer of a drawing
+ * @retval 		None
+ */
+void QueueBuffer(uint8_t index, uint32_t size, bool last);
+
+/**
+ * @brief  		Send the transfer held back by the current drawing, if any
+ * @note		Called before any other transfer to the LCD, so the order is kept
+ * @param[in]	notify: true to call the transfer done callback when it has been sent
+ * @retval 		None
+ */
+void PendingSend(bool notify);
+
+/**
+ * @brief  		Start a drawing function
+ * @note		Until the outermost drawing ends, the last transfer of each part is held back
+ * @retval 		None
+ */
+void DrawBegin(void);
+
+/**
+ * @brief  		End a drawing function: the outermost one sends its last transfer, which
+ * 				calls the transfer done callback from the SPI interrupt
+ * @retval 		None
+ */
+void DrawEnd(void);
+
+/**
+ * @brief  		Start writing pixels to the DMA pixel buffers
+ * @param[in]  	stream: Pixel stream
+ * @retval 		None
+ */
+void StreamBegin(pixel_stream_t *stream);
+
+/**
+ * @brief  		Write pixel data, queueing each pixel buffer when it gets full
+ * @param[in]  	stream: Pixel stream
+ * @param[in]  	data: Pixels (LCD byte order)
+ * @param[in]  	size: Number of bytes
+ * @retval 		None
+ */
+void StreamBytes(pixel_stream_t *stream, const uint8_t *data, uint32_t size);
+
+/**
+ * @brief  		Write a single pixel
+ * @param[in]  	stream: Pixel stream
+ * @param[in]  	color: Pixel color
+ * @retval 		None
+ */
+void StreamColor(pixel_stream_t *stream, uint16_t color);
+
+/**
+ * @brief  		Queue the last pixel buffer
+ * @param[in]  	stream: Pixel stream
+ * @retval 		None
+ */
+void StreamEnd(pixel_stream_t *stream);
+
+/**
+ * @brief  		Write a row of a character, from the glyph cache or decoding the font bitmap
+ * @param[in]  	stream: Pixel stream
+ * @param[in]  	glyph: Cached character, NULL if it is not in cache
+ * @param[in]  	data: Character
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	row: Row number
+ * @param[in]  	foreground: Color for char
+ * @param[in]  	background: Color for char background
+ * @retval 		None
+ */
+void StreamGlyphRow(pixel_stream_t *stream, glyph_t *glyph, char data, Font_t* font, uint16_t row, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Get a character from the glyph cache, expanding it if it is not there
+ * @note		Characters used in the current drawing are never discarded
+ * @param[in]  	data: Character
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for char
+ * @param[in]  	background: Color for char background
+ * @retval 		Cached character, NULL if there is no room for it
+ */
+glyph_t* GlyphGet(char data, Font_t* font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Discard a character from the glyph cache and compact the pool
+ * @param[in]  	glyph: Cached character
+ * @retval 		None
+ */
+void GlyphEvict(glyph_t *glyph);
+
+/**
+ * @brief  		Draw a line of characters with a single address window
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in]  	str: Pointer to first character
+ * @param[in]  	count: Number of characters (up to MAX_LINE_CHARS)
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for chars
+ * @param[in]  	background: Color for background and gaps between chars
+ * @retval 		None
+ */
+void DrawTextLine(uint16_t x, uint16_t y, char* str, uint8_t count, Font_t *font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		SPI callback, called when a drawing has been sent
+ * @param[in]  	param: Not used
+ * @retval 		None
+ */
+void TransferDone(void *param);
+
 /*==================[internal data definition]===============================*/
 /**
  * @brief Initial LCD configuration parameters
@@ -179,11 +424,13 @@ spi_mcu_config_t spi_conf = {
 	.clk_mode = MODE0, 
 	.bitrate = SPI_BR, 
 	.transfer_mode = SPI_POLLING, 
-	.func_p = NULL,
-	.param_p = NULL };
+	.func_p = TransferDone,
+	.param_p = NULL,
+	.dc_en = true };
 
-static spi_dev_t ili9341_spi;				/*!< uC SPI port */
-static gpio_t ili9341_dc, ili9341_rst;		/*!< uC GPIO ports to use as CS, DC and RST */
+static ili9341_session_t lcd;				/*!< LCD session */
+
+static glyph_cache_t glyph_cache;			/*!< Characters expanded to RGB565 */
 
 static orientation_properties_t lcd_orientation = {
 		ILI9341_WIDTH,
@@ -194,23 +441,23 @@ static orientation_properties_t lcd_orientation = {
 /*==================[internal functions definition]==========================*/
 
 void WriteLCD(lcd_cmd_t * data){
-	SpiInit(&spi_conf);
+	PendingSend(false);
 	/* If command is NULL don't send command */
 	if (data->cmd != NULL){
-		/* Send command */
-		GPIOOff(ili9341_dc);
-		SpiWrite(ili9341_spi, &data->cmd, 1);
+		/* Send command and its parameters together, DC is switched by the SPI driver */
+		SpiWriteCommand(lcd.spi, data->cmd, data->data, data->databytes);
 	}
-	/* If there are parameters or data to send */
-	if (data->databytes != NULL){
-		/* Send parameters or data */
-		GPIOOn(ili9341_dc);
-		SpiWrite(ili9341_spi, data->data, data->databytes);
+	/* If there are only parameters or data to send */
+	else if (data->databytes != NULL){
+		SpiWrite(lcd.spi, data->data, data->databytes);
 	}
 }
 
-void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
-	static uint16_t aux;
+void WriteWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t *pixels, uint32_t size, bool notify){
+	uint16_t aux;
+	uint8_t commands[] = {COLUMN_ADDR_SET, PAGE_ADDR_SET, MEM_WRITE};
+
+	PendingSend(false);
 	/* The lower column must be send first */
 	if (x0 > x1){
 		aux = x0;
@@ -224,18 +471,26 @@ void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
 		y1 = aux;
 	}
 	uint8_t columns[] = {HighByte(x0), LowByte(x0), HighByte(x1), LowByte(x1)};
-	lcd_cmd_t lcd_columns = {COLUMN_ADDR_SET, 4, columns};
 	uint8_t rows[] = {HighByte(y0), LowByte(y0), HighByte(y1), LowByte(y1)};
-	lcd_cmd_t lcd_rows = {PAGE_ADDR_SET, 4, rows};
-	WriteLCD(&lcd_columns);
-	WriteLCD(&lcd_rows);
+	spi_segment_t segments[] = {
+		{.tx_buffer = &commands[0], .size = 1, .command = true},
+		{.tx_buffer = columns, .size = 4},
+		{.tx_buffer = &commands[1], .size = 1, .command = true},
+		{.tx_buffer = rows, .size = 4},
+		{.tx_buffer = &commands[2], .size = 1, .command = true},
+		{.tx_buffer = pixels, .size = size},
+	};
+	uint8_t count = (size > 0) ? 6 : 5;
+	/* The callback is called from the interrupt that ends the last segment */
+	segments[count - 1].notify = notify;
+	SpiTransferList(lcd.spi, segments, count);
 }
 
 void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
-	static uint16_t i;
-	static int32_t bytes_count;
-	static int16_t x_dist, y_dist;
-	static uint8_t pixel[MAX_VALUE_SIZE];
+	uint32_t i, size, chunk;
+	uint32_t bytes_count;
+	int16_t x_dist, y_dist;
+	uint8_t * pixel;
 
 	x_dist = x1 - x0;
 	y_dist = y1 - y0;
@@ -247,41 +502,384 @@ void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
 	}
 	/* Number of bytes to write. We have to write 2 bytes/pixel (16bits color) */
 	bytes_count = (x_dist + 1) * (y_dist + 1) * 2;
-	/* Define area to fill */
-	SetCursorPosition(x0, y0, x1, y1);
 
-	for (i = 0; i < MAX_VALUE_SIZE; i += 2){
+	/* All the area has the same color, so a single buffer is filled and queued as many times as needed */
+	pixel = ILI9341GetPixelBuffer(&size);
+	chunk = (bytes_count < size) ? bytes_count : size;
+	for (i = 0; i < chunk; i += 2){
 		pixel[i] = HighByte(color);
 		pixel[i + 1] = LowByte(color);
 	}
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
+	/* Small areas (spans) go with the window in a single transfer list, sent when the
+	 * next transfer starts or the drawing ends */
+	if (bytes_count == chunk){
+		lcd.pending = (pending_t){x0, y0, x1, y1, bytes_count, lcd.next, true};
+		return;
+	}
+	/* Define area to fill and start writing LCD memory */
+	ILI9341SetWindow(x0, y0, x1, y1);
+	while(bytes_count > chunk){
+		QueueBuffer(lcd.next, chunk, false);
+		bytes_count -= chunk;
+	}
+	QueueBuffer(lcd.next, bytes_count, true);
+	lcd.next ^= 1;
+}
+
+void FillSpan(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	int16_t aux;
+
+	if (x0 > x1){
+		aux = x0;
+		x0 = x1;
+		x1 = aux;
+	}
+	if (y0 > y1){
+		aux = y0;
+		y0 = y1;
+		y1 = aux;
+	}
+	/* Completely outside the LCD */
+	if (x1 < 0 || y1 < 0 || x0 >= lcd_orientation.width || y0 >= lcd_orientation.height){
+		return;
+	}
+	if (x0 < 0){
+		x0 = 0;
+	}
+	if (y0 < 0){
+		y0 = 0;
+	}
+	if (x1 >= lcd_orientation.width){
+		x1 = lcd_orientation.width - 1;
+	}
+	if (y1 >= lcd_orientation.height){
+		y1 = lcd_orientation.height - 1;
+	}
+	Fill(x0, y0, x1, y1, color);
+}
+
+void Line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	int16_t x_dist, y_dist, x_grow, y_grow, error, error_2;
+	int16_t run_x, run_y;
+	bool x_step, y_step, x_major, run_end;
+
+	/* Calculate x y distances and determine grow direction */
+	x_dist = (x1 > x0) ? x1 - x0 : x0 - x1;
+	y_dist = (y1 > y0) ? y1 - y0 : y0 - y1;
+	x_grow = (x0 > x1) ? LEFT : RIGHT;
+	y_grow = (y0 > y1) ? UP : DOWN;
+	/* Mostly horizontal lines are made of horizontal runs, mostly vertical ones of vertical runs */
+	x_major = (x_dist >= y_dist);
+
+	error = x_dist - y_dist;
+	run_x = x0;
+	run_y = y0;
+	while (1){
+		/* Loop ends when start point reaches end point */
+		if (x0 == x1 && y0 == y1){
+			FillSpan(run_x, run_y, x0, y0, color);
+			break;
+		}
+		error_2 = 2 * error;
+		x_step = (error_2 > -y_dist);
+		y_step = (error_2 < x_dist);
+		/* Run ends when the line moves in its minor direction */
+		run_end = x_major ? y_step : x_step;
+		if (run_end){
+			FillSpan(run_x, run_y, x0, y0, color);
+		}
+		/* Determine if line must grow in x direction */
+		if (x_step){
+			error -= y_dist;
+			x0 += x_grow;	/* Move start point */
+		}
+		/* Determine if line must grow in y direction */
+		if (y_step){
+			error += x_dist;
+			y0 += y_grow;	/* Move start point */
+		}
+		if (run_end){
+			run_x = x0;
+			run_y = y0;
+		}
+	}
+}
+
+void CircleRuns(int16_t x0, int16_t y0, int16_t x_start, int16_t x_end, int16_t y, uint16_t color){
+	if (x_start == 0){
+		/* Run crosses the axis: left and right halves are a single run */
+		FillSpan(x0 - x_end, y0 + y, x0 + x_end, y0 + y, color);
+		FillSpan(x0 - x_end, y0 - y, x0 + x_end, y0 - y, color);
+		FillSpan(x0 + y, y0 - x_end, x0 + y, y0 + x_end, color);
+		FillSpan(x0 - y, y0 - x_end, x0 - y, y0 + x_end, color);
+	}
+	else{
+		/* Horizontal runs on top and bottom octants */
+		FillSpan(x0 + x_start, y0 + y, x0 + x_end, y0 + y, color);
+		FillSpan(x0 - x_end, y0 + y, x0 - x_start, y0 + y, color);
+		FillSpan(x0 + x_start, y0 - y, x0 + x_end, y0 - y, color);
+		FillSpan(x0 - x_end, y0 - y, x0 - x_start, y0 - y, color);
+		/* Vertical runs on left and right octants */
+		FillSpan(x0 + y, y0 + x_start, x0 + y, y0 + x_end, color);
+		FillSpan(x0 + y, y0 - x_end, x0 + y, y0 - x_start, color);
+		FillSpan(x0 - y, y0 + x_start, x0 - y, y0 + x_end, color);
+		FillSpan(x0 - y, y0 - x_end, x0 - y, y0 - x_start, color);
+	}
+}
+
+void EdgeNext(edge_t *edge, const ili9341_point_t *points, uint8_t count, int8_t direction, int16_t y){
+	const ili9341_point_t *start = &points[edge->end];
+	const ili9341_point_t *end;
+
+	edge->end = (edge->end + count + direction) % count;
+	end = &points[edge->end];
+	edge->y_end = end->y;
+	if (end->y > start->y){
+		edge->step = ToFixed(end->x - start->x) / (end->y - start->y);
+		edge->x = ToFixed(start->x) + edge->step * (y - start->y);
+	}
+	else{
+		/* Horizontal edge: only its end is needed, the other edge reaches its start */
+		edge->step = 0;
+		edge->x = ToFixed(end->x);
+	}
+}
+
+void QueueBuffer(uint8_t index, uint32_t size, bool last){
+	PendingSend(false);
+	/* Inside a drawing, its end decides whether this buffer was the last one */
+	if (last && lcd.drawing > 0){
+		lcd.pending = (pending_t){.size = size, .index = index, .span = false};
+		return;
+	}
+	SpiWriteQueued(lcd.spi, lcd.buffer[index], size, last);
+	lcd.queued++;
+	lcd.ticket[index] = lcd.queued;
+}
+
+void PendingSend(bool notify){
+	pending_t pending = lcd.pending;
+
+	if (pending.size == 0){
+		return;
+	}
+	/* Cleared first: sending it goes through the functions that call this one */
+	lcd.pending.size = 0;
+	if (pending.span){
+		WriteWindow(pending.x0, pending.y0, pending.x1, pending.y1, lcd.buffer[pending.index], pending.size, notify);
+	}
+	else{
+		SpiWriteQueued(lcd.spi, lcd.buffer[pending.index], pending.size, notify);
+		lcd.queued++;
+		lcd.ticket[pending.index] = lcd.queued;
+	}
+}
+
+void DrawBegin(void){
+	lcd.drawing++;
+}
+
+void DrawEnd(void){
+	lcd.drawing--;
+	if (lcd.drawing == 0){
+		PendingSend(true);
+	}
+}
+
+void StreamBegin(pixel_stream_t *stream){
+	stream->buffer = ILI9341GetPixelBuffer(&stream->size);
+	stream->used = 0;
+}
+
+void StreamBytes(pixel_stream_t *stream, const uint8_t *data, uint32_t size){
+	uint32_t chunk;
+
+	while (size > 0){
+		if (stream->used == stream->size){
+			ILI9341PushPixelBuffer(stream->used, false);
+			StreamBegin(stream);
+		}
+		chunk = stream->size - stream->used;
+		if (chunk > size){
+			chunk = size;
+		}
+		memcpy(&stream->buffer[stream->used], data, chunk);
+		stream->used += chunk;
+		data += chunk;
+		size -= chunk;
+	}
+}
+
+void StreamColor(pixel_stream_t *stream, uint16_t color){
+	/* Buffer size is even, so a pixel is never split */
+	if (stream->used == stream->size){
+		ILI9341PushPixelBuffer(stream->used, false);
+		StreamBegin(stream);
+	}
+	stream->buffer[stream->used++] = HighByte(color);
+	stream->buffer[stream->used++] = LowByte(color);
+}
+
+void StreamEnd(pixel_stream_t *stream){
+	ILI9341PushPixelBuffer(stream->used, true);
+}
+
+void StreamGlyphRow(pixel_stream_t *stream, glyph_t *glyph, char data, Font_t* font, uint16_t row, uint16_t foreground, uint16_t background){
+	uint16_t j;
+	uint8_t width = font->info[data - ' '].width;
+	const uint8_t *bits;
+
+	if (glyph != NULL){
+		StreamBytes(stream, &glyph_cache.pool[glyph->offset + row * width * 2], width * 2);
+	}
+	else{
+		bits = &font->data[font->info[data - ' '].offset + row * ((width + 7) / 8)];
+		for (j = 0; j < width; j++){
+			StreamColor(stream, (bits[j / 8] & (MSK_BIT8 >> (j % 8))) ? foreground : background);
+		}
+	}
+}
+
+glyph_t* GlyphGet(char data, Font_t* font, uint16_t foreground, uint16_t background){
+	uint8_t i;
+	uint16_t j, k;
+	uint16_t color;
+	uint32_t size;
+	uint8_t *pixel;
+	const uint8_t *bits;
+	glyph_t *glyph = NULL;
+	glyph_t *lru;
+	char_info_t *info = &font->info[data - ' '];
+
+	if (glyph_cache.pool == NULL){
+		return NULL;
+	}
+	for (i = 0; i < ILI9341_GLYPH_CACHE_ENTRIES; i++){
+		if (glyph_cache.glyph[i].size == 0){
+			glyph = &glyph_cache.glyph[i];
+		}
+		else if (glyph_cache.glyph[i].font == font && glyph_cache.glyph[i].data == data &&
+				glyph_cache.glyph[i].foreground == foreground && glyph_cache.glyph[i].background == background){
+			glyph_cache.glyph[i].last_use = glyph_cache.clock;
+			return &glyph_cache.glyph[i];
+		}
+	}
+	size = font->font_height * info->width * 2;
+	if (size == 0 || size > ILI9341_GLYPH_CACHE_SIZE){
+		return NULL;
+	}
+	/* Make room discarding least recently used characters */
+	while (glyph == NULL || glyph_cache.used + size > ILI9341_GLYPH_CACHE_SIZE){
+		lru = NULL;
+		for (i = 0; i < ILI9341_GLYPH_CACHE_ENTRIES; i++){
+			if (glyph_cache.glyph[i].size != 0 && glyph_cache.glyph[i].last_use != glyph_cache.clock &&
+					(lru == NULL || glyph_cache.glyph[i].last_use < lru->last_use)){
+				lru = &glyph_cache.glyph[i];
+			}
+		}
+		/* Everything in cache is used by the current drawing */
+		if (lru == NULL){
+			return NULL;
+		}
+		GlyphEvict(lru);
+		glyph = lru;
+	}
+	/* Expand 1 bit per pixel font data to RGB565 */
+	pixel = &glyph_cache.pool[glyph_cache.used];
+	for (j = 0; j < font->font_height; j++){
+		bits = &font->data[info->offset + j * ((info->width + 7) / 8)];
+		for (k = 0; k < info->width; k++){
+			color = (bits[k / 8] & (MSK_BIT8 >> (k % 8))) ? foreground : background;
+			*pixel++ = HighByte(color);
+			*pixel++ = LowByte(color);
+		}
+	}
+	glyph->font = font;
+	glyph->data = data;
+	glyph->foreground = foreground;
+	glyph->background = background;
+	glyph->offset = glyph_cache.used;
+	glyph->size = size;
+	glyph->last_use = glyph_cache.clock;
+	glyph_cache.used += size;
+	return glyph;
+}
+
+void GlyphEvict(glyph_t *glyph){
+	uint8_t i;
+	uint32_t end = glyph->offset + glyph->size;
 
-	while(bytes_count - MAX_VALUE_SIZE > 0){
-		lcd_cmd_t lcd_pixel = {NULL, MAX_VALUE_SIZE, pixel};
-		WriteLCD(&lcd_pixel);
-		bytes_count -= MAX_VALUE_SIZE;
+	/* Move down everything after the discarded character */
+	memmove(&glyph_cache.pool[glyph->offset], &glyph_cache.pool[end], glyph_cache.used - end);
+	for (i = 0; i < ILI9341_GLYPH_CACHE_ENTRIES; i++){
+		if (glyph_cache.glyph[i].size != 0 && glyph_cache.glyph[i].offset >= end){
+			glyph_cache.glyph[i].offset -= glyph->size;
+		}
+	}
+	glyph_cache.used -= glyph->size;
+	glyph->size = 0;
+}
+
+void DrawTextLine(uint16_t x, uint16_t y, char* str, uint8_t count, Font_t *font, uint16_t foreground, uint16_t background){
+	glyph_t *glyph[MAX_LINE_CHARS];
+	uint8_t k;
+	uint16_t i, width;
+	pixel_stream_t stream;
+
+	width = 0;
+	for (k = 0; k < count; k++){
+		glyph[k] = GlyphGet(str[k], font, foreground, background);
+		width += font->info[str[k] - ' '].width + 1;
+	}
+	ILI9341SetWindow(x, y, x + width - 2, y + font->font_height - 1);
+	/* Line is sent row by row: a row of each character and the gap after it */
+	StreamBegin(&stream);
+	for (i = 0; i < font->font_height; i++){
+		for (k = 0; k < count; k++){
+			if (k > 0){
+				StreamColor(&stream, background);
+			}
+			StreamGlyphRow(&stream, glyph[k], str[k], font, i, foreground, background);
+		}
+	}
+	StreamEnd(&stream);
+}
+
+void IRAM_ATTR TransferDone(void *param){
+	if (lcd.done_func_p != NULL){
+		lcd.done_func_p(lcd.done_param_p);
 	}
-	lcd_cmd_t lcd_pixel = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixel);
 }
 
 /*==================[external functions definition]==========================*/
 
 uint8_t ILI9341Init(spi_dev_t spi_dev, uint8_t gpio_dc, uint8_t gpio_rst){
-	/* SPI configuration */
+	/* Session: the SPI device is added once and kept for every later transfer */
+	lcd.spi = spi_dev;
+	lcd.dc = gpio_dc;
+	lcd.rst = gpio_rst;
 	spi_conf.device = spi_dev;
-	ili9341_spi = spi_dev;
-	/* GPIOs configuration and initialization */
-	ili9341_dc = gpio_dc;
-	ili9341_rst = gpio_rst;
-	GPIOInit(ili9341_dc, GPIO_OUTPUT);
-	GPIOInit(ili9341_rst, GPIO_OUTPUT);
+	spi_conf.dc_gpio = gpio_dc;
+	SpiInit(&spi_conf);
+	/* GPIOs configuration and initialization (DC is configured by the SPI driver) */
+	GPIOInit(lcd.rst, GPIO_OUTPUT);
+	/* Pixel buffers must be DMA capable */
+	for (uint8_t i = 0; i < 2; i++){
+		if (lcd.buffer[i] == NULL){
+			lcd.buffer[i] = heap_caps_malloc(ILI9341_BUFFER_SIZE, MALLOC_CAP_DMA);
+			if (lcd.buffer[i] == NULL){
+				return false;
+			}
+		}
+	}
+	/* Glyph cache is optional: without it characters are expanded while they are sent */
+	if (glyph_cache.pool == NULL){
+		glyph_cache.pool = heap_caps_malloc(ILI9341_GLYPH_CACHE_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	}
 
 	/* RST must be held low for minimum 10µsec after VCC have been applied */
 	DelayUs(10);
-	GPIOOn(ili9341_rst);
+	GPIOOn(lcd.rst);
 	/* Wait more than 10µsec after RST high before sending a command */
 	DelayUs(10);
 	/* It will be necessary to wait 5msec before sending new command following software reset */
@@ -303,15 +901,15 @@ uint8_t ILI9341Init(spi_dev_t spi_dev, uint8_t gpio_dc, uint8_t gpio_rst){
 }
 
 void ILI9341DrawPixel(uint16_t x, uint16_t y, uint16_t color){
-	/* Define area (pixel) to fill */
-	SetCursorPosition(x, y, x, y);
 	uint8_t pixels[] = {HighByte(color), LowByte(color)};
-	lcd_cmd_t lcd_pixels = {MEM_WRITE, sizeof(pixels), pixels};
-	WriteLCD(&lcd_pixels);
+	/* Define area (pixel) to fill and write it */
+	WriteWindow(x, y, x, y, pixels, sizeof(pixels), true);
 }
 
 void ILI9341Fill(uint16_t color){
-	Fill(0, 0, lcd_orientation.width, lcd_orientation.height, color);
+	DrawBegin();
+	Fill(0, 0, lcd_orientation.width - 1, lcd_orientation.height - 1, color);
+	DrawEnd();
 }
 
 void ILI9341Rotate(ili9341_orientation_t orientation){
@@ -349,128 +947,63 @@ void ILI9341Rotate(ili9341_orientation_t orientation){
 	WriteLCD(&lcd_mem_acc);
 }
 
-void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background){
-	static uint32_t i, j, k;
-	static uint32_t char_row;
-	static uint16_t lcd_x, lcd_y;
-	static int32_t bytes_count, bytes_row;
-	static uint8_t pixel[MAX_VALUE_SIZE];
+ili9341_orientation_t ILI9341GetOrientation(void){
+	return lcd_orientation.orientation;
+}
 
-	/* Set coordinates */
-	lcd_x = x;
-	lcd_y = y;
+void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background){
+	uint16_t i;
+	glyph_t *glyph;
+	pixel_stream_t stream;
+	char_info_t *info = &font->info[data - ' '];
 
 	/* If at the end of a line of display, go to new line and set x to 0 position */
-	if ((lcd_x + font->info[data - ' '].width) > lcd_orientation.width)	{
-		lcd_y += font->font_height;
-		lcd_x = 0;
+	if ((x + info->width) > lcd_orientation.width)	{
+		y += font->font_height;
+		x = 0;
 	}
-
-	SetCursorPosition(lcd_x, lcd_y, lcd_x + font->info[data - ' '].width - 1, lcd_y + font->font_height - 1);
-
-	/* Number of bytes to write. We have to write 2 bytes/pixel */
-	bytes_count = font->font_height * font->info[data - ' '].width * 2;
-
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
-
-	/* Draw font data */
-	/* go through character rows */
-	k = 0;
-	for (i = 0; i < font->font_height; i++)	{
-		/* */
-		char_row = font->info[data - ' '].offset + i * ((font->info[data - ' '].width + 7) / 8);
-		/* go through character columns */
-		bytes_row = -1;
-		for (j = 0; j < font->info[data - ' '].width; j++){
-			if(j % 8 == 0){
-				bytes_row++;
-			}
-			/* If exceed buffer size, send buffer */
-			if ((2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1) > MAX_VALUE_SIZE){
-				lcd_cmd_t lcd_pixels = {NULL, MAX_VALUE_SIZE, pixel};
-				WriteLCD(&lcd_pixels);
-				bytes_count -= MAX_VALUE_SIZE;
-				k++;
-			}
-			/* The n=FontWidth first bits of the 16bits row data draws the corresponding part of a character */
-			if (font->data[char_row + bytes_row] & (MSK_BIT8 >> (j % 8))){
-				/* if bit = 1, draw put foreground color */
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE] = HighByte(foreground);
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(foreground);
-			}
-			else{
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE] = HighByte(background);
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(background);
-			}
+	glyph_cache.clock++;
+	glyph = GlyphGet(data, font, foreground, background);
+
+	DrawBegin();
+	ILI9341SetWindow(x, y, x + info->width - 1, y + font->font_height - 1);
+	StreamBegin(&stream);
+	if (glyph != NULL){
+		/* Already expanded: the whole character is copied at once */
+		StreamBytes(&stream, &glyph_cache.pool[glyph->offset], glyph->size);
+	}
+	else{
+		for (i = 0; i < font->font_height; i++){
+			StreamGlyphRow(&stream, NULL, data, font, i, foreground, background);
 		}
 	}
-	/* Send the rest of the buffer */
-	lcd_cmd_t lcd_pixels = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixels);
+	StreamEnd(&stream);
+	DrawEnd();
 }
 
 void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font, uint16_t foreground, uint16_t background){
-	static uint32_t i, j, k;
-	static uint32_t char_row;
-	static uint16_t lcd_x, lcd_y;
-	static int32_t bytes_count, bytes_row;
-	static uint8_t pixel[MAX_VALUE_SIZE];
-
-	/* Set coordinates */
-	lcd_x = x;
-	lcd_y = y;
+	uint16_t i, j;
+	const uint8_t *bits;
+	pixel_stream_t stream;
 
 	/* If at the end of a line of display, go to new line and set x to 0 position */
-	if ((lcd_x + icon_font->width) > lcd_orientation.width)	{
-		lcd_y += icon_font->height;
-		lcd_x = 0;
+	if ((x + icon_font->width) > lcd_orientation.width)	{
+		y += icon_font->height;
+		x = 0;
 	}
+	DrawBegin();
+	ILI9341SetWindow(x, y, x + icon_font->width - 1, y + icon_font->height - 1);
 
-	SetCursorPosition(lcd_x, lcd_y, lcd_x + icon_font->width - 1, lcd_y + icon_font->height - 1);
-
-	/* Number of bytes to write. We have to write 2 bytes/pixel */
-	bytes_count = icon_font->height * icon_font->width * 2;
-
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
-
-	/* Draw font data */
-	/* go through character rows */
-	k = 0;
+	/* Icon is expanded to the DMA pixel buffers while the previous one is sent */
+	StreamBegin(&stream);
 	for (i = 0; i < icon_font->height; i++)	{
-		/*  */
-		char_row = icon * icon_font->offset + i * ((icon_font->width + 7) / 8);
-		/* go through character columns */
-		bytes_row = -1;
+		bits = &icon_font->data[icon * icon_font->offset + i * ((icon_font->width + 7) / 8)];
 		for (j = 0; j < icon_font->width; j++){
-			if(j % 8 == 0){
-				bytes_row++;
-			}
-			/* If exceed buffer size, send buffer */
-			if ((2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1) > MAX_VALUE_SIZE){
-				lcd_cmd_t lcd_pixels = {NULL, MAX_VALUE_SIZE, pixel};
-				WriteLCD(&lcd_pixels);
-				bytes_count -= MAX_VALUE_SIZE;
-				k++;
-			}
-			/* The n=FontWidth first bits of the 16bits row data draws the corresponding part of a character */
-			if (icon_font->data[char_row + bytes_row] & (MSK_BIT8 >> (j % 8))){
-				/* if bit = 1, draw put foreground color */
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE] = HighByte(foreground);
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(foreground);
-			}
-			else{
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE] = HighByte(background);
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(background);
-			}
+			StreamColor(&stream, (bits[j / 8] & (MSK_BIT8 >> (j % 8))) ? foreground : background);
 		}
 	}
-	/* Send the rest of the buffer */
-	lcd_cmd_t lcd_pixels = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixels);
+	StreamEnd(&stream);
+	DrawEnd();
 }
 
 void ILI9341DrawInt(uint16_t x, uint16_t y, uint32_t num, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background){
@@ -481,20 +1014,26 @@ void ILI9341DrawInt(uint16_t x, uint16_t y, uint32_t num, uint8_t dig, Font_t* f
 	lcd_x = x;
 	lcd_y = y;
 
+	DrawBegin();
 	for (i=0; i<dig; i++){
 		lcd_x = x + font->info[num%10 + '0' - ' '].width * (dig-1-i) + 1;
 		ILI9341DrawChar(lcd_x, lcd_y, num%10 + '0', font, foreground, background);
 		num = num/10;
 	}
+	DrawEnd();
 }
 
 void ILI9341DrawString(uint16_t x, uint16_t y, char* str, Font_t *font, uint16_t foreground, uint16_t background){
-	static uint16_t lcd_x, lcd_y;
+	uint16_t lcd_x, lcd_y, width, char_width;
+	uint8_t count;
 
 	/* Set coordinates */
 	lcd_x = x;
 	lcd_y = y;
+	/* Characters of the whole string are kept in cache while it is drawn */
+	glyph_cache.clock++;
 
+	DrawBegin();
 	while (*str != '\0'){	/* End of string */
 		/* New line */
 		if (*str == '\n'){
@@ -508,17 +1047,37 @@ void ILI9341DrawString(uint16_t x, uint16_t y, char* str, Font_t *font, uint16_t
 				lcd_x = x;
 			}
 			str++;
+			continue;
 		}
-		else if (*str == '\r'){
-				str++;
+		if (*str == '\r'){
+			str++;
+			continue;
+		}
+		/* Lay out the characters that fit in this line */
+		count = 0;
+		width = 0;
+		while (str[count] != '\0' && str[count] != '\n' && str[count] != '\r' && count < MAX_LINE_CHARS){
+			char_width = font->info[str[count] - ' '].width;
+			if (lcd_x + width + char_width > lcd_orientation.width){
+				break;
 			}
-
-		/* Put character to LCD */
-		ILI9341DrawChar(lcd_x, lcd_y, *str, font, foreground, background);
-		lcd_x += font->info[*str - ' '].width + 1;
-		/* Next character */
-		str++;
+			width += char_width + 1;
+			count++;
+		}
+		/* Not even one character fits: continue on a new line */
+		if (count == 0){
+			if (lcd_x == 0){
+				break;
+			}
+			lcd_y += font->font_height + 1;
+			lcd_x = 0;
+			continue;
+		}
+		DrawTextLine(lcd_x, lcd_y, str, count, font, foreground, background);
+		lcd_x += width;
+		str += count;
 	}
+	DrawEnd();
 }
 
 void ILI9341GetStringSize(char* str, Font_t* font, uint16_t* width, uint16_t* height){
@@ -535,119 +1094,58 @@ void ILI9341GetStringSize(char* str, Font_t* font, uint16_t* width, uint16_t* he
 }
 
 void ILI9341DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
-	static int16_t x_dist, y_dist, x_grow, y_grow, error, error_2;
-
-	/* Check for overflow */
-	if (x0 >= lcd_orientation.width){
-		x0 = lcd_orientation.width - 1;
-	}
-	if (x1 >= lcd_orientation.width){
-		x1 = lcd_orientation.width - 1;
-	}
-	if (y0 >= lcd_orientation.height){
-		y0 = lcd_orientation.height - 1;
-	}
-	if (y1 >= lcd_orientation.height){
-		y1 = lcd_orientation.height - 1;
-	}
-
-	/* Calculate x y distances and determine grow direction */
-	x_dist = x1 - x0;
-	y_dist = y1 - y0;
-	if (x0 > x1){
-		x_dist = -x_dist;
-		x_grow = LEFT;
-	}
-	else{
-		x_grow = RIGHT;
-	}
-	if (y0 > y1){
-		y_dist = -y_dist;
-		y_grow = UP;
-	}
-	else{
-		y_grow = DOWN;
-	}
-
-	/* Vertical or horizontal line */
-	if (x_dist == 0 || y_dist == 0){
-		Fill(x0, y0, x1, y1, color);
-	}
-	/* Diagonal line */
-	else{
-		error = x_dist - y_dist;
-
-		while (1){
-			/* Draw start point */
-			ILI9341DrawPixel(x0, y0, color);
-			/* Loop ends when start point reaches end point */
-			if (x0 == x1 && y0 == y1){
-				break;
-			}
-			error_2 = 2 * error;
-			/* Determine if line must grow in x direction */
-			if (error_2 > -y_dist){
-				error -= y_dist;
-				x0 += x_grow;	/* Move start point */
-			}
-			/* Determine if line must grow in y direction */
-			if (error_2 < x_dist){
-				error += x_dist;
-				y0 += y_grow;	/* Move start point */
-			}
-		}
-	}
+	DrawBegin();
+	/* Horizontal and vertical lines are a single run */
+	Line(x0, y0, x1, y1, color);
+	DrawEnd();
 }
 
 void ILI9341DrawRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
+	DrawBegin();
 	ILI9341DrawLine(x0, y0, x1, y0, color);		/* Draw top line */
 	ILI9341DrawLine(x1, y0, x1, y1, color);		/* Draw right line */
 	ILI9341DrawLine(x0, y1, x1, y1, color);		/* Draw bottom line */
 	ILI9341DrawLine(x0, y0, x0, y1, color);		/* Draw left line */
+	DrawEnd();
 }
 
 void ILI9341DrawFilledRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
-	Fill(x0, y0, x1, y1, color);
+	DrawBegin();
+	FillSpan(x0, y0, x1, y1, color);
+	DrawEnd();
 }
 
 void ILI9341DrawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
-	static int16_t f, ddF_x, ddF_y, x, y;
+	int16_t f, ddF_x, ddF_y, x, y, run_x;
 
 	f = 1 - r;
 	ddF_x = 1;
 	ddF_y = -2 * r;
 	x = 0;
 	y = r;
-
-	ILI9341DrawPixel(x0, y0 + r, color);
-	ILI9341DrawPixel(x0, y0 - r, color);
-	ILI9341DrawPixel(x0 + r, y0, color);
-	ILI9341DrawPixel(x0 - r, y0, color);
-
-    while (x < y){
-        if (f >= 0){
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        ILI9341DrawPixel(x0 + x, y0 + y, color);
-        ILI9341DrawPixel(x0 - x, y0 + y, color);
-        ILI9341DrawPixel(x0 + x, y0 - y, color);
-        ILI9341DrawPixel(x0 - x, y0 - y, color);
-
-        ILI9341DrawPixel(x0 + y, y0 + x, color);
-        ILI9341DrawPixel(x0 - y, y0 + x, color);
-        ILI9341DrawPixel(x0 + y, y0 - x, color);
-        ILI9341DrawPixel(x0 - y, y0 - x, color);
-    }
+	run_x = 0;
+
+	DrawBegin();
+	/* Midpoint points with the same y make a run: horizontal on the top and bottom
+	 * octants, vertical on the left and right ones */
+	while (x < y){
+		if (f >= 0){
+			CircleRuns(x0, y0, run_x, x, y, color);
+			run_x = x + 1;
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+	}
+	CircleRuns(x0, y0, run_x, x, y, color);
+	DrawEnd();
 }
 
 void ILI9341DrawFilledCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
-	static int16_t f, ddF_x, ddF_y, x, y;
+	int16_t f, ddF_x, ddF_y, x, y;
 
 	f = 1 - r;
 	ddF_x = 1;
@@ -655,179 +1153,200 @@ void ILI9341DrawFilledCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
 	x = 0;
 	y = r;
 
-    ILI9341DrawPixel(x0, y0 + r, color);
-    ILI9341DrawPixel(x0, y0 - r, color);
-    ILI9341DrawPixel(x0 + r, y0, color);
-    ILI9341DrawPixel(x0 - r, y0, color);
-    ILI9341DrawLine(x0 - r, y0, x0 + r, y0, color);
-
-    while (x < y){
-        if (f >= 0){
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        ILI9341DrawLine(x0 - x, y0 + y, x0 + x, y0 + y, color);
-        ILI9341DrawLine(x0 + x, y0 - y, x0 - x, y0 - y, color);
+	DrawBegin();
+	FillSpan(x0 - r, y0, x0 + r, y0, color);
+
+	/* Each row is sent once */
+	while (x < y){
+		if (f >= 0){
+			/* Last point with this y: rows y0 +/- y are complete */
+			FillSpan(x0 - x, y0 + y, x0 + x, y0 + y, color);
+			FillSpan(x0 - x, y0 - y, x0 + x, y0 - y, color);
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
 
-        ILI9341DrawLine(x0 + y, y0 + x, x0 - y, y0 + x, color);
-        ILI9341DrawLine(x0 + y, y0 - x, x0 - y, y0 - x, color);
-    }
+		FillSpan(x0 - y, y0 + x, x0 + y, y0 + x, color);
+		FillSpan(x0 - y, y0 - x, x0 + y, y0 - x, color);
+	}
+	DrawEnd();
 }
 
 void ILI9341DrawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
+	DrawBegin();
 	ILI9341DrawLine(x0, y0, x1, y1, color);
 	ILI9341DrawLine(x0, y0, x2, y2, color);
 	ILI9341DrawLine(x1, y1, x2, y2, color);
+	DrawEnd();
 }
 
 void ILI9341DrawFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
-	static int16_t x_0 = 0;
-	static int16_t y_0 = 0;
-	static int16_t x_1 = 0;
-	static int16_t y_1 = 0;
-	static int16_t x_2 = 0;
-	static int16_t y_2 = 0;
-	static int16_t x_aux = 0;
-	static int16_t y_aux = 0;
-	static int16_t scanline_y = 0;
-	float invslope1, invslope2, curx1, curx2;
-	if((y0 <= y1) && (y0 <= y2)){
-		x_0 = x0;
-		y_0 = y0;
-		if(y1 <= y2){
-			x_1 = x1;
-			y_1 = y1;
-			x_2 = x2;
-			y_2 = y2;
-		} else{
-			x_1 = x2;
-			y_1 = y2;
-			x_2 = x1;
-			y_2 = y1;
-		}
-	}else if((y1 <= y2) && (y1 <= y0)){
-		x_0 = x1;
-		y_0 = y1;
-		if(y0 <= y2){
-			x_1 = x0;
-			y_1 = y0;
-			x_2 = x2;
-			y_2 = y2;
-		} else{
-			x_1 = x2;
-			y_1 = y2;
-			x_2 = x0;
-			y_2 = y0;
+	ili9341_point_t points[3] = {{x0, y0}, {x1, y1}, {x2, y2}};
+
+	ILI9341DrawFilledPolygon(points, 3, color);
+}
+
+void ILI9341DrawPolygon(const ili9341_point_t *points, uint8_t count, uint16_t color){
+	uint8_t i;
+
+	DrawBegin();
+	for (i = 0; i < count; i++){
+		ILI9341DrawLine(points[i].x, points[i].y, points[(i + 1) % count].x, points[(i + 1) % count].y, color);
+	}
+	DrawEnd();
+}
+
+void ILI9341DrawFilledPolygon(const ili9341_point_t *points, uint8_t count, uint16_t color){
+	edge_t left, right;
+	uint8_t i, top, bottom;
+	int16_t y, y_last, x0, x1;
+
+	if (count == 0){
+		return;
+	}
+	top = 0;
+	bottom = 0;
+	for (i = 1; i < count; i++){
+		if (points[i].y < points[top].y){
+			top = i;
 		}
-	}else if((y2 <= y1) && (y2 <= y0)){
-		x_0 = x2;
-		y_0 = y2;
-		if(y0 <= y1){
-			x_1 = x0;
-			y_1 = y0;
-			x_2 = x1;
-			y_2 = y1;
-		} else{
-			x_1 = x1;
-			y_1 = y1;
-			x_2 = x0;
-			y_2 = y0;
+		if (points[i].y > points[bottom].y){
+			bottom = i;
 		}
 	}
-	if(y_1 == y_2){
-		// Bottom flat triangle
-		invslope1 = (float)(x_1 - x_0) / (float)(y_1 - y_0);
-		invslope2 = (float)(x_2 - x_0) / (float)(y_2 - y_0);
-		curx1 = x_0;
-		curx2 = x_0;
-		scanline_y = y_0;
-		while(scanline_y < y_1){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 += invslope1;
-			curx2 += invslope2;
-			scanline_y++;
+	/* All vertices in the same row */
+	if (points[top].y == points[bottom].y){
+		x0 = points[0].x;
+		x1 = points[0].x;
+		for (i = 1; i < count; i++){
+			x0 = (points[i].x < x0) ? points[i].x : x0;
+			x1 = (points[i].x > x1) ? points[i].x : x1;
 		}
-  	}
-  	else if (y_0 == y_1){
-		// Top flat triangle
-		invslope1 = (float)(x_2 - x_0) / (float)(y_2 - y_0);
-		invslope2 = (float)(x_2 - x_1) / (float)(y_2 - y_1);
-		curx1 = x_2;
-		curx2 = x_2;
-		scanline_y = y_2;
-		while(scanline_y > y_0){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 -= invslope1;
-			curx2 -= invslope2;
-			scanline_y--;
-		}
-  	}
-  	else{
-		// Split in a flat top triangle and a bottom flat triangle
-		x_aux = (int)(x_0 + (float)(y_1 - y_0) / (float)(y_2 - y_0) * (x_2 - x_0));
-		y_aux = y_1;
-		// Bottom flat triangle
-		invslope1 = (float)(x_1 - x_0) / (float)(y_1 - y_0);
-		invslope2 = (float)(x_aux - x_0) / (float)(y_aux - y_0);
-		curx1 = x_0;
-		curx2 = x_0;
-		scanline_y = y_0;
-		while(scanline_y < y_1){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 += invslope1;
-			curx2 += invslope2;
-			scanline_y++;
+		DrawBegin();
+		FillSpan(x0, points[top].y, x1, points[top].y, color);
+		DrawEnd();
+		return;
+	}
+	/* Only the rows on the LCD are walked: the loop can't run past INT16_MAX */
+	if (points[bottom].y < 0 || points[top].y >= lcd_orientation.height){
+		return;
+	}
+	y = (points[top].y < 0) ? 0 : points[top].y;
+	y_last = (points[bottom].y >= lcd_orientation.height) ? lcd_orientation.height - 1 : points[bottom].y;
+	/* Both sides of the outline are walked down from the top vertex to the bottom one,
+	 * starting at the first row on the LCD (edges above it are skipped by the loop).
+	 * All state is local, so drawings from different tasks don't share it. */
+	left.end = top;
+	right.end = top;
+	EdgeNext(&left, points, count, -1, y);
+	EdgeNext(&right, points, count, 1, y);
+	DrawBegin();
+	for (; y <= y_last; y++){
+		while (y > left.y_end && left.end != bottom){
+			EdgeNext(&left, points, count, -1, y);
 		}
-		// Top flat triangle
-		invslope1 = (float)(x_2 - x_1) / (float)(y_2 - y_1);
-		invslope2 = (float)(x_2 - x_aux) / (float)(y_2 - y_aux);
-		curx1 = x_2;
-		curx2 = x_2;
-		scanline_y = y_2;
-		while(scanline_y > y_1){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 -= invslope1;
-			curx2 -= invslope2;
-			scanline_y--;
+		while (y > right.y_end && right.end != bottom){
+			EdgeNext(&right, points, count, 1, y);
 		}
-		ILI9341DrawLine(x_1, y_1, x_aux, y_aux, color);
-  	}
+		FillSpan(FromFixed(left.x), y, FromFixed(right.x), y, color);
+		left.x += left.step;
+		right.x += right.step;
+	}
+	DrawEnd();
 }
 
 void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pic){
-	static uint16_t i, j;
-	static int32_t bytes_count;
-	static uint8_t pixel[MAX_VALUE_SIZE];
+	uint32_t size, chunk;
+	uint32_t bytes_count;
+	uint8_t * pixel;
 
-	SetCursorPosition(x, y, x + width - 1, y + height - 1);
+	DrawBegin();
+	ILI9341SetWindow(x, y, x + width - 1, y + height - 1);
 
 	/* Number of bytes to write. We have to write 2 bytes/pixel */
 	bytes_count = width * height * 2;
 
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
+	/* Picture is copied to a buffer while the previous one is being sent */
+	while(bytes_count > 0){
+		pixel = ILI9341GetPixelBuffer(&size);
+		chunk = (bytes_count < size) ? bytes_count : size;
+		memcpy(pixel, pic, chunk);
+		pic += chunk;
+		bytes_count -= chunk;
+		ILI9341PushPixelBuffer(chunk, bytes_count == 0);
+	}
+	DrawEnd();
+}
 
-	j = 0;
-	while(bytes_count - MAX_VALUE_SIZE > 0){
-		for (i = 0; i < MAX_VALUE_SIZE; i++){
-			pixel[i] = pic[j * MAX_VALUE_SIZE + i];
-		}
-		lcd_cmd_t lcd_pixel = {NULL, MAX_VALUE_SIZE, pixel};
-		WriteLCD(&lcd_pixel);
-		bytes_count -= MAX_VALUE_SIZE;
-		j++;
+uint8_t ILI9341DrawCompressedPicture(uint16_t x, uint16_t y, const uint8_t* img){
+	img565_decoder_t decoder;
+	uint16_t width, height;
+	uint32_t size, chunk;
+	uint8_t * pixel;
+
+	if (!Img565Init(&decoder, img, &width, &height)){
+		return false;
 	}
-	for (i = 0; i < bytes_count; i++){
-		pixel[i] = pic[j * MAX_VALUE_SIZE + i];
+	DrawBegin();
+	ILI9341SetWindow(x, y, x + width - 1, y + height - 1);
+	/* Picture is decoded to a buffer while the previous one is being sent */
+	while (decoder.pixels > 0){
+		pixel = ILI9341GetPixelBuffer(&size);
+		chunk = Img565Decode(&decoder, pixel, size);
+		ILI9341PushPixelBuffer(chunk, decoder.pixels == 0);
+	}
+	DrawEnd();
+	return true;
+}
+
+void ILI9341SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
+	WriteWindow(x0, y0, x1, y1, NULL, 0, false);
+}
+
+uint8_t* ILI9341GetPixelBuffer(uint32_t *size){
+	uint32_t sent_after;
+
+	/* It may hold the buffer about to be returned */
+	PendingSend(false);
+	sent_after = lcd.queued - lcd.ticket[lcd.next];
+	/* Wait until the last transfer of this buffer has ended */
+	if (sent_after < SPI_QUEUE_SIZE){
+		SpiWaitQueued(lcd.spi, sent_after);
 	}
-	lcd_cmd_t lcd_pixel = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixel);
+	*size = ILI9341_BUFFER_SIZE;
+	return lcd.buffer[lcd.next];
+}
+
+void ILI9341PushPixelBuffer(uint32_t size, bool last){
+	QueueBuffer(lcd.next, size, last);
+	lcd.next ^= 1;
+}
+
+void ILI9341WaitTransfer(void){
+	SpiWaitQueued(lcd.spi, 0);
+}
+
+void ILI9341SetTransferDoneCallback(void *func_p, void *param_p){
+	lcd.done_param_p = param_p;
+	lcd.done_func_p = func_p;
+}
+
+void ILI9341SetScrollArea(uint16_t top, uint16_t length){
+	uint16_t bottom = ILI9341_HEIGHT - top - length;
+	/* Top fixed area, vertical scrolling area and bottom fixed area must add up to 320 lines */
+	uint8_t scroll_def[] = {HighByte(top), LowByte(top), HighByte(length), LowByte(length), HighByte(bottom), LowByte(bottom)};
+	lcd_cmd_t lcd_scroll_def = {VERT_SCROLL_DEF, sizeof(scroll_def), scroll_def};
+	WriteLCD(&lcd_scroll_def);
+}
+
+void ILI9341Scroll(uint16_t line){
+	uint8_t scroll_addr[] = {HighByte(line), LowByte(line)};
+	lcd_cmd_t lcd_scroll_addr = {VERT_SCROLL_ADDR, sizeof(scroll_addr), scroll_addr};
+	WriteLCD(&lcd_scroll_addr);
 }
 
 uint8_t ILI9341DeInit(void){
@@ -0,0 +1,202 @@
+/**
+ * @file ili9341_chart.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "ili9341_chart.h"
+/*==================[macros and definitions]=================================*/
+#define EMPTY_LOW	UINT8_MAX		/*!< First trace pixel of a line without trace */
+#define EMPTY_HIGH	0				/*!< Last trace pixel of a line without trace */
+/*==================[typedef]================================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/**
+ * @brief  		Set an LCD window over chart lines, for the current orientation
+ * @param[in]  	chart: Pointer to chart state
+ * @param[in]  	first: First chart line
+ * @param[in]  	count: Number of chart lines
+ * @param[in]  	a0: First pixel along the 240 pixels side
+ * @param[in]  	a1: Last pixel along the 240 pixels side
+ * @param[out] 	rect: Window as x0, y0, x1, y1
+ */
+static void LinesRect(ili9341_chart_t *chart, uint16_t first, uint16_t count, uint16_t a0, uint16_t a1, uint16_t *rect){
+	ili9341_orientation_t orientation = ILI9341GetOrientation();
+	uint16_t l0 = chart->config.start + first;
+	uint16_t l1 = l0 + count - 1;
+
+	/* Portrait_2 and Landscape_2 (MY = 1) write memory lines in reverse order */
+	if (orientation == ILI9341_Portrait_2 || orientation == ILI9341_Landscape_2){
+		l0 = ILI9341_HEIGHT - 1 - l0;
+		l1 = ILI9341_HEIGHT - 1 - l1;
+	}
+	/* In landscape (MV = 1) memory lines are LCD columns */
+	if (orientation == ILI9341_Landscape_1 || orientation == ILI9341_Landscape_2){
+		rect[0] = (l0 < l1) ? l0 : l1;
+		rect[1] = a0;
+		rect[2] = (l0 < l1) ? l1 : l0;
+		rect[3] = a1;
+	}
+	else{
+		rect[0] = a0;
+		rect[1] = (l0 < l1) ? l0 : l1;
+		rect[2] = a1;
+		rect[3] = (l0 < l1) ? l1 : l0;
+	}
+}
+
+/**
+ * @brief  		Send a group of consecutive chart lines with a single window
+ * @param[in]  	chart: Pointer to chart state
+ * @param[in]  	first: First chart line
+ * @param[in]  	count: Number of chart lines
+ * @param[in]  	a0: First trace pixel to send
+ * @param[in]  	a1: Last trace pixel to send
+ */
+static void WriteLines(ili9341_chart_t *chart, uint16_t first, uint16_t count, uint8_t a0, uint8_t a1){
+	ili9341_orientation_t orientation = ILI9341GetOrientation();
+	bool reversed = (orientation == ILI9341_Portrait_2 || orientation == ILI9341_Landscape_2);
+	bool exchanged = (orientation == ILI9341_Landscape_1 || orientation == ILI9341_Landscape_2);
+	uint16_t rect[4];
+	uint16_t i, j, line, a, color;
+	uint32_t size, n;
+	uint8_t *pixel;
+
+	LinesRect(chart, first, count, chart->config.amp_start + a0, chart->config.amp_start + a1, rect);
+	ILI9341SetWindow(rect[0], rect[1], rect[2], rect[3]);
+	pixel = ILI9341GetPixelBuffer(&size);
+	n = 0;
+	/* Pixels are written in LCD order: rows from top, columns from left */
+	for (i = 0; i < (exchanged ? a1 - a0 + 1 : count); i++){
+		for (j = 0; j < (exchanged ? count : a1 - a0 + 1); j++){
+			line = exchanged ? j : i;
+			line = first + (reversed ? count - 1 - line : line);
+			a = a0 + (exchanged ? i : j);
+			color = (a >= chart->low[line] && a <= chart->high[line]) ? chart->config.color : chart->config.background;
+			pixel[n++] = color >> 8;
+			pixel[n++] = color & 0xFF;
+		}
+	}
+	ILI9341PushPixelBuffer(n, true);
+}
+
+/*==================[external functions definition]==========================*/
+
+uint8_t ILI9341ChartInit(ili9341_chart_t *chart, ili9341_chart_config_t *config){
+	uint16_t i;
+	uint16_t rect[4];
+
+	if (config->length == 0 || config->start + config->length > ILI9341_HEIGHT ||
+			config->amp_size == 0 || config->amp_start + config->amp_size > ILI9341_WIDTH ||
+			config->max <= config->min){
+		return false;
+	}
+	chart->config = *config;
+	chart->scale = (config->amp_size - 1) / (config->max - config->min);
+	chart->position = 0;
+	chart->started = false;
+	for (i = 0; i < config->length; i++){
+		chart->low[i] = EMPTY_LOW;
+		chart->high[i] = EMPTY_HIGH;
+	}
+	ILI9341SetScrollArea(config->start, config->length);
+	ILI9341Scroll(config->start);
+	/* Whole lines scroll, so they are cleared across the LCD */
+	LinesRect(chart, 0, config->length, 0, ILI9341_WIDTH - 1, rect);
+	ILI9341DrawFilledRectangle(rect[0], rect[1], rect[2], rect[3], config->background);
+	return true;
+}
+
+void ILI9341ChartAddSamples(ili9341_chart_t *chart, const float *samples, uint32_t count){
+	uint32_t i;
+	uint16_t first, lines;
+	uint16_t line;
+	uint8_t a0, a1, n0, n1, lo, hi, p;
+	float value;
+
+	first = chart->position;
+	lines = 0;
+	a0 = EMPTY_LOW;
+	a1 = EMPTY_HIGH;
+	for (i = 0; i < count; i++){
+		/* Trace pixel of the sample */
+		value = (chart->config.max - samples[i]) * chart->scale;
+		if (value <= 0){
+			p = 0;
+		}
+		else if (value >= chart->config.amp_size - 1){
+			p = chart->config.amp_size - 1;
+		}
+		else{
+			p = (uint8_t)(value + 0.5f);
+		}
+		if (!chart->started){
+			chart->last = p;
+			chart->started = true;
+		}
+		/* Each line joins the previous sample with the new one */
+		lo = (p < chart->last) ? p : chart->last;
+		hi = (p > chart->last) ? p : chart->last;
+		chart->last = p;
+
+		/* Window must cover the old trace of the line (to erase it) and the new one */
+		line = chart->position;
+		n0 = (lo < chart->low[line]) ? lo : chart->low[line];
+		n1 = (hi > chart->high[line]) ? hi : chart->high[line];
+		if (n0 > a0){
+			n0 = a0;
+		}
+		if (n1 < a1){
+			n1 = a1;
+		}
+		/* Lines are grouped while they fit in a pixel buffer */
+		if (lines > 0 && (uint32_t)(lines + 1) * (n1 - n0 + 1) * 2 > ILI9341_BUFFER_SIZE){
+			WriteLines(chart, first, lines, a0, a1);
+			first = line;
+			lines = 0;
+			n0 = (lo < chart->low[line]) ? lo : chart->low[line];
+			n1 = (hi > chart->high[line]) ? hi : chart->high[line];
+		}
+		a0 = n0;
+		a1 = n1;
+		chart->low[line] = lo;
+		chart->high[line] = hi;
+		lines++;
+		chart->position++;
+		/* Last chart line: continue on the first one */
+		if (chart->position == chart->config.length){
+			WriteLines(chart, first, lines, a0, a1);
+			chart->position = 0;
+			first = 0;
+			lines = 0;
+			a0 = EMPTY_LOW;
+			a1 = EMPTY_HIGH;
+		}
+	}
+	if (lines > 0){
+		WriteLines(chart, first, lines, a0, a1);
+	}
+	/* Oldest line is shown first, so the newest one is the last of the scrolling area */
+	ILI9341Scroll(chart->config.start + chart->position);
+}
+
+uint8_t ILI9341ChartDeInit(ili9341_chart_t *chart){
+	ILI9341SetScrollArea(0, ILI9341_HEIGHT);
+	ILI9341Scroll(0);
+	return true;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,299 @@
+/**
+ * @file ili9341_dl.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "ili9341_dl.h"
+#include <string.h>
+#include <stdint.h>
+/*==================[macros and definitions]=================================*/
+#define CMD_FILL	0			/*!< Filled rectangle */
+#define CMD_STRING	1			/*!< String */
+#define CMD_ICON	2			/*!< Icon */
+
+#define FLAG_EXACT	(1 << 0)	/*!< Box is exactly the area drawn (no line wrapping) */
+#define FLAG_SKIP	(1 << 1)	/*!< Covered by a later drawing */
+
+#define Align(x) (((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))	/*!< Size or address aligned for pointers */
+/*==================[typedef]================================================*/
+/**
+ * @brief  Recorded drawing. Strings follow the record.
+ */
+typedef struct {
+	uint8_t type;			/*!< Drawing type */
+	uint8_t flags;			/*!< Drawing flags */
+	uint16_t size;			/*!< Record size in bytes */
+	uint16_t x0;			/*!< Left column of the drawing box */
+	uint16_t y0;			/*!< Top row of the drawing box */
+	uint16_t x1;			/*!< Right column of the drawing box */
+	uint16_t y1;			/*!< Bottom row of the drawing box */
+	uint16_t foreground;	/*!< Foreground color (fill color for rectangles) */
+	uint16_t background;	/*!< Background color */
+	void *font;				/*!< Font (strings) or icon font (icons) */
+	uint16_t icon;			/*!< Icon */
+	uint16_t length;		/*!< String length */
+} dl_cmd_t;
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+static uint16_t LcdWidth(void){
+	ili9341_orientation_t orientation = ILI9341GetOrientation();
+	return (orientation == ILI9341_Landscape_1 || orientation == ILI9341_Landscape_2) ? ILI9341_HEIGHT : ILI9341_WIDTH;
+}
+
+/**
+ * @brief  		Reserve a record at the end of the display list
+ */
+static dl_cmd_t* NewCmd(ili9341_dl_t *dl, uint8_t type, uint32_t extra){
+	dl_cmd_t *cmd;
+	uint32_t size = Align(sizeof(dl_cmd_t) + extra);
+
+	/* Record size must fit its 16 bits field */
+	if (dl->count == ILI9341_DL_MAX_CMDS || size > UINT16_MAX || dl->used + size > dl->size){
+		return NULL;
+	}
+	cmd = (dl_cmd_t *)&dl->buffer[dl->used];
+	memset(cmd, 0, sizeof(dl_cmd_t));
+	cmd->type = type;
+	cmd->size = size;
+	dl->used += size;
+	dl->count++;
+	return cmd;
+}
+
+static bool Contains(const dl_cmd_t *a, const dl_cmd_t *b){
+	return a->x0 <= b->x0 && a->x1 >= b->x1 && a->y0 <= b->y0 && a->y1 >= b->y1;
+}
+
+static bool Overlap(const dl_cmd_t *a, const dl_cmd_t *b){
+	/* Boxes of drawings that wrap lines are not exact: they may overlap anything */
+	if (!(a->flags & FLAG_EXACT) || !(b->flags & FLAG_EXACT)){
+		return true;
+	}
+	return a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+/**
+ * @brief  		Whether a column is covered, all along the rows of a string, by an exact
+ * 				drawing sent after the given position of the replay order
+ */
+static bool Covered(dl_cmd_t **order, uint16_t from, uint16_t count, uint16_t x, uint16_t y0, uint16_t y1){
+	uint16_t k;
+
+	for (k = from; k < count; k++){
+		if ((order[k]->flags & FLAG_EXACT) && order[k]->x0 <= x && order[k]->x1 >= x &&
+				order[k]->y0 <= y0 && order[k]->y1 >= y1){
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool Before(const dl_cmd_t *a, const dl_cmd_t *b){
+	return a->y0 < b->y0 || (a->y0 == b->y0 && a->x0 < b->x0);
+}
+
+/*==================[external functions definition]==========================*/
+
+void ILI9341DlInit(ili9341_dl_t *dl, uint8_t *buffer, uint32_t size){
+	/* Records hold pointers: the first one starts at an aligned address */
+	uint32_t skip = Align((uintptr_t)buffer) - (uintptr_t)buffer;
+
+	skip = (skip < size) ? skip : size;
+	dl->buffer = buffer + skip;
+	dl->size = size - skip;
+	ILI9341DlClear(dl);
+}
+
+void ILI9341DlClear(ili9341_dl_t *dl){
+	dl->used = 0;
+	dl->count = 0;
+}
+
+uint8_t ILI9341DlFilledRectangle(ili9341_dl_t *dl, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
+	dl_cmd_t *cmd = NewCmd(dl, CMD_FILL, 0);
+
+	if (cmd == NULL){
+		return false;
+	}
+	cmd->flags = FLAG_EXACT;
+	cmd->x0 = (x0 < x1) ? x0 : x1;
+	cmd->x1 = (x0 < x1) ? x1 : x0;
+	cmd->y0 = (y0 < y1) ? y0 : y1;
+	cmd->y1 = (y0 < y1) ? y1 : y0;
+	cmd->foreground = color;
+	return true;
+}
+
+uint8_t ILI9341DlString(ili9341_dl_t *dl, uint16_t x, uint16_t y, char* str, Font_t *font, uint16_t foreground, uint16_t background){
+	dl_cmd_t *cmd;
+	size_t length = strlen(str);
+	uint32_t i, width, x1;
+	bool exact = true;
+
+	if (length == 0){
+		return true;
+	}
+	/* Longer strings don't fit a record (NewCmd() rejects them too) */
+	if (length >= UINT16_MAX){
+		return false;
+	}
+	cmd = NewCmd(dl, CMD_STRING, length + 1);
+	if (cmd == NULL){
+		return false;
+	}
+	memcpy(cmd + 1, str, length + 1);
+	width = 0;
+	for (i = 0; i < length; i++){
+		if (str[i] == '\n' || str[i] == '\r'){
+			exact = false;
+		}
+		else{
+			width += font->info[str[i] - ' '].width + 1;
+		}
+	}
+	x1 = x + width - 2;
+	cmd->x0 = x;
+	cmd->y0 = y;
+	cmd->x1 = (x1 < UINT16_MAX) ? x1 : UINT16_MAX;
+	cmd->y1 = y + font->font_height - 1;
+	/* Strings with new lines or wider than the LCD don't draw just their box */
+	cmd->flags = (exact && width > 0 && x1 < LcdWidth()) ? FLAG_EXACT : 0;
+	cmd->foreground = foreground;
+	cmd->background = background;
+	cmd->font = font;
+	cmd->length = length;
+	return true;
+}
+
+uint8_t ILI9341DlIcon(ili9341_dl_t *dl, uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font, uint16_t foreground, uint16_t background){
+	dl_cmd_t *cmd = NewCmd(dl, CMD_ICON, 0);
+
+	if (cmd == NULL){
+		return false;
+	}
+	cmd->x0 = x;
+	cmd->y0 = y;
+	cmd->x1 = x + icon_font->width - 1;
+	cmd->y1 = y + icon_font->height - 1;
+	cmd->flags = (cmd->x1 < LcdWidth()) ? FLAG_EXACT : 0;
+	cmd->foreground = foreground;
+	cmd->background = background;
+	cmd->font = icon_font;
+	cmd->icon = icon;
+	return true;
+}
+
+uint16_t ILI9341DlReplay(ili9341_dl_t *dl){
+	dl_cmd_t **order = (dl_cmd_t **)dl->order;
+	dl_cmd_t *cmd, *next;
+	dl_cmd_t box;
+	uint16_t i, j, count, sent;
+	uint32_t offset;
+	char text[ILI9341_DL_MAX_TEXT + 1];
+
+	count = 0;
+	for (offset = 0; offset < dl->used; offset += cmd->size){
+		cmd = (dl_cmd_t *)&dl->buffer[offset];
+		cmd->flags &= ~FLAG_SKIP;
+		order[count++] = cmd;
+	}
+	/* Skip drawings completely covered by a later one */
+	for (i = 0; i < count; i++){
+		for (j = i + 1; j < count && (order[i]->flags & FLAG_EXACT); j++){
+			if ((order[j]->flags & FLAG_EXACT) && Contains(order[j], order[i])){
+				order[i]->flags |= FLAG_SKIP;
+				break;
+			}
+		}
+	}
+	j = 0;
+	for (i = 0; i < count; i++){
+		if (!(order[i]->flags & FLAG_SKIP)){
+			order[j++] = order[i];
+		}
+	}
+	count = j;
+	/* Sort by screen position. A drawing never moves before one it overlaps */
+	for (i = 1; i < count; i++){
+		cmd = order[i];
+		for (j = i; j > 0 && Before(cmd, order[j - 1]) && !Overlap(cmd, order[j - 1]); j--){
+			order[j] = order[j - 1];
+		}
+		order[j] = cmd;
+	}
+	/* Send, joining drawings that continue each other */
+	sent = 0;
+	for (i = 0; i < count; i = j){
+		cmd = order[i];
+		box = *cmd;
+		j = i + 1;
+		switch (cmd->type){
+		case CMD_FILL:
+			while (j < count){
+				next = order[j];
+				if (next->type != CMD_FILL || next->foreground != box.foreground){
+					break;
+				}
+				if (next->y0 == box.y0 && next->y1 == box.y1 && next->x0 == box.x1 + 1){
+					box.x1 = next->x1;
+				}
+				else if (next->x0 == box.x0 && next->x1 == box.x1 && next->y0 == box.y1 + 1){
+					box.y1 = next->y1;
+				}
+				else{
+					break;
+				}
+				j++;
+			}
+			ILI9341DrawFilledRectangle(box.x0, box.y0, box.x1, box.y1, box.foreground);
+			break;
+
+		case CMD_STRING:
+			if (cmd->length > ILI9341_DL_MAX_TEXT){
+				ILI9341DrawString(box.x0, box.y0, (char *)(cmd + 1), cmd->font, box.foreground, box.background);
+				break;
+			}
+			memcpy(text, cmd + 1, cmd->length + 1);
+			while ((box.flags & FLAG_EXACT) && j < count){
+				next = order[j];
+				if (next->type != CMD_STRING || !(next->flags & FLAG_EXACT) || next->font != box.font ||
+						next->foreground != box.foreground || next->background != box.background ||
+						next->y0 != box.y0 || next->x0 != box.x1 + 2 || box.length + next->length > ILI9341_DL_MAX_TEXT){
+					break;
+				}
+				/* Sent as one, the column between both strings gets the background:
+				 * only if a drawing sent later paints it anyway */
+				if (!Covered(order, j + 1, count, box.x1 + 1, box.y0, box.y1)){
+					break;
+				}
+				memcpy(&text[box.length], next + 1, next->length + 1);
+				box.length += next->length;
+				box.x1 = next->x1;
+				j++;
+			}
+			ILI9341DrawString(box.x0, box.y0, text, box.font, box.foreground, box.background);
+			break;
+
+		case CMD_ICON:
+			ILI9341DrawIcon(box.x0, box.y0, box.icon, box.font, box.foreground, box.background);
+			break;
+		}
+		sent++;
+	}
+	return sent;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,470 @@
+/**
+ * @file ili9341_fb.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "ili9341_fb.h"
+#include <stdbool.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+/*==================[macros and definitions]=================================*/
+#define MSK_BIT8 0x80				/*!< 8th bit mask */
+#define SwapBytes(x) ((uint16_t)(((x) >> 8) | ((x) << 8)))	/*!< RGB565 color in LCD byte order (high byte first) */
+/*==================[typedef]================================================*/
+/**
+ * @brief  Rectangle in framebuffer coordinates (limits included)
+ */
+typedef struct {
+	int16_t x0;		/*!< Left column */
+	int16_t y0;		/*!< Top row */
+	int16_t x1;		/*!< Right column */
+	int16_t y1;		/*!< Bottom row */
+} fb_rect_t;
+
+/**
+ * @brief  Framebuffer state
+ */
+typedef struct {
+	uint16_t x;								/*!< LCD column of the framebuffer left side */
+	uint16_t y;								/*!< LCD row of the framebuffer top side */
+	uint16_t width;							/*!< Width in pixels */
+	uint16_t height;						/*!< Height in pixels */
+	uint16_t *pixels;						/*!< RGB565 pixels, in LCD byte order (NULL in palette mode) */
+	uint8_t *indexes;						/*!< Palette indexes (NULL in RGB565 mode) */
+	uint16_t palette[ILI9341_FB_PALETTE_SIZE];	/*!< Palette colors, in LCD byte order */
+	fb_rect_t dirty[ILI9341_FB_MAX_DIRTY];	/*!< Areas changed since last flush */
+	uint8_t dirty_count;					/*!< Number of dirty areas */
+	fb_rect_t changed;						/*!< Pixels changed by the drawing in progress */
+} framebuffer_t;
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+static framebuffer_t fb;		/*!< Framebuffer */
+
+/*==================[internal functions definition]==========================*/
+
+static uint32_t Area(const fb_rect_t *r){
+	return (uint32_t)(r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+static void Union(fb_rect_t *r, const fb_rect_t *other){
+	if (other->x0 < r->x0) r->x0 = other->x0;
+	if (other->y0 < r->y0) r->y0 = other->y0;
+	if (other->x1 > r->x1) r->x1 = other->x1;
+	if (other->y1 > r->y1) r->y1 = other->y1;
+}
+
+/**
+ * @brief  		Check if two rectangles overlap or are next to each other
+ */
+static bool Touch(const fb_rect_t *a, const fb_rect_t *b){
+	return (a->x0 <= b->x1 + 1) && (b->x0 <= a->x1 + 1) && (a->y0 <= b->y1 + 1) && (b->y0 <= a->y1 + 1);
+}
+
+/**
+ * @brief  		Add a rectangle to the dirty list, merging it with the ones it touches
+ */
+static void AddDirty(fb_rect_t r){
+	uint8_t i, best;
+	uint32_t cost, best_cost;
+	fb_rect_t merged;
+
+	i = 0;
+	while (i < fb.dirty_count){
+		if (Touch(&r, &fb.dirty[i])){
+			Union(&r, &fb.dirty[i]);
+			fb.dirty[i] = fb.dirty[--fb.dirty_count];
+			/* The grown rectangle may touch one already checked */
+			i = 0;
+		}
+		else{
+			i++;
+		}
+	}
+	if (fb.dirty_count == ILI9341_FB_MAX_DIRTY){
+		/* No room left: merge with the rectangle that grows the least */
+		best = 0;
+		best_cost = UINT32_MAX;
+		for (i = 0; i < fb.dirty_count; i++){
+			merged = fb.dirty[i];
+			Union(&merged, &r);
+			cost = Area(&merged) - Area(&fb.dirty[i]);
+			if (cost < best_cost){
+				best_cost = cost;
+				best = i;
+			}
+		}
+		Union(&r, &fb.dirty[best]);
+		fb.dirty[best] = fb.dirty[--fb.dirty_count];
+		AddDirty(r);
+		return;
+	}
+	fb.dirty[fb.dirty_count++] = r;
+}
+
+/**
+ * @brief  		Start a drawing: reset the changed pixels area
+ */
+static void BeginDraw(void){
+	fb.changed.x0 = INT16_MAX;
+	fb.changed.y0 = INT16_MAX;
+	fb.changed.x1 = -1;
+	fb.changed.y1 = -1;
+}
+
+/**
+ * @brief  		End a drawing: record the changed pixels area as dirty
+ */
+static void EndDraw(void){
+	if (fb.changed.x1 >= 0){
+		AddDirty(fb.changed);
+	}
+}
+
+/**
+ * @brief  		Write an horizontal run of pixels
+ * @param[in]  	x0: LCD column of first pixel
+ * @param[in]  	x1: LCD column of last pixel
+ * @param[in]  	y: LCD row
+ * @param[in]  	color: Color (RGB565, or palette index in palette mode)
+ */
+static void Span(int16_t x0, int16_t x1, int16_t y, uint16_t color){
+	int16_t x, first, last;
+	uint16_t value = SwapBytes(color);
+	uint16_t *p;
+	uint8_t index = color;
+	uint8_t *q;
+
+	if (fb.pixels == NULL && fb.indexes == NULL){
+		return;
+	}
+	/* Framebuffer coordinates */
+	x0 -= fb.x;
+	x1 -= fb.x;
+	y -= fb.y;
+	if (x0 > x1){
+		x = x0;
+		x0 = x1;
+		x1 = x;
+	}
+	/* Clip */
+	if (y < 0 || y >= fb.height || x1 < 0 || x0 >= fb.width){
+		return;
+	}
+	if (x0 < 0){
+		x0 = 0;
+	}
+	if (x1 >= fb.width){
+		x1 = fb.width - 1;
+	}
+	/* Only pixels that really change make the area dirty */
+	first = -1;
+	last = -1;
+	if (fb.indexes != NULL){
+		q = &fb.indexes[y * fb.width + x0];
+		for (x = x0; x <= x1; x++, q++){
+			if (*q != index){
+				*q = index;
+				if (first < 0){
+					first = x;
+				}
+				last = x;
+			}
+		}
+	}
+	else{
+		p = &fb.pixels[y * fb.width + x0];
+		for (x = x0; x <= x1; x++, p++){
+			if (*p != value){
+				*p = value;
+				if (first < 0){
+					first = x;
+				}
+				last = x;
+			}
+		}
+	}
+	if (first >= 0){
+		if (first < fb.changed.x0) fb.changed.x0 = first;
+		if (last > fb.changed.x1) fb.changed.x1 = last;
+		if (y < fb.changed.y0) fb.changed.y0 = y;
+		if (y > fb.changed.y1) fb.changed.y1 = y;
+	}
+}
+
+static void Line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	int16_t x_dist, y_dist, x_grow, y_grow, error, error_2;
+
+	x_dist = (x1 > x0) ? x1 - x0 : x0 - x1;
+	y_dist = (y1 > y0) ? y1 - y0 : y0 - y1;
+	x_grow = (x0 < x1) ? 1 : -1;
+	y_grow = (y0 < y1) ? 1 : -1;
+	error = x_dist - y_dist;
+	while (1){
+		Span(x0, x0, y0, color);
+		if (x0 == x1 && y0 == y1){
+			break;
+		}
+		error_2 = 2 * error;
+		if (error_2 > -y_dist){
+			error -= y_dist;
+			x0 += x_grow;
+		}
+		if (error_2 < x_dist){
+			error += x_dist;
+			y0 += y_grow;
+		}
+	}
+}
+
+static void FilledRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	int16_t y;
+
+	if (y0 > y1){
+		y = y0;
+		y0 = y1;
+		y1 = y;
+	}
+	for (y = y0; y <= y1; y++){
+		Span(x0, x1, y, color);
+	}
+}
+
+/**
+ * @brief  		Draw a 1 bit per pixel bitmap (rows padded to bytes)
+ */
+static void Bitmap(int16_t x, int16_t y, const uint8_t *data, uint16_t width, uint16_t height, uint16_t foreground, uint16_t background){
+	uint16_t i, j;
+	const uint8_t *row;
+
+	for (i = 0; i < height; i++){
+		row = data + i * ((width + 7) / 8);
+		for (j = 0; j < width; j++){
+			Span(x + j, x + j, y + i, (row[j / 8] & (MSK_BIT8 >> (j % 8))) ? foreground : background);
+		}
+	}
+}
+
+static void Char(int16_t x, int16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background){
+	char_info_t *info = &font->info[data - ' '];
+	Bitmap(x, y, &font->data[info->offset], info->width, font->font_height, foreground, background);
+}
+
+/**
+ * @brief  		Expand palette indexes to RGB565 pixels (LCD byte order)
+ * @param[out] 	out: Pixels (2 bytes aligned)
+ * @param[in]  	indexes: Palette indexes
+ * @param[in]  	count: Number of pixels
+ */
+static void ExpandRow(uint8_t *out, const uint8_t *indexes, uint16_t count){
+	uint16_t *pixel = (uint16_t *)out;
+
+	while (count--){
+		*pixel++ = fb.palette[*indexes++];
+	}
+}
+
+/**
+ * @brief  		Mark the whole framebuffer as dirty
+ */
+static void DirtyAll(void){
+	fb_rect_t all = {0, 0, fb.width - 1, fb.height - 1};
+
+	fb.dirty_count = 0;
+	AddDirty(all);
+}
+
+/*==================[external functions definition]==========================*/
+
+uint8_t ILI9341FbInit(uint16_t x, uint16_t y, uint16_t width, uint16_t height){
+	ILI9341FbDeInit();
+	fb.pixels = heap_caps_calloc((uint32_t)width * height, sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	if (fb.pixels == NULL){
+		return false;
+	}
+	fb.x = x;
+	fb.y = y;
+	fb.width = width;
+	fb.height = height;
+	/* LCD content is unknown: the whole area is sent on first flush */
+	DirtyAll();
+	return true;
+}
+
+uint8_t ILI9341FbInitPalette(uint16_t x, uint16_t y, uint16_t width, uint16_t height){
+	uint16_t i;
+
+	ILI9341FbDeInit();
+	fb.indexes = heap_caps_calloc((uint32_t)width * height, sizeof(uint8_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	if (fb.indexes == NULL){
+		return false;
+	}
+	fb.x = x;
+	fb.y = y;
+	fb.width = width;
+	fb.height = height;
+	/* Default palette: index bits are RRRGGGBB */
+	for (i = 0; i < ILI9341_FB_PALETTE_SIZE; i++){
+		fb.palette[i] = SwapBytes((uint16_t)(((i & 0xE0) << 8) | ((i & 0x1C) << 6) | ((i & 0x03) << 3)));
+	}
+	/* LCD content is unknown: the whole area is sent on first flush */
+	DirtyAll();
+	return true;
+}
+
+void ILI9341FbSetPalette(uint8_t first, uint16_t count, const uint16_t *colors){
+	uint16_t i;
+
+	for (i = 0; i < count && first + i < ILI9341_FB_PALETTE_SIZE; i++){
+		fb.palette[first + i] = SwapBytes(colors[i]);
+	}
+	/* Every pixel may use a changed color: the whole area is sent on next flush */
+	if (fb.indexes != NULL){
+		DirtyAll();
+	}
+}
+
+void ILI9341FbFill(uint16_t color){
+	BeginDraw();
+	FilledRectangle(fb.x, fb.y, fb.x + fb.width - 1, fb.y + fb.height - 1, color);
+	EndDraw();
+}
+
+void ILI9341FbDrawPixel(int16_t x, int16_t y, uint16_t color){
+	BeginDraw();
+	Span(x, x, y, color);
+	EndDraw();
+}
+
+void ILI9341FbDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	BeginDraw();
+	Line(x0, y0, x1, y1, color);
+	EndDraw();
+}
+
+void ILI9341FbDrawRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	BeginDraw();
+	Span(x0, x1, y0, color);		/* Draw top line */
+	Line(x1, y0, x1, y1, color);	/* Draw right line */
+	Span(x0, x1, y1, color);		/* Draw bottom line */
+	Line(x0, y0, x0, y1, color);	/* Draw left line */
+	EndDraw();
+}
+
+void ILI9341FbDrawFilledRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	BeginDraw();
+	FilledRectangle(x0, y0, x1, y1, color);
+	EndDraw();
+}
+
+void ILI9341FbDrawChar(int16_t x, int16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background){
+	BeginDraw();
+	Char(x, y, data, font, foreground, background);
+	EndDraw();
+}
+
+void ILI9341FbDrawString(int16_t x, int16_t y, char* str, Font_t *font, uint16_t foreground, uint16_t background){
+	int16_t fb_x = x;
+
+	BeginDraw();
+	while (*str != '\0'){	/* End of string */
+		/* New line */
+		if (*str == '\n'){
+			y += font->font_height + 1;
+			/* if after \n is also \r, than go to the left of the screen */
+			if (*(str + 1) == '\r'){
+				fb_x = 0;
+				str++;
+			}
+			else{
+				fb_x = x;
+			}
+		}
+		else if (*str != '\r'){
+			Char(fb_x, y, *str, font, foreground, background);
+			fb_x += font->info[*str - ' '].width + 1;
+		}
+		/* Next character */
+		str++;
+	}
+	EndDraw();
+}
+
+void ILI9341FbDrawInt(int16_t x, int16_t y, uint32_t num, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background){
+	uint8_t i;
+
+	BeginDraw();
+	for (i = 0; i < dig; i++){
+		Char(x + font->info[num % 10 + '0' - ' '].width * (dig - 1 - i) + 1, y, num % 10 + '0', font, foreground, background);
+		num = num / 10;
+	}
+	EndDraw();
+}
+
+void ILI9341FbDrawIcon(int16_t x, int16_t y, icon_t icon, icon_font_t* icon_font, uint16_t foreground, uint16_t background){
+	BeginDraw();
+	Bitmap(x, y, &icon_font->data[icon * icon_font->offset], icon_font->width, icon_font->height, foreground, background);
+	EndDraw();
+}
+
+uint32_t ILI9341FbFlush(void){
+	uint8_t i;
+	int16_t row;
+	uint32_t size, used, row_bytes, bytes = 0;
+	uint8_t *buffer;
+	fb_rect_t *r;
+
+	for (i = 0; i < fb.dirty_count; i++){
+		r = &fb.dirty[i];
+		row_bytes = (r->x1 - r->x0 + 1) * sizeof(uint16_t);
+		/* One address window for each area */
+		ILI9341SetWindow(fb.x + r->x0, fb.y + r->y0, fb.x + r->x1, fb.y + r->y1);
+		buffer = ILI9341GetPixelBuffer(&size);
+		used = 0;
+		for (row = r->y0; row <= r->y1; row++){
+			if (used + row_bytes > size){
+				ILI9341PushPixelBuffer(used, false);
+				bytes += used;
+				buffer = ILI9341GetPixelBuffer(&size);
+				used = 0;
+			}
+			if (fb.indexes != NULL){
+				ExpandRow(&buffer[used], &fb.indexes[row * fb.width + r->x0], r->x1 - r->x0 + 1);
+			}
+			else{
+				memcpy(&buffer[used], &fb.pixels[row * fb.width + r->x0], row_bytes);
+			}
+			used += row_bytes;
+		}
+		ILI9341PushPixelBuffer(used, i == fb.dirty_count - 1);
+		bytes += used;
+	}
+	fb.dirty_count = 0;
+	return bytes;
+}
+
+uint8_t ILI9341FbDeInit(void){
+	if (fb.pixels != NULL){
+		/* Pixels may still be in use by a flush */
+		ILI9341WaitTransfer();
+		heap_caps_free(fb.pixels);
+		fb.pixels = NULL;
+	}
+	if (fb.indexes != NULL){
+		heap_caps_free(fb.indexes);
+		fb.indexes = NULL;
+	}
+	fb.dirty_count = 0;
+	return true;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,124 @@
+/**
+ * @file img565.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "img565.h"
+#include <stdbool.h>
+/*==================[macros and definitions]=================================*/
+#define OP_INDEX	0x00		/*!< Color from table */
+#define OP_DIFF		0x40		/*!< Small difference from previous color */
+#define OP_LUMA		0x80		/*!< Difference from previous color, based on green */
+#define OP_RUN		0xC0		/*!< Short run */
+#define OP_COLOR	0xFE		/*!< RGB565 color */
+#define OP_LONG_RUN	0xFF		/*!< Long run */
+#define MSK_OP		0xC0		/*!< Opcode bits */
+#define MSK_ARG		0x3F		/*!< Argument bits */
+
+#define Red(c) ((c) >> 11)				/*!< Red component of a RGB565 color */
+#define Green(c) (((c) >> 5) & 0x3F)	/*!< Green component of a RGB565 color */
+#define Blue(c) ((c) & 0x1F)			/*!< Blue component of a RGB565 color */
+#define Rgb565(r, g, b) ((uint16_t)((((r) & 0x1F) << 11) | (((g) & 0x3F) << 5) | ((b) & 0x1F)))	/*!< RGB565 color from components */
+#define Hash(c) ((Red(c) * 3 + Green(c) * 5 + Blue(c) * 7) % IMG565_INDEX_SIZE)	/*!< Position of a color in table */
+/*==================[typedef]================================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/*==================[external functions definition]==========================*/
+
+uint8_t Img565Init(img565_decoder_t *decoder, const uint8_t *img, uint16_t *width, uint16_t *height){
+	uint8_t i;
+
+	if (img[0] != 'R' || img[1] != '5' || img[2] != '6' || img[3] != '5'){
+		return false;
+	}
+	*width = (img[4] << 8) | img[5];
+	*height = (img[6] << 8) | img[7];
+	decoder->data = &img[IMG565_HEADER_SIZE];
+	decoder->pixels = (uint32_t)*width * *height;
+	decoder->run = 0;
+	decoder->previous = 0;
+	for (i = 0; i < IMG565_INDEX_SIZE; i++){
+		decoder->index[i] = 0;
+	}
+	return true;
+}
+
+uint32_t Img565Decode(img565_decoder_t *decoder, uint8_t *pixels, uint32_t size){
+	uint8_t op, arg;
+	int8_t dg, half;
+	uint16_t c;
+	uint32_t count, n = 0;
+
+	while (size - n >= 2 && decoder->pixels > 0){
+		/* Next color */
+		if (decoder->run == 0){
+			op = *decoder->data++;
+			arg = op & MSK_ARG;
+			c = decoder->previous;
+			if (op == OP_COLOR){
+				c = (decoder->data[0] << 8) | decoder->data[1];
+				decoder->data += 2;
+			}
+			else if (op == OP_LONG_RUN){
+				decoder->run = ((decoder->data[0] << 8) | decoder->data[1]) + 1;
+				decoder->data += 2;
+			}
+			else{
+				switch (op & MSK_OP){
+				case OP_INDEX:
+					c = decoder->index[arg];
+					break;
+				case OP_DIFF:
+					c = Rgb565(Red(c) + (arg >> 4) - 2, Green(c) + ((arg >> 2) & 0x03) - 2, Blue(c) + (arg & 0x03) - 2);
+					break;
+				case OP_LUMA:
+					dg = arg - 32;
+					half = ((dg + 32) >> 1) - 16;	/* dg / 2, rounded down */
+					arg = *decoder->data++;
+					c = Rgb565(Red(c) + (arg >> 4) - 8 + half, Green(c) + dg, Blue(c) + (arg & 0x0F) - 8 + half);
+					break;
+				case OP_RUN:
+					decoder->run = arg + 1;
+					break;
+				}
+			}
+			/* A new color is a run of one pixel */
+			if (decoder->run == 0){
+				decoder->index[Hash(c)] = c;
+				decoder->previous = c;
+				decoder->run = 1;
+			}
+		}
+		/* Write as much of the run as fits */
+		count = (size - n) / 2;
+		if (count > decoder->run){
+			count = decoder->run;
+		}
+		if (count > decoder->pixels){
+			count = decoder->pixels;
+		}
+		decoder->run -= count;
+		decoder->pixels -= count;
+		while (count--){
+			pixels[n++] = decoder->previous >> 8;
+			pixels[n++] = decoder->previous & 0xFF;
+		}
+	}
+	return n;
+}
+
+/*==================[end of file]============================================*/
@@ -13,32 +13,339 @@
 #include "mpu6050.h"
 #include "math.h"
 #include <string.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 /*==================[macros and definitions]=================================*/
 #define I2C_NUM I2C_NUM_0
+#define DATA_READY_TASK_STACK 2048	/*!< Stack size of the data ready task (bytes) */
+/** Value of a register field (bit: its most significant bit, as in the BIT/LENGTH definitions) */
+#define MPU6050_FIELD(value, bit, length) ((uint8_t)(((value) & ((1 << (length)) - 1)) << ((bit) - (length) + 1)))
 
 /*==================[internal data definition]===============================*/
-uint8_t devAddr;
-uint8_t buffer[14];
+static uint8_t devAddr;		/*!< Sensor of the functions without sensor parameter (MPU6050_Address()) */
+static mpu6050_t default_dev;	/*!< Sensor of the functions without sensor parameter */
+/** Registers that are not kept in the shadow copy: status, data, self-clearing
+ * reset bits and DMP memory access (auto-incremented address) */
+static const i2c_reg_range_t volatile_regs[] = {
+	{MPU6050_RA_I2C_SLV4_CTRL, MPU6050_RA_I2C_MST_STATUS},
+	{MPU6050_RA_DMP_INT_STATUS, MPU6050_RA_MOT_DETECT_STATUS},
+	{MPU6050_RA_SIGNAL_PATH_RESET, MPU6050_RA_SIGNAL_PATH_RESET},
+	{MPU6050_RA_USER_CTRL, MPU6050_RA_PWR_MGMT_1},
+	{MPU6050_RA_BANK_SEL, MPU6050_RA_MEM_R_W},
+	{MPU6050_RA_FIFO_COUNTH, MPU6050_RA_WHO_AM_I},
+};
+static TaskHandle_t data_ready_task;					/*!< Task that reads a sample on each data ready interrupt */
+static mpu6050_stream_t * volatile data_ready_stream;	/*!< Ring buffer of the data ready task (NULL: stopped) */
+static volatile int64_t data_ready_time;				/*!< Time of the last data ready interrupt */
+static gpio_t data_ready_pin;						/*!< GPIO of the data ready interrupt (valid with data_ready_task) */
 /*==================[internal functions declaration]=========================*/
 
-/*==================[external functions definition]==========================*/
-void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len){
-	uint8_t dev = 0x68;
-	i2c_cmd_handle_t cmd;
-	I2C_SelectRegister(dev, reg);
+/** Sample from its FIFO bytes (big endian, accelerometer before gyroscope).
+ * @param contents FIFO contents
+ * @param data FIFO bytes of the sample
+ * @param sample Sample
+ */
+static void MPU6050_streamParse(uint8_t contents, const uint8_t *data, mpu6050_sample_t *sample) {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        sample->accel[axis] = 0;
+        sample->gyro[axis] = 0;
+    }
+    if (contents & MPU6050_STREAM_ACCEL) {
+        for (uint8_t axis = 0; axis < 3; axis++, data += 2) {
+            sample->accel[axis] = (((int16_t)data[0]) << 8) | data[1];
+        }
+    }
+    if (contents & MPU6050_STREAM_GYRO) {
+        for (uint8_t axis = 0; axis < 3; axis++, data += 2) {
+            sample->gyro[axis] = (((int16_t)data[0]) << 8) | data[1];
+        }
+    }
+}
+
+/** Sample from the data registers (ACCEL_XOUT_H to GYRO_ZOUT_L).
+ * @param data Register values (temperature is between accelerometer and gyroscope)
+ * @param sample Sample
+ */
+static void MPU6050_motionParse(const uint8_t *data, mpu6050_sample_t *sample) {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        sample->accel[axis] = (((int16_t)data[2 * axis]) << 8) | data[2 * axis + 1];
+        sample->gyro[axis] = (((int16_t)data[8 + 2 * axis]) << 8) | data[8 + 2 * axis + 1];
+    }
+}
+
+/** Set up a stream and its sample rate (between I2C_shadowBegin() and I2C_shadowCommit()).
+ * @param addr Sensor address
+ * @param stream Streaming state
+ * @param samples Ring buffer memory
+ * @param size Ring buffer size in samples
+ * @param contents Sample contents
+ * @param dlpf Digital low pass filter
+ * @param rate Sample rate divider
+ * @return Status of operation (true = success)
+ */
+static bool MPU6050_streamSetup(uint8_t addr, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate) {
+    uint32_t gyro_rate;
+
+    stream->devAddr = addr;
+    stream->next_time = 0;
+    stream->samples = samples;
+    stream->size = size;
+    stream->head = 0;
+    stream->tail = 0;
+    stream->contents = contents;
+    stream->frame_size = ((contents & MPU6050_STREAM_ACCEL) ? 6 : 0) + ((contents & MPU6050_STREAM_GYRO) ? 6 : 0);
+    stream->overflows = 0;
+    /* Gyroscope output rate is 8 kHz without DLPF, 1 kHz with it */
+    gyro_rate = (dlpf == MPU6050_DLPF_BW_256 || dlpf == 7) ? 8000 : 1000;
+    stream->period = 1000000UL * (1 + rate) / gyro_rate;
+    return I2C_writeBits(addr, MPU6050_RA_CONFIG, MPU6050_CFG_DLPF_CFG_BIT, MPU6050_CFG_DLPF_CFG_LENGTH, dlpf) &
+            I2C_writeByte(addr, MPU6050_RA_SMPLRT_DIV, rate);
+}
+
+/** Check the parameters of a FIFO stream.
+ * @param samples Ring buffer memory
+ * @param size Ring buffer size in samples
+ * @param contents Sample contents
+ * @return true if valid
+ */
+static bool MPU6050_streamValid(mpu6050_sample_t *samples, uint16_t size, uint8_t contents) {
+    return samples != NULL && size >= 2 && contents != 0 && (contents & ~(MPU6050_STREAM_ACCEL | MPU6050_STREAM_GYRO)) == 0;
+}
+
+/** Stop the FIFO and set up a stream (FIFO contents, sample rate and DLPF) in one configuration block.
+ * @param addr Sensor address
+ * @param stream Streaming state
+ * @param samples Ring buffer memory
+ * @param size Ring buffer size in samples
+ * @param contents Sample contents
+ * @param dlpf Digital low pass filter
+ * @param rate Sample rate divider
+ * @return Status of operation (true = success)
+ */
+static bool MPU6050_streamConfig(uint8_t addr, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate) {
+    bool success;
+
+    success = I2C_writeBit(addr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_FIFO_EN_BIT, false);
+    I2C_shadowBegin(addr);
+    success &= MPU6050_streamSetup(addr, stream, samples, size, contents, dlpf, rate);
+    success &= I2C_writeByte(addr, MPU6050_RA_FIFO_EN, contents);
+    return I2C_shadowCommit(addr) && success;
+}
+
+/** Write a whole configuration and read it back.
+ * @param addr Sensor address
+ * @param config Configuration
+ * @return true if SMPLRT_DIV to ACCEL_CONFIG, FIFO_EN, INT_PIN_CFG and INT_ENABLE read back as written
+ */
+static bool MPU6050_configApply(uint8_t addr, const mpu6050_config_t *config) {
+    uint8_t image[4], interrupts[2], back[MPU6050_RA_INT_ENABLE - MPU6050_RA_SMPLRT_DIV + 1];
+
+    /* SMPLRT_DIV, CONFIG, GYRO_CONFIG and ACCEL_CONFIG are consecutive: one burst */
+    image[0] = config->rate;
+    image[1] = MPU6050_FIELD(config->dlpf, MPU6050_CFG_DLPF_CFG_BIT, MPU6050_CFG_DLPF_CFG_LENGTH);
+    image[2] = MPU6050_FIELD(config->gyro_range, MPU6050_GCONFIG_FS_SEL_BIT, MPU6050_GCONFIG_FS_SEL_LENGTH);
+    image[3] = MPU6050_FIELD(config->accel_range, MPU6050_ACONFIG_AFS_SEL_BIT, MPU6050_ACONFIG_AFS_SEL_LENGTH);
+    interrupts[0] = config->int_pin_cfg;
+    interrupts[1] = config->int_enable;
+    /* PWR_MGMT_1 is not kept in the shadow copy: written at once, waking the sensor first */
+    I2C_writeByte(addr, MPU6050_RA_PWR_MGMT_1,
+            MPU6050_FIELD(config->clock_source, MPU6050_PWR1_CLKSEL_BIT, MPU6050_PWR1_CLKSEL_LENGTH) |
+            MPU6050_FIELD(config->sleep, MPU6050_PWR1_SLEEP_BIT, 1));
+    I2C_shadowBegin(addr);
+    I2C_writeBytes(addr, MPU6050_RA_SMPLRT_DIV, 4, image);
+    I2C_writeByte(addr, MPU6050_RA_FIFO_EN, config->fifo_contents);
+    I2C_writeBytes(addr, MPU6050_RA_INT_PIN_CFG, 2, interrupts);
+    I2C_shadowCommit(addr);
+    /* SMPLRT_DIV to INT_ENABLE in a single burst. I2C_MST_STATUS, in between, is never
+     * cached: the burst always goes to the sensor and refreshes the shadow copy */
+    if (I2C_readBytes(addr, MPU6050_RA_SMPLRT_DIV, sizeof(back), back, I2C_MASTER_TIMEOUT_MS) != sizeof(back)) {
+        return false;
+    }
+    return memcmp(image, back, sizeof(image)) == 0 &&
+            back[MPU6050_RA_FIFO_EN - MPU6050_RA_SMPLRT_DIV] == config->fifo_contents &&
+            memcmp(interrupts, &back[MPU6050_RA_INT_PIN_CFG - MPU6050_RA_SMPLRT_DIV], sizeof(interrupts)) == 0;
+}
+
+/** Empty and enable the FIFO.
+ * @param addr Sensor address
+ */
+static void MPU6050_fifoRestart(uint8_t addr) {
+    I2C_writeBit(addr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_FIFO_RESET_BIT, true);
+    I2C_writeBit(addr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_FIFO_EN_BIT, true);
+}
+
+/** Stop the FIFO and clear its contents selection.
+ * @param addr Sensor address
+ */
+static void MPU6050_fifoStop(uint8_t addr) {
+    I2C_writeBit(addr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_FIFO_EN_BIT, false);
+    I2C_writeByte(addr, MPU6050_RA_FIFO_EN, 0);
+}
+
+/** Read the FIFO count of a stream and estimate the timestamp of its next sample.
+ * @param stream Streaming state
+ * @param next_time Timestamp of the next sample, taken by the stream with the first burst read
+ * @return Number of whole samples in the FIFO that fit in the ring buffer (0 if the count read failed)
+ */
+static uint16_t MPU6050_streamPending(mpu6050_stream_t *stream, int64_t *next_time) {
+    uint8_t data[2];
+    uint16_t count, frames, room;
+    int64_t now, oldest;
+
+    if (I2C_readBytes(stream->devAddr, MPU6050_RA_FIFO_COUNTH, 2, data, I2C_MASTER_TIMEOUT_MS) != 2) {
+        return 0;
+    }
+    now = esp_timer_get_time();
+    count = (((uint16_t)data[0]) << 8) | data[1];
+    /* When full, new samples overwrite the oldest bytes: what is left is not aligned */
+    if (count >= MPU6050_FIFO_SIZE) {
+        stream->overflows++;
+        stream->next_time = 0;
+        I2C_writeBit(stream->devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_FIFO_EN_BIT, false);
+        MPU6050_fifoRestart(stream->devAddr);
+        return 0;
+    }
+    frames = count / stream->frame_size;
+    if (frames == 0) {
+        return 0;
+    }
+    /* The newest sample was taken within the last period, half a period ago on average.
+     * The estimate is smoothed, and the sensor clock followed, a quarter at a time */
+    oldest = now - stream->period / 2 - (int64_t)(frames - 1) * stream->period;
+    if (stream->next_time == 0) {
+        *next_time = oldest;
+    } else {
+        *next_time = stream->next_time + (oldest - stream->next_time) / 4;
+    }
+    room = (stream->tail + stream->size - stream->head - 1) % stream->size;
+    return (frames > room) ? room : frames;
+}
+
+/** Move samples from the FIFO to the ring buffer in a single burst (up to 255 bytes).
+ * @param stream Streaming state
+ * @param frames Number of samples to move (must be in the FIFO and fit in the ring buffer)
+ * @param next_time Timestamp of the first sample, advanced by the samples moved
+ * @return Number of samples moved (0 if the read failed: head and timestamps unchanged)
+ */
+static uint16_t MPU6050_streamBurst(mpu6050_stream_t *stream, uint16_t frames, int64_t *next_time) {
+    uint8_t data[255];
+    uint16_t burst, i;
+
+    burst = sizeof(data) / stream->frame_size;
+    if (burst > frames) {
+        burst = frames;
+    }
+    /* Samples not read stay in the FIFO: tried again on the next call */
+    if (I2C_readBytes(stream->devAddr, MPU6050_RA_FIFO_R_W, burst * stream->frame_size, data, I2C_MASTER_TIMEOUT_MS) != burst * stream->frame_size) {
+        return 0;
+    }
+    for (i = 0; i < burst; i++) {
+        MPU6050_streamParse(stream->contents, &data[i * stream->frame_size], &stream->samples[stream->head]);
+        stream->samples[stream->head].timestamp = *next_time;
+        stream->head = (stream->head + 1) % stream->size;
+        *next_time += stream->period;
+    }
+    stream->next_time = *next_time;
+    return burst;
+}
+
+/** Data ready interrupt: keeps the time and wakes up the data ready task.
+ * @param args Not used
+ */
+static void IRAM_ATTR MPU6050_dataReadyIsr(void *args) {
+    BaseType_t woken = pdFALSE;
+
+    data_ready_time = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(data_ready_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/** Task that reads a sample on each data ready interrupt.
+ * @param param Not used
+ */
+static void MPU6050_dataReadyRun(void *param) {
+    mpu6050_stream_t *stream;
+    uint8_t data[14];
+    uint32_t pending;
+    int64_t timestamp;
+
+    while (true) {
+        pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        timestamp = data_ready_time;
+        stream = data_ready_stream;
+        if (stream == NULL) {
+            continue;
+        }
+        /* Interrupts not served in time: only the last sample can be read */
+        stream->overflows += pending - 1;
+        /* A failed read loses the sample too */
+        if (I2C_readBytes(stream->devAddr, MPU6050_RA_ACCEL_XOUT_H, 14, data, I2C_MASTER_TIMEOUT_MS) != 14 ||
+                (stream->head + 1) % stream->size == stream->tail) {
+            stream->overflows++;
+            continue;
+        }
+        MPU6050_motionParse(data, &stream->samples[stream->head]);
+        stream->samples[stream->head].timestamp = timestamp;
+        stream->head = (stream->head + 1) % stream->size;
+    }
+}
 
-	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (dev << 1) | I2C_MASTER_READ, 1));
+/** Set up a sensor to sample on the data ready interrupt (see MPU6050_dataReadyStart()).
+ * @param addr Sensor address
+ * @param stream Streaming state
+ * @param samples Ring buffer memory
+ * @param size Ring buffer size in samples
+ * @param dlpf Digital low pass filter
+ * @param rate Sample rate divider
+ * @param int_pin GPIO connected to the INT pin
+ * @param priority Priority of the task that reads the samples
+ * @return Status of operation (true = success)
+ */
+static bool MPU6050_dataReadySetup(uint8_t addr, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t dlpf, uint8_t rate, gpio_t int_pin, uint8_t priority) {
+    bool success;
 
-	if(len>1)
-		ESP_ERROR_CHECK(i2c_master_read(cmd, data, len, I2C_MASTER_ACK));
+    if (samples == NULL || size < 2) {
+        return false;
+    }
+    /* The interrupt can't be moved: GPIO interrupts can't be detached */
+    if (data_ready_task != NULL && int_pin != data_ready_pin) {
+        return false;
+    }
+    data_ready_stream = NULL;
+    I2C_shadowBegin(addr);
+    success = MPU6050_streamSetup(addr, stream, samples, size, MPU6050_STREAM_ACCEL | MPU6050_STREAM_GYRO, dlpf, rate);
+    /* 50 us active high pulse for each sample, status cleared by the sample read */
+    success &= I2C_writeBit(addr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_INT_LEVEL_BIT, MPU6050_INTMODE_ACTIVEHIGH);
+    success &= I2C_writeBit(addr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_INT_OPEN_BIT, MPU6050_INTDRV_PUSHPULL);
+    success &= I2C_writeBit(addr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_LATCH_INT_EN_BIT, MPU6050_INTLATCH_50USPULSE);
+    success &= I2C_writeBit(addr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_INT_RD_CLEAR_BIT, MPU6050_INTCLEAR_ANYREAD);
+    success &= I2C_writeBit(addr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_DATA_RDY_BIT, true);
+    success = I2C_shadowCommit(addr) && success;
+    data_ready_stream = stream;
+    if (data_ready_task == NULL) {
+        if (xTaskCreate(MPU6050_dataReadyRun, "mpu6050", DATA_READY_TASK_STACK, NULL, priority, &data_ready_task) != pdPASS) {
+            data_ready_stream = NULL;
+            return false;
+        }
+        data_ready_pin = int_pin;
+        GPIOInit(int_pin, GPIO_INPUT);
+        GPIOActivInt(int_pin, MPU6050_dataReadyIsr, true, NULL);
+    }
+    return success;
+}
 
-	ESP_ERROR_CHECK(i2c_master_read_byte(cmd, data+len-1, I2C_MASTER_NACK));
+/** Stop sampling a sensor on the data ready interrupt.
+ * @param addr Sensor address
+ */
+static void MPU6050_dataReadyEnd(uint8_t addr) {
+    I2C_writeBit(addr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_DATA_RDY_BIT, false);
+    data_ready_stream = NULL;
+}
 
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000));
-	i2c_cmd_link_delete(cmd);
+/*==================[external functions definition]==========================*/
+void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len){
+	I2C_readBytes(devAddr, reg, len, data, I2C_MASTER_TIMEOUT_MS);
 }
 
 void MPU6050_Address(uint8_t address) {
@@ -47,10 +354,19 @@ void MPU6050_Address(uint8_t address) {
 
 void MPU6050_initialize() {
 	devAddr = MPU6050_DEFAULT_ADDRESS;
-    MPU6050_setClockSource(MPU6050_CLOCK_PLL_XGYRO);
-    MPU6050_setFullScaleGyroRange(MPU6050_GYRO_FS_250);
-    MPU6050_setFullScaleAccelRange(MPU6050_ACCEL_FS_2);
-    MPU6050_setSleepEnabled(false); // thanks to Jack Elston for pointing this one out!
+    MPU6050_deviceInit(&default_dev, devAddr);
+}
+
+void MPU6050_beginConfig() {
+    I2C_shadowBegin(devAddr);
+}
+
+bool MPU6050_commitConfig() {
+    return I2C_shadowCommit(devAddr);
+}
+
+bool MPU6050_configure(const mpu6050_config_t *config) {
+    return MPU6050_configApply(devAddr, config);
 }
 
 /** Verify the I2C connection.
@@ -69,6 +385,8 @@ bool MPU6050_testConnection() {
  * @return I2C supply voltage level (0=VLOGIC, 1=VDD)
  */
 uint8_t MPU6050_getAuxVDDIOLevel() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_YG_OFFS_TC, MPU6050_TC_PWR_MODE_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -105,6 +423,8 @@ void MPU6050_setAuxVDDIOLevel(uint8_t level) {
  * @see MPU6050_RA_SMPLRT_DIV
  */
 uint8_t MPU6050_getRate() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_SMPLRT_DIV, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -147,6 +467,8 @@ void MPU6050_setRate(uint8_t rate) {
  * @return FSYNC configuration value
  */
 uint8_t MPU6050_getExternalFrameSync() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_CONFIG, MPU6050_CFG_EXT_SYNC_SET_BIT, MPU6050_CFG_EXT_SYNC_SET_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -188,6 +510,8 @@ void MPU6050_setExternalFrameSync(uint8_t sync) {
  * @see MPU6050_CFG_DLPF_CFG_LENGTH
  */
 uint8_t MPU6050_getDLPFMode() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_CONFIG, MPU6050_CFG_DLPF_CFG_BIT, MPU6050_CFG_DLPF_CFG_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -223,6 +547,8 @@ void MPU6050_setDLPFMode(uint8_t mode) {
  * @see MPU6050_GCONFIG_FS_SEL_LENGTH
  */
 uint8_t MPU6050_getFullScaleGyroRange() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_GYRO_CONFIG, MPU6050_GCONFIG_FS_SEL_BIT, MPU6050_GCONFIG_FS_SEL_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -245,6 +571,8 @@ void MPU6050_setFullScaleGyroRange(uint8_t range) {
  * @see MPU6050_RA_SELF_TEST_X
  */
 uint8_t MPU6050_getAccelXSelfTestFactoryTrim() {
+    uint8_t buffer[2] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_X, &buffer[0], I2C_MASTER_TIMEOUT_MS);
 	I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_A, &buffer[1], I2C_MASTER_TIMEOUT_MS);	
     return (buffer[0]>>3) | ((buffer[1]>>4) & 0x03);
@@ -255,6 +583,8 @@ uint8_t MPU6050_getAccelXSelfTestFactoryTrim() {
  * @see MPU6050_RA_SELF_TEST_Y
  */
 uint8_t MPU6050_getAccelYSelfTestFactoryTrim() {
+    uint8_t buffer[2] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_Y, &buffer[0], I2C_MASTER_TIMEOUT_MS);
 	I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_A, &buffer[1], I2C_MASTER_TIMEOUT_MS);	
     return (buffer[0]>>3) | ((buffer[1]>>2) & 0x03);
@@ -265,6 +595,8 @@ uint8_t MPU6050_getAccelYSelfTestFactoryTrim() {
  * @see MPU6050_RA_SELF_TEST_Z
  */
 uint8_t MPU6050_getAccelZSelfTestFactoryTrim() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_SELF_TEST_Z, 2, buffer, I2C_MASTER_TIMEOUT_MS);	
     return (buffer[0]>>3) | (buffer[1] & 0x03);
 }
@@ -274,6 +606,8 @@ uint8_t MPU6050_getAccelZSelfTestFactoryTrim() {
  * @see MPU6050_RA_SELF_TEST_X
  */
 uint8_t MPU6050_getGyroXSelfTestFactoryTrim() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_X, buffer, I2C_MASTER_TIMEOUT_MS);	
     return (buffer[0] & 0x1F);
 }
@@ -283,6 +617,8 @@ uint8_t MPU6050_getGyroXSelfTestFactoryTrim() {
  * @see MPU6050_RA_SELF_TEST_Y
  */
 uint8_t MPU6050_getGyroYSelfTestFactoryTrim() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_Y, buffer, I2C_MASTER_TIMEOUT_MS);	
     return (buffer[0] & 0x1F);
 }
@@ -292,6 +628,8 @@ uint8_t MPU6050_getGyroYSelfTestFactoryTrim() {
  * @see MPU6050_RA_SELF_TEST_Z
  */
 uint8_t MPU6050_getGyroZSelfTestFactoryTrim() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_SELF_TEST_Z, buffer, I2C_MASTER_TIMEOUT_MS);	
     return (buffer[0] & 0x1F);
 }
@@ -303,6 +641,8 @@ uint8_t MPU6050_getGyroZSelfTestFactoryTrim() {
  * @see MPU6050_RA_ACCEL_CONFIG
  */
 bool MPU6050_getAccelXSelfTest() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_ACCEL_CONFIG, MPU6050_ACONFIG_XA_ST_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -318,6 +658,8 @@ void MPU6050_setAccelXSelfTest(bool enabled) {
  * @see MPU6050_RA_ACCEL_CONFIG
  */
 bool MPU6050_getAccelYSelfTest() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_ACCEL_CONFIG, MPU6050_ACONFIG_YA_ST_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -333,6 +675,8 @@ void MPU6050_setAccelYSelfTest(bool enabled) {
  * @see MPU6050_RA_ACCEL_CONFIG
  */
 bool MPU6050_getAccelZSelfTest() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_ACCEL_CONFIG, MPU6050_ACONFIG_ZA_ST_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -361,6 +705,8 @@ void MPU6050_setAccelZSelfTest(bool enabled) {
  * @see MPU6050_ACONFIG_AFS_SEL_LENGTH
  */
 uint8_t MPU6050_getFullScaleAccelRange() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_ACCEL_CONFIG, MPU6050_ACONFIG_AFS_SEL_BIT, MPU6050_ACONFIG_AFS_SEL_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -407,6 +753,8 @@ void MPU6050_setFullScaleAccelRange(uint8_t range) {
  * @see MPU6050_RA_ACCEL_CONFIG
  */
 uint8_t MPU6050_getDHPFMode() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_ACCEL_CONFIG, MPU6050_ACONFIG_ACCEL_HPF_BIT, MPU6050_ACONFIG_ACCEL_HPF_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -438,6 +786,8 @@ void MPU6050_setDHPFMode(uint8_t bandwidth) {
  * @see MPU6050_RA_FF_THR
  */
 uint8_t MPU6050_getFreefallDetectionThreshold() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_FF_THR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -470,6 +820,8 @@ void MPU6050_setFreefallDetectionThreshold(uint8_t threshold) {
  * @see MPU6050_RA_FF_DUR
  */
 uint8_t MPU6050_getFreefallDetectionDuration() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_FF_DUR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -504,6 +856,8 @@ void MPU6050_setFreefallDetectionDuration(uint8_t duration) {
  * @see MPU6050_RA_MOT_THR
  */
 uint8_t MPU6050_getMotionDetectionThreshold() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_MOT_THR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -534,6 +888,8 @@ void MPU6050_setMotionDetectionThreshold(uint8_t threshold) {
  * @see MPU6050_RA_MOT_DUR
  */
 uint8_t MPU6050_getMotionDetectionDuration() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_MOT_DUR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -574,6 +930,8 @@ void MPU6050_setMotionDetectionDuration(uint8_t duration) {
  * @see MPU6050_RA_ZRMOT_THR
  */
 uint8_t MPU6050_getZeroMotionDetectionThreshold() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_ZRMOT_THR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -605,6 +963,8 @@ void MPU6050_setZeroMotionDetectionThreshold(uint8_t threshold) {
  * @see MPU6050_RA_ZRMOT_DUR
  */
 uint8_t MPU6050_getZeroMotionDetectionDuration() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_ZRMOT_DUR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -626,6 +986,8 @@ void MPU6050_setZeroMotionDetectionDuration(uint8_t duration) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getTempFIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_TEMP_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -644,6 +1006,8 @@ void MPU6050_setTempFIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getXGyroFIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_XG_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -662,6 +1026,8 @@ void MPU6050_setXGyroFIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getYGyroFIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_YG_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -680,6 +1046,8 @@ void MPU6050_setYGyroFIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getZGyroFIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_ZG_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -699,6 +1067,8 @@ void MPU6050_setZGyroFIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getAccelFIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_ACCEL_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -717,6 +1087,8 @@ void MPU6050_setAccelFIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getSlave2FIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_SLV2_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -735,6 +1107,8 @@ void MPU6050_setSlave2FIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getSlave1FIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_SLV1_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -753,6 +1127,8 @@ void MPU6050_setSlave1FIFOEnabled(bool enabled) {
  * @see MPU6050_RA_FIFO_EN
  */
 bool MPU6050_getSlave0FIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_FIFO_EN, MPU6050_SLV0_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -783,6 +1159,8 @@ void MPU6050_setSlave0FIFOEnabled(bool enabled) {
  * @see MPU6050_RA_I2C_MST_CTRL
  */
 bool MPU6050_getMultiMasterEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_CTRL, MPU6050_MULT_MST_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -806,6 +1184,8 @@ void MPU6050_setMultiMasterEnabled(bool enabled) {
  * @see MPU6050_RA_I2C_MST_CTRL
  */
 bool MPU6050_getWaitForExternalSensorEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_CTRL, MPU6050_WAIT_FOR_ES_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -824,6 +1204,8 @@ void MPU6050_setWaitForExternalSensorEnabled(bool enabled) {
  * @see MPU6050_RA_MST_CTRL
  */
 bool MPU6050_getSlave3FIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_CTRL, MPU6050_SLV_3_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -846,6 +1228,8 @@ void MPU6050_setSlave3FIFOEnabled(bool enabled) {
  * @see MPU6050_RA_I2C_MST_CTRL
  */
 bool MPU6050_getSlaveReadWriteTransitionEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_CTRL, MPU6050_I2C_MST_P_NSR_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -887,6 +1271,8 @@ void MPU6050_setSlaveReadWriteTransitionEnabled(bool enabled) {
  * @see MPU6050_RA_I2C_MST_CTRL
  */
 uint8_t MPU6050_getMasterClockSpeed() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_I2C_MST_CTRL, MPU6050_I2C_MST_CLK_BIT, MPU6050_I2C_MST_CLK_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -942,6 +1328,8 @@ void MPU6050_setMasterClockSpeed(uint8_t speed) {
  * @see MPU6050_RA_I2C_SLV0_ADDR
  */
 uint8_t MPU6050_getSlaveAddress(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readByte(devAddr, MPU6050_RA_I2C_SLV0_ADDR + num*3, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -968,6 +1356,8 @@ void MPU6050_setSlaveAddress(uint8_t num, uint8_t address) {
  * @see MPU6050_RA_I2C_SLV0_REG
  */
 uint8_t MPU6050_getSlaveRegister(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readByte(devAddr, MPU6050_RA_I2C_SLV0_REG + num*3, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -990,6 +1380,8 @@ void MPU6050_setSlaveRegister(uint8_t num, uint8_t reg) {
  * @see MPU6050_RA_I2C_SLV0_CTRL
  */
 bool MPU6050_getSlaveEnabled(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV0_CTRL + num*3, MPU6050_I2C_SLV_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -1016,6 +1408,8 @@ void MPU6050_setSlaveEnabled(uint8_t num, bool enabled) {
  * @see MPU6050_RA_I2C_SLV0_CTRL
  */
 bool MPU6050_getSlaveWordByteSwap(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV0_CTRL + num*3, MPU6050_I2C_SLV_BYTE_SW_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -1041,6 +1435,8 @@ void MPU6050_setSlaveWordByteSwap(uint8_t num, bool enabled) {
  * @see MPU6050_RA_I2C_SLV0_CTRL
  */
 bool MPU6050_getSlaveWriteMode(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV0_CTRL + num*3, MPU6050_I2C_SLV_REG_DIS_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -1067,6 +1463,8 @@ void MPU6050_setSlaveWriteMode(uint8_t num, bool mode) {
  * @see MPU6050_RA_I2C_SLV0_CTRL
  */
 bool MPU6050_getSlaveWordGroupOffset(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV0_CTRL + num*3, MPU6050_I2C_SLV_GRP_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -1089,6 +1487,8 @@ void MPU6050_setSlaveWordGroupOffset(uint8_t num, bool enabled) {
  * @see MPU6050_RA_I2C_SLV0_CTRL
  */
 uint8_t MPU6050_getSlaveDataLength(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     if (num > 3) return 0;
     I2C_readBits(devAddr, MPU6050_RA_I2C_SLV0_CTRL + num*3, MPU6050_I2C_SLV_LEN_BIT, MPU6050_I2C_SLV_LEN_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
@@ -1116,6 +1516,8 @@ void MPU6050_setSlaveDataLength(uint8_t num, uint8_t length) {
  * @see MPU6050_RA_I2C_SLV4_ADDR
  */
 uint8_t MPU6050_getSlave4Address() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_I2C_SLV4_ADDR, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1135,6 +1537,8 @@ void MPU6050_setSlave4Address(uint8_t address) {
  * @see MPU6050_RA_I2C_SLV4_REG
  */
 uint8_t MPU6050_getSlave4Register() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_I2C_SLV4_REG, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1162,6 +1566,8 @@ void MPU6050_setSlave4OutputByte(uint8_t data) {
  * @see MPU6050_RA_I2C_SLV4_CTRL
  */
 bool MPU6050_getSlave4Enabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV4_CTRL, MPU6050_I2C_SLV4_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1183,6 +1589,8 @@ void MPU6050_setSlave4Enabled(bool enabled) {
  * @see MPU6050_RA_I2C_SLV4_CTRL
  */
 bool MPU6050_getSlave4InterruptEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV4_CTRL, MPU6050_I2C_SLV4_INT_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1204,6 +1612,8 @@ void MPU6050_setSlave4InterruptEnabled(bool enabled) {
  * @see MPU6050_RA_I2C_SLV4_CTRL
  */
 bool MPU6050_getSlave4WriteMode() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_SLV4_CTRL, MPU6050_I2C_SLV4_REG_DIS_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1231,6 +1641,8 @@ void MPU6050_setSlave4WriteMode(bool mode) {
  * @see MPU6050_RA_I2C_SLV4_CTRL
  */
 uint8_t MPU6050_getSlave4MasterDelay() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_I2C_SLV4_CTRL, MPU6050_I2C_SLV4_MST_DLY_BIT, MPU6050_I2C_SLV4_MST_DLY_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1249,6 +1661,8 @@ void MPU6050_setSlave4MasterDelay(uint8_t delay) {
  * @see MPU6050_RA_I2C_SLV4_DI
  */
 uint8_t MPU6050_getSlate4InputByte() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_I2C_SLV4_DI, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1265,6 +1679,8 @@ uint8_t MPU6050_getSlate4InputByte() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getPassthroughStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_PASS_THROUGH_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1277,6 +1693,8 @@ bool MPU6050_getPassthroughStatus() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getSlave4IsDone() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_SLV4_DONE_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1288,6 +1706,8 @@ bool MPU6050_getSlave4IsDone() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getLostArbitration() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_LOST_ARB_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1299,6 +1719,8 @@ bool MPU6050_getLostArbitration() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getSlave4Nack() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_SLV4_NACK_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1310,6 +1732,8 @@ bool MPU6050_getSlave4Nack() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getSlave3Nack() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_SLV3_NACK_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1321,6 +1745,8 @@ bool MPU6050_getSlave3Nack() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getSlave2Nack() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_SLV2_NACK_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1332,6 +1758,8 @@ bool MPU6050_getSlave2Nack() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getSlave1Nack() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_SLV1_NACK_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1343,6 +1771,8 @@ bool MPU6050_getSlave1Nack() {
  * @see MPU6050_RA_I2C_MST_STATUS
  */
 bool MPU6050_getSlave0Nack() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_STATUS, MPU6050_MST_I2C_SLV0_NACK_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1356,6 +1786,8 @@ bool MPU6050_getSlave0Nack() {
  * @see MPU6050_INTCFG_INT_LEVEL_BIT
  */
 bool MPU6050_getInterruptMode() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_INT_LEVEL_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1375,6 +1807,8 @@ void MPU6050_setInterruptMode(bool mode) {
  * @see MPU6050_INTCFG_INT_OPEN_BIT
  */
 bool MPU6050_getInterruptDrive() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_INT_OPEN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1394,6 +1828,8 @@ void MPU6050_setInterruptDrive(bool drive) {
  * @see MPU6050_INTCFG_LATCH_INT_EN_BIT
  */
 bool MPU6050_getInterruptLatch() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_LATCH_INT_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1413,6 +1849,8 @@ void MPU6050_setInterruptLatch(bool latch) {
  * @see MPU6050_INTCFG_INT_RD_CLEAR_BIT
  */
 bool MPU6050_getInterruptLatchClear() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_INT_RD_CLEAR_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1432,6 +1870,8 @@ void MPU6050_setInterruptLatchClear(bool clear) {
  * @see MPU6050_INTCFG_FSYNC_INT_LEVEL_BIT
  */
 bool MPU6050_getFSyncInterruptLevel() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_FSYNC_INT_LEVEL_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1451,6 +1891,8 @@ void MPU6050_setFSyncInterruptLevel(bool level) {
  * @see MPU6050_INTCFG_FSYNC_INT_EN_BIT
  */
 bool MPU6050_getFSyncInterruptEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_FSYNC_INT_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1475,6 +1917,8 @@ void MPU6050_setFSyncInterruptEnabled(bool enabled) {
  * @see MPU6050_INTCFG_I2C_BYPASS_EN_BIT
  */
 bool MPU6050_getI2CBypassEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_I2C_BYPASS_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1502,6 +1946,8 @@ void MPU6050_setI2CBypassEnabled(bool enabled) {
  * @see MPU6050_INTCFG_CLKOUT_EN_BIT
  */
 bool MPU6050_getClockOutputEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_PIN_CFG, MPU6050_INTCFG_CLKOUT_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1528,6 +1974,8 @@ void MPU6050_setClockOutputEnabled(bool enabled) {
  * @see MPU6050_INTERRUPT_FF_BIT
  **/
 uint8_t MPU6050_getIntEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_INT_ENABLE, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1549,6 +1997,8 @@ void MPU6050_setIntEnabled(uint8_t enabled) {
  * @see MPU6050_INTERRUPT_FF_BIT
  **/
 bool MPU6050_getIntFreefallEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_FF_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1568,6 +2018,8 @@ void MPU6050_setIntFreefallEnabled(bool enabled) {
  * @see MPU6050_INTERRUPT_MOT_BIT
  **/
 bool MPU6050_getIntMotionEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_MOT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1587,6 +2039,8 @@ void MPU6050_setIntMotionEnabled(bool enabled) {
  * @see MPU6050_INTERRUPT_ZMOT_BIT
  **/
 bool MPU6050_getIntZeroMotionEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_ZMOT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1606,6 +2060,8 @@ void MPU6050_setIntZeroMotionEnabled(bool enabled) {
  * @see MPU6050_INTERRUPT_FIFO_OFLOW_BIT
  **/
 bool MPU6050_getIntFIFOBufferOverflowEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_FIFO_OFLOW_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1626,6 +2082,8 @@ void MPU6050_setIntFIFOBufferOverflowEnabled(bool enabled) {
  * @see MPU6050_INTERRUPT_I2C_MST_INT_BIT
  **/
 bool MPU6050_getIntI2CMasterEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_I2C_MST_INT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1646,6 +2104,8 @@ void MPU6050_setIntI2CMasterEnabled(bool enabled) {
  * @see MPU6050_INTERRUPT_DATA_RDY_BIT
  */
 bool MPU6050_getIntDataReadyEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_DATA_RDY_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1669,6 +2129,8 @@ void MPU6050_setIntDataReadyEnabled(bool enabled) {
  * @see MPU6050_RA_INT_STATUS
  */
 uint8_t MPU6050_getIntStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_INT_STATUS, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1680,6 +2142,8 @@ uint8_t MPU6050_getIntStatus() {
  * @see MPU6050_INTERRUPT_FF_BIT
  */
 bool MPU6050_getIntFreefallStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_STATUS, MPU6050_INTERRUPT_FF_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1691,6 +2155,8 @@ bool MPU6050_getIntFreefallStatus() {
  * @see MPU6050_INTERRUPT_MOT_BIT
  */
 bool MPU6050_getIntMotionStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_STATUS, MPU6050_INTERRUPT_MOT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1702,6 +2168,8 @@ bool MPU6050_getIntMotionStatus() {
  * @see MPU6050_INTERRUPT_ZMOT_BIT
  */
 bool MPU6050_getIntZeroMotionStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_STATUS, MPU6050_INTERRUPT_ZMOT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1713,6 +2181,8 @@ bool MPU6050_getIntZeroMotionStatus() {
  * @see MPU6050_INTERRUPT_FIFO_OFLOW_BIT
  */
 bool MPU6050_getIntFIFOBufferOverflowStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_STATUS, MPU6050_INTERRUPT_FIFO_OFLOW_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1725,6 +2195,8 @@ bool MPU6050_getIntFIFOBufferOverflowStatus() {
  * @see MPU6050_INTERRUPT_I2C_MST_INT_BIT
  */
 bool MPU6050_getIntI2CMasterStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_STATUS, MPU6050_INTERRUPT_I2C_MST_INT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1736,6 +2208,8 @@ bool MPU6050_getIntI2CMasterStatus() {
  * @see MPU6050_INTERRUPT_DATA_RDY_BIT
  */
 bool MPU6050_getIntDataReadyStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_INT_STATUS, MPU6050_INTERRUPT_DATA_RDY_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -1775,6 +2249,8 @@ void MPU6050_getMotion9(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int1
  * @see MPU6050_RA_ACCEL_XOUT_H
  */
 void MPU6050_getMotion6(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int16_t* gy, int16_t* gz) {
+    uint8_t buffer[14] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_ACCEL_XOUT_H, 14, buffer, I2C_MASTER_TIMEOUT_MS);
     *ax = (((int16_t)buffer[0]) << 8) | buffer[1];
     *ay = (((int16_t)buffer[2]) << 8) | buffer[3];
@@ -1820,6 +2296,8 @@ void MPU6050_getMotion6(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int1
  * @see MPU6050_RA_GYRO_XOUT_H
  */
 void MPU6050_getAcceleration(int16_t* x, int16_t* y, int16_t* z) {
+    uint8_t buffer[6] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_ACCEL_XOUT_H, 6, buffer, I2C_MASTER_TIMEOUT_MS);
     *x = (((int16_t)buffer[0]) << 8) | buffer[1];
     *y = (((int16_t)buffer[2]) << 8) | buffer[3];
@@ -1831,6 +2309,8 @@ void MPU6050_getAcceleration(int16_t* x, int16_t* y, int16_t* z) {
  * @see MPU6050_RA_ACCEL_XOUT_H
  */
 int16_t MPU6050_getAccelerationX() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_ACCEL_XOUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -1840,6 +2320,8 @@ int16_t MPU6050_getAccelerationX() {
  * @see MPU6050_RA_ACCEL_YOUT_H
  */
 int16_t MPU6050_getAccelerationY() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_ACCEL_YOUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -1849,6 +2331,8 @@ int16_t MPU6050_getAccelerationY() {
  * @see MPU6050_RA_ACCEL_ZOUT_H
  */
 int16_t MPU6050_getAccelerationZ() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_ACCEL_ZOUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -1860,6 +2344,8 @@ int16_t MPU6050_getAccelerationZ() {
  * @see MPU6050_RA_TEMP_OUT_H
  */
 int16_t MPU6050_getTemperature() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_TEMP_OUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -1899,6 +2385,8 @@ int16_t MPU6050_getTemperature() {
  * @see MPU6050_RA_GYRO_XOUT_H
  */
 void MPU6050_getRotation(int16_t* x, int16_t* y, int16_t* z) {
+    uint8_t buffer[6] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_GYRO_XOUT_H, 6, buffer, I2C_MASTER_TIMEOUT_MS);
     *x = (((int16_t)buffer[0]) << 8) | buffer[1];
     *y = (((int16_t)buffer[2]) << 8) | buffer[3];
@@ -1910,6 +2398,8 @@ void MPU6050_getRotation(int16_t* x, int16_t* y, int16_t* z) {
  * @see MPU6050_RA_GYRO_XOUT_H
  */
 int16_t MPU6050_getRotationX() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_GYRO_XOUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -1919,6 +2409,8 @@ int16_t MPU6050_getRotationX() {
  * @see MPU6050_RA_GYRO_YOUT_H
  */
 int16_t MPU6050_getRotationY() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_GYRO_YOUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -1928,6 +2420,8 @@ int16_t MPU6050_getRotationY() {
  * @see MPU6050_RA_GYRO_ZOUT_H
  */
 int16_t MPU6050_getRotationZ() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_GYRO_ZOUT_H, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((int16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -2009,6 +2503,8 @@ int16_t MPU6050_getRotationZ() {
  * @return Byte read from register
  */
 uint8_t MPU6050_getExternalSensorByte(int position) {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_EXT_SENS_DATA_00 + position, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2018,6 +2514,8 @@ uint8_t MPU6050_getExternalSensorByte(int position) {
  * @see getExternalSensorByte()
  */
 uint16_t MPU6050_getExternalSensorWord(int position) {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_EXT_SENS_DATA_00 + position, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((uint16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -2027,6 +2525,8 @@ uint16_t MPU6050_getExternalSensorWord(int position) {
  * @see getExternalSensorByte()
  */
 uint32_t MPU6050_getExternalSensorDWord(int position) {
+    uint8_t buffer[4] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_EXT_SENS_DATA_00 + position, 4, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((uint32_t)buffer[0]) << 24) | (((uint32_t)buffer[1]) << 16) | (((uint16_t)buffer[2]) << 8) | buffer[3];
 }
@@ -2038,6 +2538,8 @@ uint32_t MPU6050_getExternalSensorDWord(int position) {
  * @see MPU6050_RA_MOT_DETECT_STATUS
  */
 uint8_t MPU6050_getMotionStatus() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_MOT_DETECT_STATUS, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2047,6 +2549,8 @@ uint8_t MPU6050_getMotionStatus() {
  * @see MPU6050_MOTION_MOT_XNEG_BIT
  */
 bool MPU6050_getXNegMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_XNEG_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2056,6 +2560,8 @@ bool MPU6050_getXNegMotionDetected() {
  * @see MPU6050_MOTION_MOT_XPOS_BIT
  */
 bool MPU6050_getXPosMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_XPOS_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2065,6 +2571,8 @@ bool MPU6050_getXPosMotionDetected() {
  * @see MPU6050_MOTION_MOT_YNEG_BIT
  */
 bool MPU6050_getYNegMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_YNEG_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2074,6 +2582,8 @@ bool MPU6050_getYNegMotionDetected() {
  * @see MPU6050_MOTION_MOT_YPOS_BIT
  */
 bool MPU6050_getYPosMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_YPOS_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2083,6 +2593,8 @@ bool MPU6050_getYPosMotionDetected() {
  * @see MPU6050_MOTION_MOT_ZNEG_BIT
  */
 bool MPU6050_getZNegMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_ZNEG_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2092,6 +2604,8 @@ bool MPU6050_getZNegMotionDetected() {
  * @see MPU6050_MOTION_MOT_ZPOS_BIT
  */
 bool MPU6050_getZPosMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_ZPOS_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2101,6 +2615,8 @@ bool MPU6050_getZPosMotionDetected() {
  * @see MPU6050_MOTION_MOT_ZRMOT_BIT
  */
 bool MPU6050_getZeroMotionDetected() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_MOT_DETECT_STATUS, MPU6050_MOTION_MOT_ZRMOT_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2131,6 +2647,8 @@ void MPU6050_setSlaveOutputByte(uint8_t num, uint8_t data) {
  * @see MPU6050_DELAYCTRL_DELAY_ES_SHADOW_BIT
  */
 bool MPU6050_getExternalShadowDelayEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_DELAY_CTRL, MPU6050_DELAYCTRL_DELAY_ES_SHADOW_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2162,6 +2680,8 @@ void MPU6050_setExternalShadowDelayEnabled(bool enabled) {
  * @see MPU6050_DELAYCTRL_I2C_SLV0_DLY_EN_BIT
  */
 bool MPU6050_getSlaveDelayEnabled(uint8_t num) {
+    uint8_t buffer[1] = {0};
+
     // MPU6050_DELAYCTRL_I2C_SLV4_DLY_EN_BIT is 4, SLV3 is 3, etc.
     if (num > 4) return 0;
     I2C_readBit(devAddr, MPU6050_RA_I2C_MST_DELAY_CTRL, num, buffer, I2C_MASTER_TIMEOUT_MS);
@@ -2224,6 +2744,8 @@ void MPU6050_resetTemperaturePath() {
  * @see MPU6050_DETECT_ACCEL_ON_DELAY_BIT
  */
 uint8_t MPU6050_getAccelerometerPowerOnDelay() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_MOT_DETECT_CTRL, MPU6050_DETECT_ACCEL_ON_DELAY_BIT, MPU6050_DETECT_ACCEL_ON_DELAY_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2263,6 +2785,8 @@ void MPU6050_setAccelerometerPowerOnDelay(uint8_t delay) {
  * @see MPU6050_DETECT_FF_COUNT_BIT
  */
 uint8_t MPU6050_getFreefallDetectionCounterDecrement() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_MOT_DETECT_CTRL, MPU6050_DETECT_FF_COUNT_BIT, MPU6050_DETECT_FF_COUNT_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2299,6 +2823,8 @@ void MPU6050_setFreefallDetectionCounterDecrement(uint8_t decrement) {
  *
  */
 uint8_t MPU6050_getMotionDetectionCounterDecrement() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_MOT_DETECT_CTRL, MPU6050_DETECT_MOT_COUNT_BIT, MPU6050_DETECT_MOT_COUNT_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2323,6 +2849,8 @@ void MPU6050_setMotionDetectionCounterDecrement(uint8_t decrement) {
  * @see MPU6050_USERCTRL_FIFO_EN_BIT
  */
 bool MPU6050_getFIFOEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_FIFO_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2347,6 +2875,8 @@ void MPU6050_setFIFOEnabled(bool enabled) {
  * @see MPU6050_USERCTRL_I2C_MST_EN_BIT
  */
 bool MPU6050_getI2CMasterModeEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_I2C_MST_EN_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2409,6 +2939,8 @@ void MPU6050_resetSensors() {
  */
 void MPU6050_reset() {
     I2C_writeBit(devAddr, MPU6050_RA_PWR_MGMT_1, MPU6050_PWR1_DEVICE_RESET_BIT, true);
+    /* Every register goes back to its default value */
+    I2C_shadowInvalidate(devAddr);
 }
 /** Get sleep mode status.
  * Setting the SLEEP bit in the register puts the device into very low power
@@ -2422,6 +2954,8 @@ void MPU6050_reset() {
  * @see MPU6050_PWR1_SLEEP_BIT
  */
 bool MPU6050_getSleepEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_1, MPU6050_PWR1_SLEEP_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2443,6 +2977,8 @@ void MPU6050_setSleepEnabled(bool enabled) {
  * @see MPU6050_PWR1_CYCLE_BIT
  */
 bool MPU6050_getWakeCycleEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_1, MPU6050_PWR1_CYCLE_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2467,6 +3003,8 @@ void MPU6050_setWakeCycleEnabled(bool enabled) {
  * @see MPU6050_PWR1_TEMP_DIS_BIT
  */
 bool MPU6050_getTempSensorEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_1, MPU6050_PWR1_TEMP_DIS_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0] == 0; // 1 is actually disabled here
 }
@@ -2491,6 +3029,8 @@ void MPU6050_setTempSensorEnabled(bool enabled) {
  * @see MPU6050_PWR1_CLKSEL_LENGTH
  */
 uint8_t MPU6050_getClockSource() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_PWR_MGMT_1, MPU6050_PWR1_CLKSEL_BIT, MPU6050_PWR1_CLKSEL_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2554,6 +3094,8 @@ void MPU6050_setClockSource(uint8_t source) {
  * @see MPU6050_RA_PWR_MGMT_2
  */
 uint8_t MPU6050_getWakeFrequency() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_LP_WAKE_CTRL_BIT, MPU6050_PWR2_LP_WAKE_CTRL_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2572,6 +3114,8 @@ void MPU6050_setWakeFrequency(uint8_t frequency) {
  * @see MPU6050_PWR2_STBY_XA_BIT
  */
 bool MPU6050_getStandbyXAccelEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_STBY_XA_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2591,6 +3135,8 @@ void MPU6050_setStandbyXAccelEnabled(bool enabled) {
  * @see MPU6050_PWR2_STBY_YA_BIT
  */
 bool MPU6050_getStandbyYAccelEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_STBY_YA_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2610,6 +3156,8 @@ void MPU6050_setStandbyYAccelEnabled(bool enabled) {
  * @see MPU6050_PWR2_STBY_ZA_BIT
  */
 bool MPU6050_getStandbyZAccelEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_STBY_ZA_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2629,6 +3177,8 @@ void MPU6050_setStandbyZAccelEnabled(bool enabled) {
  * @see MPU6050_PWR2_STBY_XG_BIT
  */
 bool MPU6050_getStandbyXGyroEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_STBY_XG_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2648,6 +3198,8 @@ void MPU6050_setStandbyXGyroEnabled(bool enabled) {
  * @see MPU6050_PWR2_STBY_YG_BIT
  */
 bool MPU6050_getStandbyYGyroEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_STBY_YG_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2667,6 +3219,8 @@ void MPU6050_setStandbyYGyroEnabled(bool enabled) {
  * @see MPU6050_PWR2_STBY_ZG_BIT
  */
 bool MPU6050_getStandbyZGyroEnabled() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBit(devAddr, MPU6050_RA_PWR_MGMT_2, MPU6050_PWR2_STBY_ZG_BIT, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2690,6 +3244,8 @@ void MPU6050_setStandbyZGyroEnabled(bool enabled) {
  * @return Current FIFO buffer size
  */
 uint16_t MPU6050_getFIFOCount() {
+    uint8_t buffer[2] = {0};
+
     I2C_readBytes(devAddr, MPU6050_RA_FIFO_COUNTH, 2, buffer, I2C_MASTER_TIMEOUT_MS);
     return (((uint16_t)buffer[0]) << 8) | buffer[1];
 }
@@ -2722,6 +3278,8 @@ uint16_t MPU6050_getFIFOCount() {
  * @return Byte from FIFO buffer
  */
 uint8_t MPU6050_getFIFOByte() {
+    uint8_t buffer[1] = {0};
+
     I2C_readByte(devAddr, MPU6050_RA_FIFO_R_W, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2750,6 +3308,8 @@ void MPU6050_setFIFOByte(uint8_t data) {
  * @see MPU6050_WHO_AM_I_LENGTH
  */
 uint8_t MPU6050_getDeviceID() {
+    uint8_t buffer[1] = {0};
+
     I2C_readBits(devAddr, MPU6050_RA_WHO_AM_I, MPU6050_WHO_AM_I_BIT, MPU6050_WHO_AM_I_LENGTH, buffer, I2C_MASTER_TIMEOUT_MS);
     return buffer[0];
 }
@@ -2766,4 +3326,410 @@ void MPU6050_setDeviceID(uint8_t id) {
     I2C_writeBits(devAddr, MPU6050_RA_WHO_AM_I, MPU6050_WHO_AM_I_BIT, MPU6050_WHO_AM_I_LENGTH, id);
 }
 
+bool MPU6050_streamStart(mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate) {
+    bool success;
+
+    if (!MPU6050_streamValid(samples, size, contents)) {
+        return false;
+    }
+    success = MPU6050_streamConfig(devAddr, stream, samples, size, contents, dlpf, rate);
+    MPU6050_fifoRestart(devAddr);
+    return success;
+}
+
+uint16_t MPU6050_streamRead(mpu6050_stream_t *stream) {
+    uint16_t frames, moved = 0, burst;
+    int64_t next_time;
+
+    frames = MPU6050_streamPending(stream, &next_time);
+    while (moved < frames) {
+        burst = MPU6050_streamBurst(stream, frames - moved, &next_time);
+        /* A failed read leaves the rest in the FIFO for the next call */
+        if (burst == 0) {
+            break;
+        }
+        moved += burst;
+    }
+    return moved;
+}
+
+bool MPU6050_streamGet(mpu6050_stream_t *stream, mpu6050_sample_t *sample) {
+    if (stream->tail == stream->head) {
+        return false;
+    }
+    *sample = stream->samples[stream->tail];
+    stream->tail = (stream->tail + 1) % stream->size;
+    return true;
+}
+
+void MPU6050_streamStop() {
+    MPU6050_fifoStop(devAddr);
+}
+
+bool MPU6050_dataReadyStart(mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t dlpf, uint8_t rate, gpio_t int_pin, uint8_t priority) {
+    return MPU6050_dataReadySetup(devAddr, stream, samples, size, dlpf, rate, int_pin, priority);
+}
+
+void MPU6050_dataReadyStop() {
+    MPU6050_dataReadyEnd(devAddr);
+}
+
+bool MPU6050_deviceInit(mpu6050_t *dev, uint8_t address) {
+    const mpu6050_config_t config = MPU6050_CONFIG_DEFAULT;
+
+    dev->devAddr = address;
+    I2C_shadowInit(&dev->shadow, address, volatile_regs, sizeof(volatile_regs) / sizeof(volatile_regs[0]));
+    return MPU6050_configApply(address, &config);
+}
+
+bool MPU6050_deviceConfigure(mpu6050_t *dev, const mpu6050_config_t *config) {
+    return MPU6050_configApply(dev->devAddr, config);
+}
+
+bool MPU6050_deviceRead(const mpu6050_t *dev, uint8_t reg, uint8_t *data, uint8_t len) {
+    return I2C_readBytes(dev->devAddr, reg, len, data, I2C_MASTER_TIMEOUT_MS) == len;
+}
+
+bool MPU6050_deviceGetMotion6(const mpu6050_t *dev, mpu6050_sample_t *sample) {
+    uint8_t data[14];
+    int64_t timestamp = esp_timer_get_time();
+
+    if (I2C_readBytes(dev->devAddr, MPU6050_RA_ACCEL_XOUT_H, 14, data, I2C_MASTER_TIMEOUT_MS) != 14) {
+        return false;
+    }
+    MPU6050_motionParse(data, sample);
+    sample->timestamp = timestamp;
+    return true;
+}
+
+bool MPU6050_deviceStreamStart(mpu6050_t *dev, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate) {
+    bool success;
+
+    if (!MPU6050_streamValid(samples, size, contents)) {
+        return false;
+    }
+    success = MPU6050_streamConfig(dev->devAddr, stream, samples, size, contents, dlpf, rate);
+    MPU6050_fifoRestart(dev->devAddr);
+    return success;
+}
+
+void MPU6050_deviceStreamStop(mpu6050_t *dev) {
+    MPU6050_fifoStop(dev->devAddr);
+}
+
+bool MPU6050_deviceDataReadyStart(mpu6050_t *dev, mpu6050_stream_t *stream, mpu6050_sample_t *samples, uint16_t size, uint8_t dlpf, uint8_t rate, gpio_t int_pin, uint8_t priority) {
+    return MPU6050_dataReadySetup(dev->devAddr, stream, samples, size, dlpf, rate, int_pin, priority);
+}
+
+void MPU6050_deviceDataReadyStop(mpu6050_t *dev) {
+    MPU6050_dataReadyEnd(dev->devAddr);
+}
+
+bool MPU6050_groupInit(mpu6050_group_t *group, mpu6050_t *const devices[], uint8_t count, uint8_t priority) {
+    if (count == 0 || count > MPU6050_GROUP_SIZE) {
+        return false;
+    }
+    memset(group, 0, sizeof(mpu6050_group_t));
+    group->count = count;
+    for (uint8_t i = 0; i < count; i++) {
+        group->devices[i] = devices[i];
+        group->trans[i].type = I2C_TRANS_READ;
+        group->trans[i].devAddr = devices[i]->devAddr;
+        group->trans[i].regAddr = MPU6050_RA_ACCEL_XOUT_H;
+        group->trans[i].length = 14;
+        group->trans[i].data = group->data[i];
+        group->trans[i].priority = priority;
+    }
+    return true;
+}
+
+bool MPU6050_groupSample(mpu6050_group_t *group, mpu6050_sample_t samples[]) {
+    i2c_trans_t *last = &group->trans[group->count - 1];
+    int64_t timestamp;
+    bool success = true;
+
+    /* Transactions are made in order: the last one ends after all the others */
+    last->task = xTaskGetCurrentTaskHandle();
+    timestamp = esp_timer_get_time();
+    if (!I2C_queueTransfers(group->trans, group->count)) {
+        return false;
+    }
+    while (!last->done) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    for (uint8_t i = 0; i < group->count; i++) {
+        success &= group->trans[i].success;
+        MPU6050_motionParse(group->data[i], &samples[i]);
+        samples[i].timestamp = timestamp;
+    }
+    return success;
+}
+
+bool MPU6050_groupStreamStart(mpu6050_group_t *group, mpu6050_sample_t *const samples[], uint16_t size, uint8_t contents, uint8_t dlpf, uint8_t rate) {
+    bool success = true;
+    uint8_t i;
+
+    for (i = 0; i < group->count; i++) {
+        if (!MPU6050_streamValid(samples[i], size, contents)) {
+            return false;
+        }
+    }
+    for (i = 0; i < group->count; i++) {
+        success &= MPU6050_streamConfig(group->devices[i]->devAddr, &group->streams[i], samples[i], size, contents, dlpf, rate);
+    }
+    for (i = 0; i < group->count; i++) {
+        MPU6050_fifoRestart(group->devices[i]->devAddr);
+    }
+    group->dropped = 0;
+    return success;
+}
+
+uint16_t MPU6050_groupStreamRead(mpu6050_group_t *group) {
+    uint16_t frames[MPU6050_GROUP_SIZE], moved[MPU6050_GROUP_SIZE], total = 0, burst;
+    int64_t next_time[MPU6050_GROUP_SIZE];
+    bool pending;
+    uint8_t i;
+
+    for (i = 0; i < group->count; i++) {
+        frames[i] = MPU6050_streamPending(&group->streams[i], &next_time[i]);
+        moved[i] = 0;
+    }
+    do {
+        pending = false;
+        for (i = 0; i < group->count; i++) {
+            if (moved[i] < frames[i]) {
+                burst = MPU6050_streamBurst(&group->streams[i], frames[i] - moved[i], &next_time[i]);
+                moved[i] += burst;
+                /* A failed read leaves the rest of that FIFO for the next call */
+                if (burst == 0) {
+                    frames[i] = moved[i];
+                }
+                pending |= moved[i] < frames[i];
+            }
+        }
+    } while (pending);
+    for (i = 0; i < group->count; i++) {
+        total += moved[i];
+    }
+    return total;
+}
+
+bool MPU6050_groupStreamGet(mpu6050_group_t *group, mpu6050_sample_t samples[]) {
+    mpu6050_stream_t *stream;
+    int64_t timestamp, oldest, newest;
+    uint8_t i, first;
+
+    while (true) {
+        for (i = 0; i < group->count; i++) {
+            if (group->streams[i].tail == group->streams[i].head) {
+                return false;
+            }
+        }
+        first = 0;
+        oldest = newest = group->streams[0].samples[group->streams[0].tail].timestamp;
+        for (i = 1; i < group->count; i++) {
+            timestamp = group->streams[i].samples[group->streams[i].tail].timestamp;
+            if (timestamp < oldest) {
+                oldest = timestamp;
+                first = i;
+            }
+            newest = (timestamp > newest) ? timestamp : newest;
+        }
+        /* Beyond the half period of the best match: timestamps are estimates, and a
+         * pair near half a period apart would drop samples of each sensor in turn */
+        if (newest - oldest <= group->streams[first].period * 3 / 4) {
+            break;
+        }
+        /* No sample of the other sensors that close: drop it */
+        stream = &group->streams[first];
+        stream->tail = (stream->tail + 1) % stream->size;
+        group->dropped++;
+    }
+    timestamp = 0;
+    for (i = 0; i < group->count; i++) {
+        MPU6050_streamGet(&group->streams[i], &samples[i]);
+        timestamp += samples[i].timestamp;
+    }
+    timestamp /= group->count;
+    for (i = 0; i < group->count; i++) {
+        samples[i].timestamp = timestamp;
+    }
+    return true;
+}
+
+void MPU6050_groupStreamStop(mpu6050_group_t *group) {
+    for (uint8_t i = 0; i < group->count; i++) {
+        MPU6050_fifoStop(group->devices[i]->devAddr);
+    }
+}
+
+void MPU6050_setMemoryBank(uint8_t bank, bool prefetchEnabled, bool userBank) {
+    bank &= 0x1F;
+    if (userBank) {
+        bank |= 1 << MPU6050_BANKSEL_CFG_USER_BANK_BIT;
+    }
+    if (prefetchEnabled) {
+        bank |= 1 << MPU6050_BANKSEL_PRFTCH_EN_BIT;
+    }
+    I2C_writeByte(devAddr, MPU6050_RA_BANK_SEL, bank);
+}
+
+void MPU6050_setMemoryStartAddress(uint8_t address) {
+    I2C_writeByte(devAddr, MPU6050_RA_MEM_START_ADDR, address);
+}
+
+uint8_t MPU6050_readMemoryByte() {
+    uint8_t data = 0;
+
+    I2C_readByte(devAddr, MPU6050_RA_MEM_R_W, &data, I2C_MASTER_TIMEOUT_MS);
+    return data;
+}
+
+void MPU6050_writeMemoryByte(uint8_t data) {
+    I2C_writeByte(devAddr, MPU6050_RA_MEM_R_W, data);
+}
+
+bool MPU6050_readMemoryBlock(uint8_t *data, uint16_t dataSize, uint8_t bank, uint8_t address) {
+    uint16_t i, chunk;
+
+    if ((uint32_t)bank * MPU6050_DMP_MEMORY_BANK_SIZE + address + dataSize > MPU6050_DMP_MEMORY_BANKS * MPU6050_DMP_MEMORY_BANK_SIZE) {
+        return false;
+    }
+    MPU6050_setMemoryBank(bank, false, false);
+    for (i = 0; i < dataSize; i += chunk) {
+        /* Chunks don't cross bank ends */
+        chunk = MPU6050_DMP_MEMORY_CHUNK_SIZE;
+        if (chunk > dataSize - i) {
+            chunk = dataSize - i;
+        }
+        if (chunk > MPU6050_DMP_MEMORY_BANK_SIZE - address) {
+            chunk = MPU6050_DMP_MEMORY_BANK_SIZE - address;
+        }
+        MPU6050_setMemoryStartAddress(address);
+        if (I2C_readBytes(devAddr, MPU6050_RA_MEM_R_W, chunk, &data[i], I2C_MASTER_TIMEOUT_MS) != chunk) {
+            return false;
+        }
+        address += chunk;
+        if (address == 0 && i + chunk < dataSize) {
+            MPU6050_setMemoryBank(++bank, false, false);
+        }
+    }
+    return true;
+}
+
+bool MPU6050_writeMemoryBlock(const uint8_t *data, uint16_t dataSize, uint8_t bank, uint8_t address, bool verify) {
+    uint8_t chunk_data[MPU6050_DMP_MEMORY_CHUNK_SIZE];
+    uint8_t verify_data[MPU6050_DMP_MEMORY_CHUNK_SIZE];
+    uint16_t i, chunk;
+
+    if ((uint32_t)bank * MPU6050_DMP_MEMORY_BANK_SIZE + address + dataSize > MPU6050_DMP_MEMORY_BANKS * MPU6050_DMP_MEMORY_BANK_SIZE) {
+        return false;
+    }
+    MPU6050_setMemoryBank(bank, false, false);
+    for (i = 0; i < dataSize; i += chunk) {
+        /* Chunks don't cross bank ends */
+        chunk = MPU6050_DMP_MEMORY_CHUNK_SIZE;
+        if (chunk > dataSize - i) {
+            chunk = dataSize - i;
+        }
+        if (chunk > MPU6050_DMP_MEMORY_BANK_SIZE - address) {
+            chunk = MPU6050_DMP_MEMORY_BANK_SIZE - address;
+        }
+        /* I2C writes take non constant data */
+        memcpy(chunk_data, &data[i], chunk);
+        MPU6050_setMemoryStartAddress(address);
+        if (!I2C_writeBytes(devAddr, MPU6050_RA_MEM_R_W, chunk, chunk_data)) {
+            return false;
+        }
+        if (verify) {
+            MPU6050_setMemoryStartAddress(address);
+            if (I2C_readBytes(devAddr, MPU6050_RA_MEM_R_W, chunk, verify_data, I2C_MASTER_TIMEOUT_MS) != chunk ||
+                    memcmp(chunk_data, verify_data, chunk) != 0) {
+                return false;
+            }
+        }
+        address += chunk;
+        if (address == 0 && i + chunk < dataSize) {
+            MPU6050_setMemoryBank(++bank, false, false);
+        }
+    }
+    return true;
+}
+
+bool MPU6050_getDMPEnabled() {
+    uint8_t enabled = 0;
+
+    I2C_readBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_DMP_EN_BIT, &enabled, I2C_MASTER_TIMEOUT_MS);
+    return enabled != 0;
+}
+
+void MPU6050_setDMPEnabled(bool enabled) {
+    I2C_writeBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_DMP_EN_BIT, enabled);
+}
+
+void MPU6050_resetDMP() {
+    I2C_writeBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_DMP_RESET_BIT, true);
+}
+
+void MPU6050_setDMPProgramStart(uint16_t address) {
+    uint8_t data[2] = {(uint8_t)(address >> 8), (uint8_t)(address & 0xFF)};
+
+    I2C_writeBytes(devAddr, MPU6050_RA_DMP_CFG_1, 2, data);
+}
+
+void MPU6050_setIntDMPEnabled(bool enabled) {
+    I2C_writeBit(devAddr, MPU6050_RA_INT_ENABLE, MPU6050_INTERRUPT_DMP_INT_BIT, enabled);
+}
+
+bool MPU6050_dmpLoadFirmware(const uint8_t *firmware, uint16_t size, uint16_t start) {
+    MPU6050_setDMPEnabled(false);
+    MPU6050_resetDMP();
+    if (!MPU6050_writeMemoryBlock(firmware, size, 0, 0, true)) {
+        return false;
+    }
+    MPU6050_setDMPProgramStart(start);
+    return true;
+}
+
+bool MPU6050_dmpGetPacket(mpu6050_dmp_packet_t *packet) {
+    uint8_t data[MPU6050_DMP_PACKET_SIZE];
+    uint16_t count;
+    int64_t w, x, y, z;
+    uint8_t i;
+
+    if (I2C_readBytes(devAddr, MPU6050_RA_FIFO_COUNTH, 2, data, I2C_MASTER_TIMEOUT_MS) != 2) {
+        return false;
+    }
+    count = (((uint16_t)data[0]) << 8) | data[1];
+    if (count < MPU6050_DMP_PACKET_SIZE) {
+        return false;
+    }
+    /* When full, new packets overwrite the oldest bytes: what is left is not aligned.
+     * Neither is it after a failed packet read, which may have taken part of the packet */
+    if (count >= MPU6050_FIFO_SIZE ||
+            I2C_readBytes(devAddr, MPU6050_RA_FIFO_R_W, MPU6050_DMP_PACKET_SIZE, data, I2C_MASTER_TIMEOUT_MS) != MPU6050_DMP_PACKET_SIZE) {
+        MPU6050_setFIFOEnabled(false);
+        MPU6050_resetFIFO();
+        MPU6050_setFIFOEnabled(true);
+        return false;
+    }
+    for (i = 0; i < 4; i++) {
+        packet->quat[i] = ((int32_t)data[4 * i] << 24) | ((int32_t)data[4 * i + 1] << 16) | ((int32_t)data[4 * i + 2] << 8) | data[4 * i + 3];
+    }
+    /* Gyroscope and accelerometer are the high halves of 32 bit words */
+    for (i = 0; i < 3; i++) {
+        packet->gyro[i] = (((int16_t)data[16 + 4 * i]) << 8) | data[17 + 4 * i];
+        packet->accel[i] = (((int16_t)data[28 + 4 * i]) << 8) | data[29 + 4 * i];
+    }
+    /* Gravity: third row of the rotation matrix. Q30 * Q30 = Q60, to Q14 */
+    w = packet->quat[0];
+    x = packet->quat[1];
+    y = packet->quat[2];
+    z = packet->quat[3];
+    packet->gravity[0] = (x * z - w * y) >> 45;
+    packet->gravity[1] = (w * x + y * z) >> 45;
+    packet->gravity[2] = (w * w - x * x - y * y + z * z) >> 46;
+    return true;
+}
+
 /*==================[end of file]============================================*/
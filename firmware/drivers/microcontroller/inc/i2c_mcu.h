@@ -14,6 +14,34 @@
  * 
  * @note ESP-EDU have 4 I2C connector in the board (J4, J5, J6 and J8), but all of them are routed to the same I2C port.
  *
+ * @note Transactions are built in a static command link shared by all of them (one at a
+ * time), so register accesses don't allocate memory. I2C_initialize() must be called first.
+ *
+ * @note A device can keep a shadow copy of its registers (I2C_shadowInit()). Reads of
+ * known registers are answered from the copy, so read-modify-write helpers (I2C_writeBit(),
+ * I2C_writeBits()) only write. Between I2C_shadowBegin() and I2C_shadowCommit() writes
+ * are kept in the copy and sent as bursts of consecutive registers (the device must
+ * auto-increment the register address); writes that don't change a known value are
+ * dropped. Volatile registers (status, data, self-clearing bits) are never cached nor
+ * delayed: writing one sends the pending writes first, so the device sees writes in
+ * the order they were made. Bursts starting at a volatile register are taken as data
+ * port accesses (FIFO, memory) and don't update the copy. The copy only takes the values
+ * of successful writes: after a failed one the device may have the old value or the new
+ * one, so those registers are read again. Shadow copies may be used from several tasks.
+ *
+ * @note Transactions can also be queued (I2C_queueTransfer()) and made by a background
+ * task (I2C_queueInit()), so the calling task doesn't wait for the bus. Queued
+ * transactions are made by priority, and in the order they were queued within the same
+ * priority. Reads of adjacent registers of the same device marked with batch are joined
+ * in one longer read, unless a write to the device was queued before them. Several
+ * transactions queued together (I2C_queueTransfers()) are made back to back. Queued
+ * writes are made when their turn comes, even between I2C_shadowBegin() and
+ * I2C_shadowCommit(); registers with a pending write keep it until the commit.
+ *
+ * @note Every transaction is counted for its device (I2C_getStats(), I2C_sendStats()):
+ * bytes, NACKs, timeouts and latency, measured from the start of the transaction to its
+ * end (waiting for the bus not included).
+ *
  * @author Juan Ignacio Cerrudo
  * 
  * @section changelog
@@ -21,6 +49,15 @@
  * |   Date	    | Description                                    |
  * |:----------:|:-----------------------------------------------|
  * | 30/01/2024 | Document creation		                         |
+ * | 17/10/2026 | Static command links (no heap per transaction) |
+ * | 17/10/2026 | Register reads with repeated start             |
+ * | 17/10/2026 | Register shadow cache, coalesced writes        |
+ * | 17/10/2026 | Transaction queue with priorities and batching |
+ * | 17/10/2026 | Bus statistics for each device                 |
+ * | 17/10/2026 | Several transactions queued together           |
+ * | 17/10/2026 | Delayed writes of unchanged values dropped     |
+ * | 17/10/2026 | Shadow copies shared by tasks, queue checks    |
+ * | 17/10/2026 | Read functions report failures (-1)            |
  *
  */
 
@@ -29,7 +66,10 @@
 #include <stdbool.h>
 #include "esp_log.h"
 #include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "gpio_mcu.h"
+#include "uart_mcu.h"
 /*==================[macros]=================================================*/
 
 /*==================[typedef]================================================*/
@@ -40,6 +80,73 @@
 #define I2C_MASTER_TX_BUF_DISABLE   0           /*!< I2C master doesn't need buffer */
 #define I2C_MASTER_RX_BUF_DISABLE   0           /*!< I2C master doesn't need buffer */
 #define I2C_MASTER_TIMEOUT_MS       1000
+#define I2C_SHADOW_DEVICES          4           /*!< Maximum number of devices with register shadow copy */
+#define I2C_BATCH_SIZE              32          /*!< Maximum number of bytes of joined reads */
+#define I2C_BATCH_COUNT             8           /*!< Maximum number of joined reads */
+#define I2C_STATS_DEVICES           8           /*!< Maximum number of devices with bus statistics */
+/**
+ * @brief Range of registers (first to last, both included)
+ */
+typedef struct {
+	uint8_t first;		/*!< First register */
+	uint8_t last;		/*!< Last register */
+} i2c_reg_range_t;
+
+/**
+ * @brief Shadow copy of the registers of a device
+ */
+typedef struct {
+	uint8_t devAddr;						/*!< I2C slave device address */
+	const i2c_reg_range_t *volatile_regs;	/*!< Registers never cached nor delayed */
+	uint8_t volatile_count;					/*!< Number of volatile register ranges */
+	bool deferred;							/*!< Writes are kept until I2C_shadowCommit() */
+	uint8_t value[256];						/*!< Register values */
+	uint8_t valid[32];						/*!< Registers with known value (one bit each) */
+	uint8_t dirty[32];						/*!< Registers not yet written to the device (one bit each) */
+} i2c_shadow_t;
+
+/**
+ * @brief Queued transaction types
+ */
+typedef enum {
+	I2C_TRANS_WRITE,		/*!< Write one register or a burst of consecutive registers */
+	I2C_TRANS_READ,			/*!< Read one register or a burst of consecutive registers (repeated START) */
+} i2c_trans_type_t;
+
+/**
+ * @brief Queued transaction descriptor. Descriptors belong to the caller (usually a
+ * static array used as a pool) and must be kept until their transaction ends.
+ */
+typedef struct i2c_trans {
+	struct i2c_trans *next;					/*!< Reserved for the driver */
+	i2c_trans_type_t type;					/*!< Transaction type */
+	uint8_t devAddr;						/*!< I2C slave device address */
+	uint8_t regAddr;						/*!< First register */
+	uint8_t length;							/*!< Number of bytes (at least 1) */
+	uint8_t *data;							/*!< Data to write or buffer for read data */
+	uint8_t priority;						/*!< Higher values are made first */
+	bool batch;								/*!< true to allow joining with reads of adjacent registers (never for registers with read side effects, i.e. FIFO data) */
+	void (*func_p)(struct i2c_trans *trans);	/*!< Called from the I2C task when the transaction ends (NULL for none) */
+	TaskHandle_t task;						/*!< Task notified (xTaskNotifyGive()) when the transaction ends (NULL for none) */
+	void *param_p;							/*!< Free for caller use (callback parameter) */
+	bool success;							/*!< Transaction result, valid when done */
+	volatile bool done;						/*!< true when the transaction has ended */
+} i2c_trans_t;
+
+/**
+ * @brief Bus statistics of a device
+ */
+typedef struct {
+	uint8_t devAddr;						/*!< I2C slave device address */
+	uint32_t transactions;					/*!< Transactions made, failed ones included */
+	uint32_t bytes;							/*!< Bytes of successful transactions (register address and data) */
+	uint32_t nacks;							/*!< Transactions not acknowledged by the device */
+	uint32_t timeouts;						/*!< Transactions not ended in time (bus busy or held by the device) */
+	uint32_t errors;						/*!< Transactions failed for other reasons */
+	uint32_t latency_min;					/*!< Shortest transaction (microseconds) */
+	uint32_t latency_max;					/*!< Longest transaction (microseconds) */
+	uint64_t latency_total;					/*!< Time of all transactions (microseconds), average = latency_total / transactions */
+} i2c_stats_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -62,7 +169,7 @@ void I2C_enable(bool isEnabled);
  * @param bitNum Bit position to read (0-7)
  * @param data Container for single bit value
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return Status of read operation (true = success)
+ * @return Number of bytes read (1), -1 on failure
  */
 int8_t I2C_readBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t *data, uint16_t timeout);
 
@@ -74,7 +181,7 @@ int8_t I2C_readBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t *da
  * @param length Number of bits to read (not more than 8)
  * @param data Container for right-aligned value (i.e. '101' read from any bitStart position will equal 0x05)
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return Status of read operation (true = success)
+ * @return Number of bytes read (1), -1 on failure
  */
 int8_t I2C_readBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t length, uint8_t *data, uint16_t timeout);
 
@@ -84,7 +191,7 @@ int8_t I2C_readBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t
  * @param regAddr Register regAddr to read from
  * @param data Container for byte value read from device
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return Status of read operation (true = success)
+ * @return Number of bytes read (1), -1 on failure
  */
 int8_t I2C_readByte(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t timeout);
 
@@ -100,14 +207,15 @@ int8_t I2C_readWord(uint8_t devAddr, uint8_t regAddr, uint16_t *data, uint16_t t
 
 /** @fn I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout)
  * @brief Read multiple bytes from an 8-bit device register.
+ * @note Register address is written and data read in a single transaction (repeated START).
  * @param devAddr I2C slave device address
  * @param regAddr First register regAddr to read from
  * @param length Number of bytes to read
  * @param data Buffer to store read data in
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return I2C_TransferReturn_TypeDef
+ * @return Number of bytes read, -1 on failure
  */
-int8_t I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout);
+int16_t I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout);
 
 /** @fn I2C_writeBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t data);
  * @brief write a single bit in an 8-bit device register.
@@ -165,6 +273,94 @@ bool I2C_writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *d
  */
 void I2C_SelectRegister(uint8_t devAddr, uint8_t reg);
 
+/** @fn I2C_shadowInit(i2c_shadow_t *shadow, uint8_t devAddr, const i2c_reg_range_t *volatile_regs, uint8_t volatile_count)
+ * @brief Keep a shadow copy of the registers of a device. The copy starts empty.
+ * @param shadow Shadow copy memory (must be kept while in use)
+ * @param devAddr I2C slave device address
+ * @param volatile_regs Registers never cached nor delayed (status, data, self-clearing bits)
+ * @param volatile_count Number of volatile register ranges
+ * @return Status of operation (true = success, false = I2C_SHADOW_DEVICES already in use)
+ */
+bool I2C_shadowInit(i2c_shadow_t *shadow, uint8_t devAddr, const i2c_reg_range_t *volatile_regs, uint8_t volatile_count);
+
+/** @fn I2C_shadowLoad(uint8_t devAddr, uint8_t regAddr, uint8_t length)
+ * @brief Read consecutive registers into the shadow copy with a single burst.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register to read
+ * @param length Number of registers
+ * @return Status of operation (true = success)
+ */
+bool I2C_shadowLoad(uint8_t devAddr, uint8_t regAddr, uint8_t length);
+
+/** @fn I2C_shadowInvalidate(uint8_t devAddr)
+ * @brief Forget the shadow copy (i.e. after a device reset). Pending writes are lost.
+ * @param devAddr I2C slave device address
+ */
+void I2C_shadowInvalidate(uint8_t devAddr);
+
+/** @fn I2C_shadowBegin(uint8_t devAddr)
+ * @brief Keep the following writes to the device in the shadow copy until I2C_shadowCommit().
+ * @param devAddr I2C slave device address
+ */
+void I2C_shadowBegin(uint8_t devAddr);
+
+/** @fn I2C_shadowCommit(uint8_t devAddr)
+ * @brief Send the pending writes, each run of consecutive registers as one burst.
+ * @param devAddr I2C slave device address
+ * @return Status of operation (true = success, also for devices without shadow copy)
+ */
+bool I2C_shadowCommit(uint8_t devAddr);
+
+/** @fn I2C_queueInit(uint8_t priority)
+ * @brief Start the task that makes queued transactions. I2C_initialize() must be called first.
+ * @note Does nothing if the task is already running.
+ * @param priority Priority of the I2C task
+ * @return Status of operation (true = success)
+ */
+bool I2C_queueInit(uint8_t priority);
+
+/** @fn I2C_queueTransfer(i2c_trans_t *trans)
+ * @brief Queue a transaction and return without waiting for it.
+ * @note The end of a transaction can be known by its done field, its callback or its task
+ * notification. Buffer and descriptor must not be modified until then. Callbacks run
+ * in the I2C task, and should be short since they delay the next transactions.
+ * Must not be called from an interrupt.
+ * @param trans Transaction descriptor (fields set by the caller, except next, success and done)
+ * @return Status of operation (true = queued, false = I2C task not running, see I2C_queueInit())
+ */
+bool I2C_queueTransfer(i2c_trans_t *trans);
+
+/** @fn I2C_queueTransfers(i2c_trans_t *trans, uint8_t count)
+ * @brief Queue several transactions at once (i.e. the same read from several devices).
+ * @note Transactions are added to the queue before the I2C task can take any of them,
+ * so those of the same priority are made one right after the other, in array order.
+ * Same rules as I2C_queueTransfer() for each transaction.
+ * @param trans Array of transaction descriptors
+ * @param count Number of transactions
+ * @return Status of operation (true = queued, false = I2C task not running, see I2C_queueInit())
+ */
+bool I2C_queueTransfers(i2c_trans_t *trans, uint8_t count);
+
+/** @fn I2C_getStats(uint8_t devAddr, i2c_stats_t *dev_stats)
+ * @brief Get the bus statistics of a device.
+ * @param devAddr I2C slave device address
+ * @param dev_stats Copy of the statistics
+ * @return true if the device has statistics (at least one transaction made)
+ */
+bool I2C_getStats(uint8_t devAddr, i2c_stats_t *dev_stats);
+
+/** @fn I2C_resetStats(void)
+ * @brief Clear the bus statistics of all devices.
+ */
+void I2C_resetStats(void);
+
+/** @fn I2C_sendStats(uart_mcu_port_t port)
+ * @brief Send the bus statistics of all devices as text, one line for each device
+ * (address, transactions, bytes, NACKs, timeouts, errors and min/avg/max latency in microseconds).
+ * @param port UART port (must be initialized)
+ */
+void I2C_sendStats(uart_mcu_port_t port);
+
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
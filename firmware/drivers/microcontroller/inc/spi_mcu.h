@@ -14,6 +14,15 @@
  * 
  * @note MISO: GPIO_22, MOSI: GPIO_21, SCLK: GPIO_20, CS1: GPIO_19, CS2: GPIO_18, CS3: GPIO_9
  * 
+ * @note Each device keeps its own configuration (transfer mode, callback, data/command
+ * line), so several devices can share the bus. Blocking transfers take the bus for
+ * the whole transfer; while a task waits for it, devices with queued transfers keep
+ * only one in progress, so a long queue can't hold the other devices back.
+ * 
+ * @note The queue of each device is guarded by a mutex, so several tasks can queue
+ * transfers to the same device and take their results. The mutexes are created by the
+ * first SpiInit(), which must run before other tasks use the bus.
+ * 
  * @author Albano Peñalva
  *
  * @section changelog
@@ -21,12 +30,23 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 09/02/2024 | Document creation		                         						|
+ * | 17/10/2026 | Data/command line handled by the driver	 							|
+ * | 17/10/2026 | Queued (DMA) write transfers			 							|
+ * | 17/10/2026 | Asynchronous transfers with caller descriptors						|
+ * | 17/10/2026 | Transfer lists with data/command and chip select for each segment		|
+ * | 17/10/2026 | Device registry: repeated init keeps the device, bitrate changes		|
+ * | 17/10/2026 | Device queue guarded by a mutex										|
+ * | 17/10/2026 | Transfer list segments can call the device callback					|
  * 
  **/
 /*==================[inclusions]=============================================*/
 #include <stdbool.h>
 #include <stdint.h>
+#include "gpio_mcu.h"
 /*==================[macros]=================================================*/
+#define SPI_MAX_TRANSFER_SIZE	4092	/*!< Maximum number of bytes in a single transfer (DMA) */
+#define SPI_QUEUE_SIZE			8		/*!< Maximum number of queued transfers for each device */
+#define SPI_TRANS_DRIVER_SIZE	8		/*!< Size of driver data in asynchronous transfer descriptors (64 bits words) */
 
 /*==================[typedef]================================================*/
 
@@ -66,20 +86,63 @@ typedef struct{
 	clk_mode_t clk_mode;			/*!< Mode: phase and polarity */
 	uint32_t bitrate;				/*!< Transfer speed (up to 26MHz) */
 	transfer_mode_t transfer_mode;	/*!< Transfer mode */
-	void *func_p;					/*!< Pointer to callback function for transaction end */
+	void *func_p;					/*!< Pointer to callback function for transaction end (SPI_INTERRUPT and queued transfers) */
 	void *param_p;					/*!< Pointer to callback parameter */
+	bool dc_en;						/*!< true if the device uses a data/command line */
+	gpio_t dc_gpio;					/*!< Data/command GPIO, driven before each transaction (only if dc_en) */
 } spi_mcu_config_t;
+
+/**
+ * @brief Segment of a transfer list
+ */
+typedef struct {
+	uint8_t *tx_buffer;		/*!< Data to write (NULL to only read) */
+	uint8_t *rx_buffer;		/*!< Buffer for read data (NULL to only write) */
+	uint32_t size;			/*!< Number of bytes (up to SPI_MAX_TRANSFER_SIZE) */
+	bool command;			/*!< true to send with the data/command line low (only if dc_en) */
+	bool keep_cs;			/*!< true to keep chip select active until the next segment */
+	bool notify;			/*!< true to call the device callback (from the interrupt) when the segment ends */
+} spi_segment_t;
+
+/**
+ * @brief Asynchronous transfer descriptor. Descriptors belong to the caller (usually
+ * a static array used as a pool) and must be kept until their transfer ends.
+ */
+typedef struct spi_trans {
+	uint64_t driver[SPI_TRANS_DRIVER_SIZE];		/*!< Reserved for the driver (must be the first field) */
+	uint8_t *tx_buffer;							/*!< Data to write (NULL to only read). DMA capable */
+	uint8_t *rx_buffer;							/*!< Buffer for read data (NULL to only write). DMA capable */
+	uint32_t size;								/*!< Number of bytes to transfer (up to SPI_MAX_TRANSFER_SIZE) */
+	void (*func_p)(struct spi_trans *trans);	/*!< Called from the SPI interrupt when the transfer ends (NULL for none) */
+	void *param_p;								/*!< Free for caller use (callback parameter) */
+	volatile bool done;							/*!< true when the transfer has ended */
+} spi_trans_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
 /**
  * @brief Initialize SPI module with the corresponding configuration
  * 
+ * @note Initializing a device again with the same configuration does nothing, so
+ * several drivers can share a device. A different configuration replaces the previous one.
+ * 
  * @param spi Structure with the module configuration
- * @return uint8_t 
+ * @return uint8_t 1 when success, 0 when fails
  */
 uint8_t SpiInit(spi_mcu_config_t* spi);
 
+/**
+ * @brief Change the transfer speed of a device for the following transfers
+ * 
+ * @note Waits for the queued transfers of the device to end. The rest of the
+ * configuration is kept. Does nothing if the speed is already the requested one.
+ * 
+ * @param device SPI device
+ * @param bitrate transfer speed (up to 26MHz)
+ * @return uint8_t 1 when success, 0 when fails (device not initialized)
+ */
+uint8_t SpiSetBitrate(spi_dev_t device, uint32_t bitrate);
+
 /**
  * @brief Read data from SPI port
  * 
@@ -98,6 +161,93 @@ void SpiRead(spi_dev_t device, uint8_t * rx_buffer, uint32_t rx_buffer_size);
  */
 void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size);
 
+/**
+ * @brief Write a command byte followed by its parameters
+ * 
+ * @note The command is sent with the data/command line low and the parameters 
+ * with it high. The line is switched by the SPI driver before each transaction, 
+ * and the bus is held for both, so no other device can break in between.
+ * Devices configured without data/command line (dc_en = false) send both as plain data.
+ * 
+ * @param device SPI device to write to
+ * @param cmd command byte
+ * @param param pointer to parameters (NULL if the command has none)
+ * @param param_size numbers of parameter bytes to write
+ */
+void SpiWriteCommand(spi_dev_t device, uint8_t cmd, uint8_t * param, uint32_t param_size);
+
+/**
+ * @brief Send a list of segments (i.e. command, parameters and data) as one transfer
+ * 
+ * @note The bus is held for the whole list, so no other device can break in between.
+ * The data/command line of each segment is set by the SPI driver just before it starts.
+ * Segments of up to 4 bytes travel inside the transaction, longer ones must be DMA capable.
+ * Waits for the queued transfers of the device to end first, and returns when the
+ * last segment has been sent. Segments with notify set call the device callback from
+ * the SPI interrupt, whatever the transfer mode.
+ * 
+ * @param device SPI device
+ * @param segments pointer to the first segment
+ * @param count number of segments
+ */
+void SpiTransferList(spi_dev_t device, const spi_segment_t * segments, uint8_t count);
+
+/**
+ * @brief Queue data to be written from SPI port, without waiting for the transfer
+ * 
+ * @note Up to SPI_QUEUE_SIZE transfers can be queued for each device. If the queue
+ * is full, waits for the oldest one to end. The buffer must be DMA capable and must 
+ * not be modified until its transfer ends (see SpiWaitQueued()).
+ * Any other transfer to the device waits for the queued ones to end first.
+ * 
+ * @param device SPI device to write to
+ * @param tx_buffer pointer to buffer where data is stored
+ * @param tx_buffer_size numbers of bytes to write (up to SPI_MAX_TRANSFER_SIZE)
+ * @param notify true to call the device callback (func_p) when this transfer ends
+ */
+void SpiWriteQueued(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size, bool notify);
+
+/**
+ * @brief Wait for queued transfers to end
+ * 
+ * @param device SPI device
+ * @param pending number of transfers that can still be in progress when returning (0 to wait for all)
+ */
+void SpiWaitQueued(spi_dev_t device, uint8_t pending);
+
+/**
+ * @brief Start a transfer and return without waiting for it
+ * 
+ * @note Asynchronous and queued transfers share the SPI_QUEUE_SIZE places of a
+ * device: if all are in use, waits for the oldest transfer to end. Transfers end in
+ * the order they were started. The end of a transfer can be known by its done field,
+ * its callback or SpiGetResult(). Buffers and descriptor must not be modified until then.
+ * Any blocking transfer to the device waits for the asynchronous ones to end first.
+ * 
+ * @param device SPI device
+ * @param trans transfer descriptor (buffers and size set by the caller)
+ */
+void SpiTransferAsync(spi_dev_t device, spi_trans_t * trans);
+
+/**
+ * @brief Get the next ended asynchronous transfer of a device
+ * 
+ * @note Transfers are returned in the order they were started. Each ended transfer
+ * is returned once (SpiFlush() and blocking transfers drop the ones not taken).
+ * 
+ * @param device SPI device
+ * @param wait true to wait for the next transfer to end, false to return at once
+ * @return spi_trans_t* ended transfer, NULL if no transfer has ended (or none was started)
+ */
+spi_trans_t * SpiGetResult(spi_dev_t device, bool wait);
+
+/**
+ * @brief Wait for all queued and asynchronous transfers of a device to end
+ * 
+ * @param device SPI device
+ */
+void SpiFlush(spi_dev_t device);
+
 /**
  * @brief Write and Read data simultaneous from SPI port
  * 
@@ -111,8 +261,10 @@ void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, ui
 /**
  * @brief De-Initialize SPI module with the corresponding configuration
  * 
+ * @note Waits for the queued transfers of the device to end and removes it from the bus.
+ * 
  * @param device SPI device 
- * @return uint8_t 
+ * @return uint8_t 1 when success, 0 when fails (device not initialized)
  */
 uint8_t SpiDeInit(spi_dev_t device);
 
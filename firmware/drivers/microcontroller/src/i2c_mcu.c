@@ -14,19 +14,400 @@
 #include <esp_err.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
 //#include "sdkconfig.h"
 
 #include "i2c_mcu.h"
+#include "uart_mcu.h"
+#include <string.h>
+#include <stdio.h>
 /*==================[macros and definitions]=================================*/
 #define I2C_NUM I2C_NUM_0
+#define BitGet(map, n)		((map)[(n) >> 3] & (1 << ((n) & 7)))		/*!< Bit n of a bit map */
+#define BitSet(map, n)		((map)[(n) >> 3] |= (1 << ((n) & 7)))		/*!< Set bit n of a bit map */
+#define BitClear(map, n)	((map)[(n) >> 3] &= ~(1 << ((n) & 7)))		/*!< Clear bit n of a bit map */
+#define I2C_CMD_LINK_SIZE I2C_LINK_RECOMMENDED_SIZE(2)	/*!< Command link buffer: write and read joined by a repeated start */
+#define I2C_QUEUE_TASK_STACK 3072	/*!< Stack size of the I2C task (bytes), callbacks included */
 
 #undef ESP_ERROR_CHECK
 #define ESP_ERROR_CHECK(x)   do { esp_err_t rc = (x); if (rc != ESP_OK) { ESP_LOGE("err", "esp_err_t = %d", rc); /*assert(0 && #x);*/} } while(0);
 
 /*==================[internal data definition]===============================*/
-
+static uint8_t cmd_link_buffer[I2C_CMD_LINK_SIZE];	/*!< Command link, used by every transaction */
+static StaticSemaphore_t cmd_link_mutex_buffer;		/*!< Command link mutex memory */
+static SemaphoreHandle_t cmd_link_mutex;			/*!< Command link mutex */
+static i2c_shadow_t *shadows[I2C_SHADOW_DEVICES];	/*!< Devices with register shadow copy */
+static StaticSemaphore_t shadow_mutex_buffer;		/*!< Shadow copies mutex memory */
+static SemaphoreHandle_t shadow_mutex;				/*!< Shadow copies mutex (recursive, taken before the command link) */
+static StaticSemaphore_t queue_mutex_buffer;		/*!< Transaction queue mutex memory */
+static SemaphoreHandle_t queue_mutex;				/*!< Transaction queue mutex */
+static i2c_trans_t *queue_first;					/*!< Queued transactions, sorted by priority */
+static TaskHandle_t queue_task;						/*!< Task that makes queued transactions */
+static uint8_t batch_buffer[I2C_BATCH_SIZE];		/*!< Data of joined reads */
+static i2c_stats_t stats[I2C_STATS_DEVICES];		/*!< Bus statistics of each device (transactions == 0: free) */
 /*==================[internal functions declaration]=========================*/
 
+/** Create a command link in the static buffer (no heap allocation).
+ * The buffer is taken until I2C_cmdExecute() is called.
+ * @return Command link handle
+ */
+static i2c_cmd_handle_t I2C_cmdCreate(void){
+	xSemaphoreTake(cmd_link_mutex, portMAX_DELAY);
+	return i2c_cmd_link_create_static(cmd_link_buffer, sizeof(cmd_link_buffer));
+}
+
+/** Add a transaction to the statistics of a device. Called with the command link taken.
+ * @param devAddr I2C slave device address
+ * @param bytes Number of bytes after the device address
+ * @param rc Transaction result
+ * @param latency Transaction time in microseconds
+ */
+static void I2C_statsAdd(uint8_t devAddr, uint16_t bytes, esp_err_t rc, uint32_t latency){
+	i2c_stats_t *dev = NULL;
+
+	for(uint8_t i = 0; i < I2C_STATS_DEVICES && dev == NULL; i++){
+		if(stats[i].transactions == 0 || stats[i].devAddr == devAddr){
+			dev = &stats[i];
+		}
+	}
+	/* More devices than places: not counted */
+	if(dev == NULL){
+		return;
+	}
+	if(dev->transactions == 0){
+		memset(dev, 0, sizeof(i2c_stats_t));
+		dev->devAddr = devAddr;
+		dev->latency_min = UINT32_MAX;
+	}
+	dev->transactions++;
+	if(rc == ESP_OK){
+		dev->bytes += bytes;
+	} else if(rc == ESP_ERR_TIMEOUT){
+		dev->timeouts++;
+	} else if(rc == ESP_FAIL){
+		dev->nacks++;
+	} else{
+		dev->errors++;
+	}
+	dev->latency_total += latency;
+	if(latency < dev->latency_min){
+		dev->latency_min = latency;
+	}
+	if(latency > dev->latency_max){
+		dev->latency_max = latency;
+	}
+}
+
+/** Send the commands of a link created by I2C_cmdCreate() and release it.
+ * @param cmd Command link handle
+ * @param devAddr I2C slave device address (for statistics)
+ * @param bytes Number of bytes after the device address (for statistics)
+ * @return ESP_OK when success
+ */
+static esp_err_t I2C_cmdExecute(i2c_cmd_handle_t cmd, uint8_t devAddr, uint16_t bytes){
+	int64_t start = esp_timer_get_time();
+	esp_err_t rc = i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS);
+
+	I2C_statsAdd(devAddr, bytes, rc, (uint32_t)(esp_timer_get_time() - start));
+	i2c_cmd_link_delete_static(cmd);
+	xSemaphoreGive(cmd_link_mutex);
+	return rc;
+}
+
+/** Read consecutive registers from the device, with a repeated START.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register regAddr to read from
+ * @param length Number of bytes to read
+ * @param data Buffer to store read data in
+ * @return ESP_OK when success
+ */
+static esp_err_t I2C_busRead(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data){
+	i2c_cmd_handle_t cmd;
+
+	/* Register address and read in one transaction, joined by a repeated START */
+	cmd = I2C_cmdCreate();
+	ESP_ERROR_CHECK(i2c_master_start(cmd));
+	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
+	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, regAddr, 1));
+	ESP_ERROR_CHECK(i2c_master_start(cmd));
+	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_READ, 1));
+
+	if(length>1)
+	ESP_ERROR_CHECK(i2c_master_read(cmd, data, length-1, I2C_MASTER_ACK));
+
+	ESP_ERROR_CHECK(i2c_master_read_byte(cmd, data+length-1, I2C_MASTER_NACK));
+
+	ESP_ERROR_CHECK(i2c_master_stop(cmd));
+	return I2C_cmdExecute(cmd, devAddr, 1 + length);
+}
+
+/** Write consecutive registers of the device.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address to write to
+ * @param length Number of bytes to write
+ * @param data Array of bytes to write
+ * @return ESP_OK when success
+ */
+static esp_err_t I2C_busWrite(uint8_t devAddr, uint8_t regAddr, uint8_t length, const uint8_t *data){
+	i2c_cmd_handle_t cmd;
+
+	cmd = I2C_cmdCreate();
+	ESP_ERROR_CHECK(i2c_master_start(cmd));
+	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
+	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, regAddr, 1));
+	ESP_ERROR_CHECK(i2c_master_write(cmd, data, length, 1));
+	ESP_ERROR_CHECK(i2c_master_stop(cmd));
+	return I2C_cmdExecute(cmd, devAddr, 1 + length);
+}
+
+/** Find the shadow copy of a device.
+ * @param devAddr I2C slave device address
+ * @return Shadow copy, NULL if the device has none
+ */
+static i2c_shadow_t* I2C_shadowFind(uint8_t devAddr){
+	for(uint8_t i = 0; i < I2C_SHADOW_DEVICES; i++){
+		if(shadows[i] != NULL && shadows[i]->devAddr == devAddr){
+			return shadows[i];
+		}
+	}
+	return NULL;
+}
+
+/** Check if a register can be kept in the shadow copy.
+ * @param shadow Shadow copy
+ * @param regAddr Register address
+ * @return true if the register is not volatile
+ */
+static bool I2C_shadowCacheable(const i2c_shadow_t *shadow, uint8_t regAddr){
+	for(uint8_t i = 0; i < shadow->volatile_count; i++){
+		if(regAddr >= shadow->volatile_regs[i].first && regAddr <= shadow->volatile_regs[i].last){
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Send the pending writes of a shadow copy, each run of consecutive registers as one burst.
+ * Runs not written are forgotten: the device may have the old values or the new ones.
+ * @param shadow Shadow copy
+ * @return ESP_OK when success
+ */
+static esp_err_t I2C_shadowFlush(i2c_shadow_t *shadow){
+	esp_err_t rc = ESP_OK;
+	uint16_t reg, first;
+
+	for(reg = 0; reg < 256; reg++){
+		if(!BitGet(shadow->dirty, reg)){
+			continue;
+		}
+		for(first = reg; reg < 256 && BitGet(shadow->dirty, reg); reg++){
+			BitClear(shadow->dirty, reg);
+		}
+		if(I2C_busWrite(shadow->devAddr, first, reg - first, &shadow->value[first]) != ESP_OK){
+			rc = ESP_FAIL;
+			for(uint16_t i = first; i < reg; i++){
+				BitClear(shadow->valid, i);
+			}
+		}
+	}
+	return rc;
+}
+
+/** Read consecutive registers, from the shadow copy when all of them are known.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register regAddr to read from
+ * @param length Number of bytes to read
+ * @param data Buffer to store read data in
+ * @return ESP_OK when success
+ */
+static esp_err_t I2C_registerRead(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data){
+	i2c_shadow_t *shadow;
+	esp_err_t rc = ESP_OK;
+	uint16_t i, reg;
+	bool known;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	shadow = I2C_shadowFind(devAddr);
+	known = (shadow != NULL) && (regAddr + length <= 256);
+	/* Registers with known value are read from the shadow copy */
+	for(i = 0; known && i < length; i++){
+		known = I2C_shadowCacheable(shadow, regAddr + i) && BitGet(shadow->valid, regAddr + i);
+	}
+	if(known){
+		memcpy(data, &shadow->value[regAddr], length);
+	} else{
+		rc = I2C_busRead(devAddr, regAddr, length, data);
+		/* Data ports (FIFO, memory) don't auto-increment: bursts from volatile registers aren't kept */
+		if(shadow != NULL && !I2C_shadowCacheable(shadow, regAddr)){
+			shadow = NULL;
+		}
+		for(i = 0; rc == ESP_OK && shadow != NULL && i < length && regAddr + i < 256; i++){
+			reg = regAddr + i;
+			if(!I2C_shadowCacheable(shadow, reg)){
+				continue;
+			}
+			/* A pending write is newer than the value read */
+			if(BitGet(shadow->dirty, reg)){
+				data[i] = shadow->value[reg];
+			} else{
+				shadow->value[reg] = data[i];
+				BitSet(shadow->valid, reg);
+			}
+		}
+	}
+	xSemaphoreGiveRecursive(shadow_mutex);
+	return rc;
+}
+
+/** Write consecutive registers, and keep the values written in the shadow copy.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address to write to
+ * @param length Number of bytes to write
+ * @param data Array of bytes to write
+ * @param now true to write at once, even between I2C_shadowBegin() and I2C_shadowCommit() (queued writes)
+ * @return ESP_OK when success
+ */
+static esp_err_t I2C_registerWrite(uint8_t devAddr, uint8_t regAddr, uint8_t length, const uint8_t *data, bool now){
+	i2c_shadow_t *shadow;
+	esp_err_t rc = ESP_OK;
+	uint16_t i, reg;
+	bool deferred;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	shadow = I2C_shadowFind(devAddr);
+	deferred = !now && (shadow != NULL) && shadow->deferred && (regAddr + length <= 256);
+	for(i = 0; deferred && i < length; i++){
+		deferred = I2C_shadowCacheable(shadow, regAddr + i);
+	}
+	if(!deferred){
+		/* Writes that can't wait go after the pending ones. Writes made now leave them
+		 * for I2C_shadowCommit(), whoever opened the window. */
+		if(shadow != NULL && !now){
+			I2C_shadowFlush(shadow);
+		}
+		rc = I2C_busWrite(devAddr, regAddr, length, data);
+	}
+	for(i = 0; shadow != NULL && i < length && regAddr + i < 256; i++){
+		reg = regAddr + i;
+		/* Data ports (FIFO, memory) don't auto-increment: what follows them is unknown.
+		 * After a failed write the device may have the old value or the new one. */
+		if(!I2C_shadowCacheable(shadow, regAddr) || rc != ESP_OK){
+			BitClear(shadow->valid, reg);
+		} else if(I2C_shadowCacheable(shadow, reg) && !BitGet(shadow->dirty, reg)){
+			/* Delayed writes of the value the device already has are dropped */
+			if(deferred && !(BitGet(shadow->valid, reg) && shadow->value[reg] == data[i])){
+				BitSet(shadow->dirty, reg);
+			}
+			shadow->value[reg] = data[i];
+			BitSet(shadow->valid, reg);
+		} else if(deferred){
+			/* A newer delayed write replaces the pending one */
+			shadow->value[reg] = data[i];
+		}
+	}
+	xSemaphoreGiveRecursive(shadow_mutex);
+	return rc;
+}
+
+/** Take the next queued transaction, and the queued reads that can be joined to it.
+ * @param batch Array for the transactions taken (up to I2C_BATCH_COUNT)
+ * @param first First register of the joined reads
+ * @param end Register after the last one of the joined reads
+ * @return Number of transactions taken (0 if the queue is empty)
+ */
+static uint8_t I2C_queueTake(i2c_trans_t **batch, uint16_t *first, uint16_t *end){
+	i2c_trans_t **p, *trans, *next;
+	uint16_t lo, hi;
+	uint8_t count = 0;
+	bool joined = true;
+
+	xSemaphoreTake(queue_mutex, portMAX_DELAY);
+	trans = queue_first;
+	if(trans != NULL){
+		queue_first = trans->next;
+		batch[count++] = trans;
+		*first = trans->regAddr;
+		*end = trans->regAddr + trans->length;
+		/* Scan again after each join, the range may now reach reads skipped before */
+		while(trans->type == I2C_TRANS_READ && trans->batch && joined && count < I2C_BATCH_COUNT){
+			joined = false;
+			for(p = &queue_first; *p != NULL; p = &(*p)->next){
+				next = *p;
+				if(next->devAddr != trans->devAddr){
+					continue;
+				}
+				/* Reads queued after a write must see it */
+				if(next->type != I2C_TRANS_READ){
+					break;
+				}
+				lo = (next->regAddr < *first) ? next->regAddr : *first;
+				hi = (next->regAddr + next->length > *end) ? next->regAddr + next->length : *end;
+				if(!next->batch || next->regAddr > *end || next->regAddr + next->length < *first || hi - lo > I2C_BATCH_SIZE){
+					continue;
+				}
+				*p = next->next;
+				batch[count++] = next;
+				*first = lo;
+				*end = hi;
+				joined = true;
+				break;
+			}
+		}
+	}
+	xSemaphoreGive(queue_mutex);
+	return count;
+}
+
+/** End a queued transaction: callback, done flag and task notification.
+ * @param trans Transaction descriptor
+ * @param success Transaction result
+ */
+static void I2C_queueDone(i2c_trans_t *trans, bool success){
+	/* The descriptor may be reused as soon as it is done */
+	TaskHandle_t task = trans->task;
+
+	trans->success = success;
+	if(trans->func_p != NULL){
+		trans->func_p(trans);
+	}
+	trans->done = true;
+	if(task != NULL){
+		xTaskNotifyGive(task);
+	}
+}
+
+/** Task that makes the queued transactions.
+ * @param param Not used
+ */
+static void I2C_queueRun(void *param){
+	i2c_trans_t *batch[I2C_BATCH_COUNT];
+	uint16_t first, end;
+	uint8_t i, count;
+	bool success;
+
+	while(true){
+		count = I2C_queueTake(batch, &first, &end);
+		if(count == 0){
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			continue;
+		}
+		if(batch[0]->type == I2C_TRANS_WRITE){
+			success = (I2C_registerWrite(batch[0]->devAddr, batch[0]->regAddr, batch[0]->length, batch[0]->data, true) == ESP_OK);
+		} else if(count == 1){
+			success = (I2C_registerRead(batch[0]->devAddr, batch[0]->regAddr, batch[0]->length, batch[0]->data) == ESP_OK);
+		} else{
+			success = (I2C_registerRead(batch[0]->devAddr, first, end - first, batch_buffer) == ESP_OK);
+			for(i = 0; success && i < count; i++){
+				memcpy(batch[i]->data, &batch_buffer[batch[i]->regAddr - first], batch[i]->length);
+			}
+		}
+		for(i = 0; i < count; i++){
+			I2C_queueDone(batch[i], success);
+		}
+	}
+}
+
 /*==================[external functions definition]==========================*/
 
 /** Initialize I2C0
@@ -45,6 +426,12 @@ bool I2C_initialize( uint32_t clockRateHz )
     };
 
     i2c_param_config(i2c_master_port, &conf);
+    if(cmd_link_mutex == NULL){
+        cmd_link_mutex = xSemaphoreCreateMutexStatic(&cmd_link_mutex_buffer);
+    }
+    if(shadow_mutex == NULL){
+        shadow_mutex = xSemaphoreCreateRecursiveMutexStatic(&shadow_mutex_buffer);
+    }
 
     return i2c_driver_install(i2c_master_port, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0);
 	return true;
@@ -68,14 +455,16 @@ void I2C_enable(bool isEnabled) {
  * @param bitNum Bit position to read (0-7)
  * @param data Container for single bit value
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return Status of read operation (true = success)
+ * @return Number of bytes read (1), -1 on failure
  */
 int8_t I2C_readBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t *data, uint16_t timeout) {
 
 
 	uint8_t b;
-    uint8_t count = I2C_readByte(devAddr, regAddr, &b, timeout);
-    *data = b & (1 << bitNum);
+    int8_t count = I2C_readByte(devAddr, regAddr, &b, timeout);
+    if (count > 0) {
+        *data = b & (1 << bitNum);
+    }
     return count;
 }
 
@@ -86,7 +475,7 @@ int8_t I2C_readBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t *da
  * @param length Number of bits to read (not more than 8)
  * @param data Container for right-aligned value (i.e. '101' read from any bitStart position will equal 0x05)
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return Status of read operation (true = success)
+ * @return Number of bytes read (1), -1 on failure
  */
 int8_t I2C_readBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t length, uint8_t *data, uint16_t timeout) {
     // 01101001 read byte
@@ -94,8 +483,9 @@ int8_t I2C_readBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t
     //    xxx   args: bitStart=4, length=3
     //    010   masked
     //   -> 010 shifted
-    uint8_t count, b;
-    if ((count = I2C_readByte(devAddr, regAddr, &b, timeout)) != 0) {
+    int8_t count;
+    uint8_t b;
+    if ((count = I2C_readByte(devAddr, regAddr, &b, timeout)) > 0) {
         uint8_t mask = ((1 << length) - 1) << (bitStart - length + 1);
         b &= mask;
         b >>= (bitStart - length + 1);
@@ -109,7 +499,7 @@ int8_t I2C_readBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t
  * @param regAddr Register regAddr to read from
  * @param data Container for byte value read from device
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return Status of read operation (true = success)
+ * @return Number of bytes read (1), -1 on failure
  */
 int8_t I2C_readByte(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t timeout) {
     return I2C_readBytes(devAddr, regAddr, 1, data, timeout);
@@ -121,25 +511,12 @@ int8_t I2C_readByte(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t ti
  * @param length Number of bytes to read
  * @param data Buffer to store read data in
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return I2C_TransferReturn_TypeDef http://downloads.energymicro.com/documentation/doxygen/group__I2C.html
+ * @return Number of bytes read, -1 on failure
  */
-int8_t I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
-	i2c_cmd_handle_t cmd;
-	I2C_SelectRegister(devAddr, regAddr);
-
-	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_READ, 1));
-
-	if(length>1)
-	ESP_ERROR_CHECK(i2c_master_read(cmd, data, length-1, I2C_MASTER_ACK));
-
-	ESP_ERROR_CHECK(i2c_master_read_byte(cmd, data+length-1, I2C_MASTER_NACK));
-
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS));
-	i2c_cmd_link_delete(cmd);
-
+int16_t I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
+	if(I2C_registerRead(devAddr, regAddr, length, data) != ESP_OK){
+		return -1;
+	}
 	return length;
 }
 
@@ -153,13 +530,12 @@ bool I2C_writeWord(uint8_t devAddr, uint8_t regAddr, uint16_t data){
 void I2C_SelectRegister(uint8_t devAddr, uint8_t reg){
 	i2c_cmd_handle_t cmd;
 
-	cmd = i2c_cmd_link_create();
+	cmd = I2C_cmdCreate();
 	ESP_ERROR_CHECK(i2c_master_start(cmd));
 	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
 	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, reg, 1));
 	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS));
-	i2c_cmd_link_delete(cmd);
+	ESP_ERROR_CHECK(I2C_cmdExecute(cmd, devAddr, 1));
 }
 
 /** write a single bit in an 8-bit device register.
@@ -171,7 +547,9 @@ void I2C_SelectRegister(uint8_t devAddr, uint8_t reg){
  */
 bool I2C_writeBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t data) {
     uint8_t b;
-    I2C_readByte(devAddr, regAddr, &b, 0);
+    if (I2C_readByte(devAddr, regAddr, &b, 0) <= 0) {
+        return false;
+    }
     b = (data != 0) ? (b | (1 << bitNum)) : (b & ~(1 << bitNum));
     return I2C_writeByte(devAddr, regAddr, b);
 }
@@ -193,7 +571,7 @@ bool I2C_writeBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t l
     // 10100011 original & ~mask
     // 10101011 masked | value
     uint8_t b = 0;
-    if (I2C_readByte(devAddr, regAddr, &b, 0) != 0) {
+    if (I2C_readByte(devAddr, regAddr, &b, 0) > 0) {
         uint8_t mask = ((1 << length) - 1) << (bitStart - length + 1);
         data <<= (bitStart - length + 1); // shift data into correct position
         data &= mask; // zero all non-important bits in data
@@ -212,18 +590,7 @@ bool I2C_writeBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t l
  * @return Status of operation (true = success)
  */
 bool I2C_writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
-	i2c_cmd_handle_t cmd;
-
-	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, regAddr, 1));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, data, 1));
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS));
-	i2c_cmd_link_delete(cmd);
-
-	return true;
+	return I2C_writeBytes(devAddr, regAddr, 1, &data);
 }
 
 /** Write single byte to an 8-bit device register.
@@ -234,18 +601,7 @@ bool I2C_writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
  * @return Status of operation (true = success)
  */
 bool I2C_writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data){
-	i2c_cmd_handle_t cmd;
-
-	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, regAddr, 1));
-	ESP_ERROR_CHECK(i2c_master_write(cmd, data, length-1, 0));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, data[length-1], 1));
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS);
-	i2c_cmd_link_delete(cmd);
-	return true;
+	return I2C_registerWrite(devAddr, regAddr, length, data, false) == ESP_OK;
 }
 
 
@@ -264,4 +620,167 @@ int8_t I2C_readWord(uint8_t devAddr, uint8_t regAddr, uint16_t *data, uint16_t t
 	return 0;
 }
 
+bool I2C_shadowInit(i2c_shadow_t *shadow, uint8_t devAddr, const i2c_reg_range_t *volatile_regs, uint8_t volatile_count){
+	uint8_t i, slot = I2C_SHADOW_DEVICES;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	for(i = 0; i < I2C_SHADOW_DEVICES; i++){
+		/* A device initialized again replaces its previous copy */
+		if(shadows[i] != NULL && shadows[i]->devAddr == devAddr){
+			slot = i;
+			break;
+		}
+		if(shadows[i] == NULL && slot == I2C_SHADOW_DEVICES){
+			slot = i;
+		}
+	}
+	if(slot == I2C_SHADOW_DEVICES){
+		xSemaphoreGiveRecursive(shadow_mutex);
+		return false;
+	}
+	shadow->devAddr = devAddr;
+	shadow->volatile_regs = volatile_regs;
+	shadow->volatile_count = volatile_count;
+	shadow->deferred = false;
+	memset(shadow->valid, 0, sizeof(shadow->valid));
+	memset(shadow->dirty, 0, sizeof(shadow->dirty));
+	shadows[slot] = shadow;
+	xSemaphoreGiveRecursive(shadow_mutex);
+	return true;
+}
+
+bool I2C_shadowLoad(uint8_t devAddr, uint8_t regAddr, uint8_t length){
+	i2c_shadow_t *shadow;
+	uint8_t data[length];
+	uint16_t reg;
+	bool success = false;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	shadow = I2C_shadowFind(devAddr);
+	if(shadow != NULL && length != 0){
+		/* Values are kept by I2C_readBytes(), except the ones with pending writes */
+		for(reg = regAddr; reg < regAddr + length && reg < 256; reg++){
+			if(!BitGet(shadow->dirty, reg)){
+				BitClear(shadow->valid, reg);
+			}
+		}
+		success = (I2C_readBytes(devAddr, regAddr, length, data, I2C_MASTER_TIMEOUT_MS) == length);
+	}
+	xSemaphoreGiveRecursive(shadow_mutex);
+	return success;
+}
+
+void I2C_shadowInvalidate(uint8_t devAddr){
+	i2c_shadow_t *shadow;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	shadow = I2C_shadowFind(devAddr);
+	if(shadow != NULL){
+		memset(shadow->valid, 0, sizeof(shadow->valid));
+		memset(shadow->dirty, 0, sizeof(shadow->dirty));
+	}
+	xSemaphoreGiveRecursive(shadow_mutex);
+}
+
+void I2C_shadowBegin(uint8_t devAddr){
+	i2c_shadow_t *shadow;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	shadow = I2C_shadowFind(devAddr);
+	if(shadow != NULL){
+		shadow->deferred = true;
+	}
+	xSemaphoreGiveRecursive(shadow_mutex);
+}
+
+bool I2C_shadowCommit(uint8_t devAddr){
+	i2c_shadow_t *shadow;
+	bool success = true;
+
+	xSemaphoreTakeRecursive(shadow_mutex, portMAX_DELAY);
+	shadow = I2C_shadowFind(devAddr);
+	/* Without shadow copy writes are never delayed: nothing left to send */
+	if(shadow != NULL){
+		shadow->deferred = false;
+		success = (I2C_shadowFlush(shadow) == ESP_OK);
+	}
+	xSemaphoreGiveRecursive(shadow_mutex);
+	return success;
+}
+
+bool I2C_queueInit(uint8_t priority){
+	if(queue_task != NULL){
+		return true;
+	}
+	if(queue_mutex == NULL){
+		queue_mutex = xSemaphoreCreateMutexStatic(&queue_mutex_buffer);
+	}
+	return xTaskCreate(I2C_queueRun, "i2c_queue", I2C_QUEUE_TASK_STACK, NULL, priority, &queue_task) == pdPASS;
+}
+
+bool I2C_queueTransfer(i2c_trans_t *trans){
+	return I2C_queueTransfers(trans, 1);
+}
+
+bool I2C_queueTransfers(i2c_trans_t *trans, uint8_t count){
+	i2c_trans_t **p;
+
+	/* Nobody would make them */
+	if(queue_task == NULL){
+		return false;
+	}
+	xSemaphoreTake(queue_mutex, portMAX_DELAY);
+	for(uint8_t i = 0; i < count; i++){
+		trans[i].done = false;
+		/* After the transactions of the same or higher priority */
+		for(p = &queue_first; *p != NULL && (*p)->priority >= trans[i].priority; p = &(*p)->next);
+		trans[i].next = *p;
+		*p = &trans[i];
+	}
+	xSemaphoreGive(queue_mutex);
+	xTaskNotifyGive(queue_task);
+	return true;
+}
+
+bool I2C_getStats(uint8_t devAddr, i2c_stats_t *dev_stats){
+	bool found = false;
+
+	xSemaphoreTake(cmd_link_mutex, portMAX_DELAY);
+	for(uint8_t i = 0; i < I2C_STATS_DEVICES && !found; i++){
+		if(stats[i].transactions != 0 && stats[i].devAddr == devAddr){
+			*dev_stats = stats[i];
+			found = true;
+		}
+	}
+	xSemaphoreGive(cmd_link_mutex);
+	return found;
+}
+
+void I2C_resetStats(void){
+	xSemaphoreTake(cmd_link_mutex, portMAX_DELAY);
+	memset(stats, 0, sizeof(stats));
+	xSemaphoreGive(cmd_link_mutex);
+}
+
+void I2C_sendStats(uart_mcu_port_t port){
+	i2c_stats_t dev;
+	char line[128];
+
+	UartSendString(port, "addr transactions bytes nacks timeouts errors min_us avg_us max_us\r\n");
+	for(uint8_t i = 0; i < I2C_STATS_DEVICES; i++){
+		/* Copy under the mutex, send without it */
+		xSemaphoreTake(cmd_link_mutex, portMAX_DELAY);
+		dev = stats[i];
+		xSemaphoreGive(cmd_link_mutex);
+		if(dev.transactions == 0){
+			continue;
+		}
+		snprintf(line, sizeof(line), "0x%02X %lu %lu %lu %lu %lu %lu %lu %lu\r\n", dev.devAddr,
+				(unsigned long)dev.transactions, (unsigned long)dev.bytes, (unsigned long)dev.nacks,
+				(unsigned long)dev.timeouts, (unsigned long)dev.errors, (unsigned long)dev.latency_min,
+				(unsigned long)(dev.latency_total / dev.transactions), (unsigned long)dev.latency_max);
+		UartSendString(port, line);
+	}
+}
+
 /*==================[end of file]============================================*/
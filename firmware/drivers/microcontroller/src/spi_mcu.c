@@ -13,7 +13,10 @@
 #include "spi_mcu.h"
 #include <stdint.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "driver/spi_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "gpio_mcu.h"
 /*==================[macros and definitions]=================================*/
 #define PIN_NUM_MISO	GPIO_22	/*!<  */
@@ -22,84 +25,297 @@
 #define PIN_NUM_CS1		GPIO_19	/*!<  */
 #define PIN_NUM_CS2		GPIO_18	/*!<  */
 #define PIN_NUM_CS3		GPIO_9	/*!<  */
+#define TRANS_DC_COMMAND	(1 << 0)	/*!< Transaction flag: data/command line low during transfer */
+#define TRANS_NOTIFY		(1 << 1)	/*!< Transaction flag: call device callback when transfer ends */
+#define TRANS_ASYNC			(1 << 2)	/*!< Transaction flag: transaction is the driver data of a spi_trans_t */
+#define TRANS_DEVICE_SHIFT	4			/*!< Transaction flags: device number position */
+#define TransFlags(t)		((uintptr_t)(t)->user)	/*!< Flags stored in the transaction user field */
+#define TransDevice(t)		(TransFlags(t) >> TRANS_DEVICE_SHIFT)	/*!< Device number stored in the transaction user field */
+#define SPI_DEVICES			3			/*!< Number of devices (chip select lines) */
 /*==================[internal data declaration]==============================*/
-spi_device_handle_t spi_1, spi_2, spi_3;
+/**
+ * @brief Device registry entry: ESP-IDF handle and cached configuration of each chip select
+ */
+typedef struct {
+	spi_device_handle_t handle;		/*!< ESP-IDF device (NULL if not initialized) */
+	spi_mcu_config_t config;		/*!< Configuration the device was added with */
+	spi_transaction_t queued_trans[SPI_QUEUE_SIZE];	/*!< Queued transfers */
+	uint8_t queued_first;			/*!< Oldest queued transfer */
+	uint8_t queued_count;			/*!< Number of queued transfers in progress */
+	StaticSemaphore_t lock_buffer;	/*!< Device mutex memory */
+	SemaphoreHandle_t lock;			/*!< Device mutex (recursive): registry entry and queue */
+} spi_device_entry_t;
+
 const spi_bus_config_t bus_cfg = {
     .miso_io_num = PIN_NUM_MISO,
     .mosi_io_num = PIN_NUM_MOSI,
     .sclk_io_num = PIN_NUM_CLK,
     .quadwp_io_num = -1,
     .quadhd_io_num = -1,
-    .max_transfer_sz = 4092
+    .max_transfer_sz = SPI_MAX_TRANSFER_SIZE
 };
-transfer_mode_t transfer_mode_1, transfer_mode_2, transfer_mode_3;
-void (*spi_1_isr_p)(void*);	/*!<  */
-void (*spi_2_isr_p)(void*);	/*!<  */
-void (*spi_3_isr_p)(void*);	/*!<  */
-void *spi_1_user_data;	    /*!<  */
-void *spi_2_user_data;	    /*!<  */
-void *spi_3_user_data;	    /*!<  */
+static const gpio_t cs_gpio[SPI_DEVICES] = {PIN_NUM_CS1, PIN_NUM_CS2, PIN_NUM_CS3};	/*!< Chip select GPIO, for each device */
+static spi_device_entry_t spi_devices[SPI_DEVICES];	/*!< Device registry */
+static atomic_uint bus_waiting;				/*!< Number of tasks waiting for the bus */
+_Static_assert(sizeof(spi_transaction_t) <= sizeof(((spi_trans_t *)0)->driver), "SPI_TRANS_DRIVER_SIZE too small");
 /*==================[internal functions declaration]=========================*/
-static void IRAM_ATTR spi_1_isr(spi_transaction_t *t){
-	spi_1_isr_p(spi_1_user_data);
+static void IRAM_ATTR spi_async_end(spi_transaction_t *t){
+	spi_trans_t *trans = (spi_trans_t*)t;
+	trans->done = true;
+	if(trans->func_p != NULL){
+		trans->func_p(trans);
+	}
 }
-static void IRAM_ATTR spi_2_isr(spi_transaction_t *t){
-	spi_2_isr_p(spi_2_user_data);
+static void IRAM_ATTR spi_isr(spi_transaction_t *t){
+	spi_mcu_config_t *config = &spi_devices[TransDevice(t)].config;
+	if(TransFlags(t) & TRANS_ASYNC){
+		spi_async_end(t);
+	} else if((TransFlags(t) & TRANS_NOTIFY) && config->func_p != NULL){
+		((void (*)(void*))config->func_p)(config->param_p);
+	}
 }
-static void IRAM_ATTR spi_3_isr(spi_transaction_t *t){
-	spi_3_isr_p(spi_3_user_data);
+static void IRAM_ATTR spi_pre(spi_transaction_t *t){
+	GPIOState(spi_devices[TransDevice(t)].config.dc_gpio, !(TransFlags(t) & TRANS_DC_COMMAND));
 }
 /*==================[internal data definition]===============================*/
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Set the device number in a transaction (user field), so callbacks can find the device
+ * 
+ * @param device SPI device
+ * @param t transaction
+ */
+static void SpiTag(spi_dev_t device, spi_transaction_t *t){
+    t->user = (void*)((TransFlags(t) & ((1 << TRANS_DEVICE_SHIFT) - 1)) | ((uintptr_t)device << TRANS_DEVICE_SHIFT));
+}
+
+/**
+ * @brief Compare two device configurations
+ * 
+ * @param a configuration
+ * @param b configuration
+ * @return true if both configurations are the same
+ */
+static bool SpiSameConfig(const spi_mcu_config_t *a, const spi_mcu_config_t *b){
+    return a->clk_mode == b->clk_mode && a->bitrate == b->bitrate && a->transfer_mode == b->transfer_mode &&
+        a->func_p == b->func_p && a->param_p == b->param_p && a->dc_en == b->dc_en &&
+        (!a->dc_en || a->dc_gpio == b->dc_gpio);
+}
+
+/**
+ * @brief Take the mutex of a device (registry entry and queue)
+ * 
+ * @param device SPI device
+ */
+static void SpiLock(spi_dev_t device){
+    xSemaphoreTakeRecursive(spi_devices[device].lock, portMAX_DELAY);
+}
+
+/**
+ * @brief Release the mutex taken by SpiLock()
+ * 
+ * @param device SPI device
+ */
+static void SpiUnlock(spi_dev_t device){
+    xSemaphoreGiveRecursive(spi_devices[device].lock);
+}
+
+/**
+ * @brief Add a device to the bus with its cached configuration, replacing the previous one
+ * 
+ * @note The device mutex must be taken
+ * 
+ * @param device SPI device
+ * @return true when success
+ */
+static bool SpiAddDevice(spi_dev_t device){
+    spi_device_entry_t *dev = &spi_devices[device];
+    spi_device_interface_config_t dev_cfg = {
+        .clock_speed_hz = dev->config.bitrate,
+        .mode = dev->config.clk_mode,
+        .spics_io_num = cs_gpio[device],
+        .queue_size = SPI_QUEUE_SIZE,
+        /* Always set: asynchronous transfers end in it */
+        .post_cb = spi_isr,
+        .pre_cb = dev->config.dc_en ? spi_pre : NULL,
+    };
+    if(dev->handle != NULL){
+        SpiWaitQueued(device, 0);
+        spi_bus_remove_device(dev->handle);
+        dev->handle = NULL;
+    }
+    return spi_bus_add_device(SPI2_HOST, &dev_cfg, &dev->handle) == ESP_OK;
+}
+
+/**
+ * @brief Get exclusive use of the bus for a device, once its queued transfers have ended
+ * 
+ * @note While a task waits here, devices with queued transfers keep a single one in
+ * progress, so the bus is handed over after that transfer instead of a whole queue.
+ * 
+ * @param device SPI device
+ */
+static void SpiBusBegin(spi_dev_t device){
+    SpiWaitQueued(device, 0);
+    atomic_fetch_add(&bus_waiting, 1);
+    spi_device_acquire_bus(spi_devices[device].handle, portMAX_DELAY);
+    atomic_fetch_sub(&bus_waiting, 1);
+}
+
+/**
+ * @brief Release the bus taken by SpiBusBegin()
+ * 
+ * @param device SPI device
+ */
+static void SpiBusEnd(spi_dev_t device){
+    spi_device_release_bus(spi_devices[device].handle);
+}
+
+/**
+ * @brief Wait for room for a new queued transfer
+ * 
+ * @note The device mutex must be taken
+ * 
+ * @param device SPI device
+ */
+static void SpiQueueRoom(spi_dev_t device){
+    /* If there is no room for a new transfer, wait for the oldest one. If other device
+     * is waiting for the bus, keep only one transfer in progress */
+    SpiWaitQueued(device, (atomic_load(&bus_waiting) > 0) ? 1 : SPI_QUEUE_SIZE - 1);
+}
+
+/**
+ * @brief Send a transaction to a device using its transfer mode
+ * 
+ * @note The bus must have been taken with SpiBusBegin()
+ * 
+ * @param device SPI device
+ * @param t transaction to send
+ */
+static void SpiTransmit(spi_dev_t device, spi_transaction_t *t){
+    spi_device_entry_t *dev = &spi_devices[device];
+    switch(dev->config.transfer_mode){
+        case SPI_POLLING:
+            SpiTag(device, t);
+            if(TransFlags(t) & TRANS_NOTIFY){
+                /* Ends in the interrupt, where the device callback is called */
+                spi_device_transmit(dev->handle, t);
+            } else{
+                spi_device_polling_transmit(dev->handle, t);
+            }
+            break;
+        case SPI_INTERRUPT:
+            t->user = (void*)(TransFlags(t) | TRANS_NOTIFY);
+            SpiTag(device, t);
+            spi_device_transmit(dev->handle, t); 
+            break;
+    }
+}
+
+/**
+ * @brief Send one segment of a transfer list
+ * 
+ * @param device SPI device
+ * @param segment segment to send
+ */
+static void SpiSendSegment(spi_dev_t device, const spi_segment_t *segment){
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.length = segment->size * 8;
+    if(segment->size <= 4){
+        /* Short segments travel inside the transaction (no DMA descriptor) */
+        if(segment->tx_buffer != NULL){
+            t.flags |= SPI_TRANS_USE_TXDATA;
+            memcpy(t.tx_data, segment->tx_buffer, segment->size);
+        }
+        if(segment->rx_buffer != NULL){
+            t.flags |= SPI_TRANS_USE_RXDATA;
+            t.rxlength = segment->size * 8;
+        }
+    } else{
+        t.tx_buffer = segment->tx_buffer;
+        if(segment->rx_buffer != NULL){
+            t.rx_buffer = segment->rx_buffer;
+            t.rxlength = segment->size * 8;
+        }
+    }
+    if(segment->keep_cs){
+        t.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
+    }
+    t.user = (void*)(uintptr_t)((segment->command ? TRANS_DC_COMMAND : 0) | (segment->notify ? TRANS_NOTIFY : 0));
+    SpiTransmit(device, &t);
+    if((t.flags & SPI_TRANS_USE_RXDATA) != 0){
+        memcpy(segment->rx_buffer, t.rx_data, segment->size);
+    }
+}
+
+/**
+ * @brief Take the result of the oldest queued or asynchronous transfer of a device
+ * 
+ * @note The device mutex must be taken
+ * 
+ * @param device SPI device
+ * @param wait ticks to wait for the transfer to end
+ * @return spi_transaction_t* ended transfer, NULL if none ended
+ */
+static spi_transaction_t * SpiNextResult(spi_dev_t device, TickType_t wait){
+    spi_transaction_t *t;
+    spi_device_entry_t *dev = &spi_devices[device];
+    if(dev->queued_count == 0){
+        return NULL;
+    }
+    /* Transfers end in the same order they were queued */
+    if(spi_device_get_trans_result(dev->handle, &t, wait) != ESP_OK){
+        return NULL;
+    }
+    dev->queued_first = (dev->queued_first + 1) % SPI_QUEUE_SIZE;
+    dev->queued_count--;
+    return t;
+}
 
 /*==================[external functions definition]==========================*/
 uint8_t SpiInit(spi_mcu_config_t* spi){
     static bool spi_initialized = false;
+    spi_device_entry_t *dev = &spi_devices[spi->device];
+    uint8_t ret = true;
     if(!spi_initialized){
 	    spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
+        for(uint8_t i = 0; i < SPI_DEVICES; i++){
+            spi_devices[i].lock = xSemaphoreCreateRecursiveMutexStatic(&spi_devices[i].lock_buffer);
+        }
         spi_initialized = true;
     }
-	spi_device_interface_config_t dev_cfg = {
-        .clock_speed_hz = spi->bitrate,     	
-        .mode = spi->clk_mode,                  
-        .queue_size = 8,                        
-    };
-    switch(spi->device){
-        case SPI_1:
-            dev_cfg.spics_io_num = PIN_NUM_CS1;
-            transfer_mode_1 = spi->transfer_mode;
-            if(transfer_mode_1 == SPI_INTERRUPT){
-                dev_cfg.post_cb = spi_1_isr;
-            } 
-            spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_1);
-            spi_1_isr_p = spi->func_p;
-            spi_1_user_data = spi->param_p;
-            break;
-        case SPI_2:
-            dev_cfg.spics_io_num = PIN_NUM_CS2;
-            if(transfer_mode_2 == SPI_INTERRUPT){
-                dev_cfg.post_cb = spi_2_isr;
-            } 
-            transfer_mode_1 = spi->transfer_mode;
-            spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_2);
-            spi_2_isr_p = spi->func_p;
-            spi_2_user_data = spi->param_p;
-            break;
-        case SPI_3:
-            dev_cfg.spics_io_num = PIN_NUM_CS3;
-            if(transfer_mode_3 == SPI_INTERRUPT){
-                dev_cfg.post_cb = spi_3_isr;
-            } 
-            transfer_mode_1 = spi->transfer_mode;
-            spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_3);
-            spi_3_isr_p = spi->func_p;
-            spi_3_user_data = spi->param_p;
-            break;
+    SpiLock(spi->device);
+    /* Same configuration again: the device is kept as it is */
+    if(dev->handle == NULL || !SpiSameConfig(&dev->config, spi)){
+        if(spi->dc_en){
+            GPIOInit(spi->dc_gpio, GPIO_OUTPUT);
+        }
+        SpiWaitQueued(spi->device, 0);
+        dev->config = *spi;
+        ret = SpiAddDevice(spi->device);
+    }
+    SpiUnlock(spi->device);
+    return ret;
+}
+
+uint8_t SpiSetBitrate(spi_dev_t device, uint32_t bitrate){
+    spi_device_entry_t *dev = &spi_devices[device];
+    uint8_t ret = true;
+    if(dev->handle == NULL){
+        return false;
+    }
+    SpiLock(device);
+    if(dev->config.bitrate != bitrate){
+        /* ESP-IDF devices have a fixed clock: the device is added again with the new one */
+        dev->config.bitrate = bitrate;
+        ret = SpiAddDevice(device);
     }
-    return 0;
+    SpiUnlock(device);
+    return ret;
 }
 
 void SpiRead(spi_dev_t device, uint8_t * rx_buffer, uint32_t rx_buffer_size){
@@ -108,38 +324,9 @@ void SpiRead(spi_dev_t device, uint8_t * rx_buffer, uint32_t rx_buffer_size){
     t.length = rx_buffer_size * 8;  // tx_buffer_size is in bytes, transaction length is in bits.
     t.rxlength = rx_buffer_size * 8;
     t.rx_buffer = rx_buffer;        // Data
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+    SpiBusBegin(device);
+    SpiTransmit(device, &t);
+    SpiBusEnd(device);
 }
 
 void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size){
@@ -147,38 +334,90 @@ void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size){
     memset(&t, 0, sizeof(t));       // Zero out the transaction
     t.length = tx_buffer_size * 8;  // tx_buffer_size is in bytes, transaction length is in bits.
     t.tx_buffer = tx_buffer;        // Data
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
+    SpiBusBegin(device);
+    SpiTransmit(device, &t);
+    SpiBusEnd(device);
+}
+
+void SpiWriteCommand(spi_dev_t device, uint8_t cmd, uint8_t * param, uint32_t param_size){
+    spi_segment_t segments[2] = {
+        {.tx_buffer = &cmd, .size = 1, .command = true},
+        {.tx_buffer = param, .size = param_size},
+    };
+    SpiTransferList(device, segments, (param_size > 0) ? 2 : 1);
+}
+
+void SpiTransferList(spi_dev_t device, const spi_segment_t * segments, uint8_t count){
+    /* Hold the bus so the segments follow each other without other device in between */
+    SpiBusBegin(device);
+    for(uint8_t i = 0; i < count; i++){
+        SpiSendSegment(device, &segments[i]);
+    }
+    SpiBusEnd(device);
+}
+
+void SpiWriteQueued(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size, bool notify){
+    spi_device_entry_t *dev = &spi_devices[device];
+    spi_transaction_t *t;
+    SpiLock(device);
+    SpiQueueRoom(device);
+    t = &dev->queued_trans[(dev->queued_first + dev->queued_count) % SPI_QUEUE_SIZE];
+    memset(t, 0, sizeof(spi_transaction_t));
+    t->length = tx_buffer_size * 8;
+    t->tx_buffer = tx_buffer;
+    if(notify){
+        t->user = (void*)TRANS_NOTIFY;
+    }
+    SpiTag(device, t);
+    spi_device_queue_trans(dev->handle, t, portMAX_DELAY);
+    dev->queued_count++;
+    SpiUnlock(device);
+}
+
+void SpiWaitQueued(spi_dev_t device, uint8_t pending){
+    SpiLock(device);
+    while(spi_devices[device].queued_count > pending){
+        SpiNextResult(device, portMAX_DELAY);
+    }
+    SpiUnlock(device);
+}
+
+void SpiTransferAsync(spi_dev_t device, spi_trans_t * trans){
+    spi_device_entry_t *dev = &spi_devices[device];
+    spi_transaction_t *t = (spi_transaction_t*)trans->driver;
+    /* Asynchronous transfers take a place of the queue, but their descriptor is the caller's */
+    SpiLock(device);
+    SpiQueueRoom(device);
+    memset(t, 0, sizeof(spi_transaction_t));
+    t->length = trans->size * 8;
+    t->tx_buffer = trans->tx_buffer;
+    if(trans->rx_buffer != NULL){
+        t->rxlength = trans->size * 8;
+        t->rx_buffer = trans->rx_buffer;
+    }
+    t->user = (void*)TRANS_ASYNC;
+    SpiTag(device, t);
+    trans->done = false;
+    spi_device_queue_trans(dev->handle, t, portMAX_DELAY);
+    dev->queued_count++;
+    SpiUnlock(device);
+}
+
+spi_trans_t * SpiGetResult(spi_dev_t device, bool wait){
+    spi_transaction_t *t;
+    SpiLock(device);
+    /* Queued writes (SpiWriteQueued()) ended in between are skipped */
+    while((t = SpiNextResult(device, wait ? portMAX_DELAY : 0)) != NULL){
+        if(TransFlags(t) & TRANS_ASYNC){
             break;
+        }
     }
+    SpiUnlock(device);
+    return (spi_trans_t*)t;
+}
+
+void SpiFlush(spi_dev_t device){
+    SpiWaitQueued(device, 0);
 }
 
 void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, uint32_t buffer_size){
@@ -188,42 +427,22 @@ void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, ui
     t.rxlength = buffer_size * 8;
     t.tx_buffer = tx_buffer;        // Data
     t.rx_buffer = rx_buffer;        
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+    SpiBusBegin(device);
+    SpiTransmit(device, &t);
+    SpiBusEnd(device);
 }
 
 uint8_t SpiDeInit(spi_dev_t device){
-    return 0;
+    spi_device_entry_t *dev = &spi_devices[device];
+    if(dev->handle == NULL){
+        return false;
+    }
+    SpiLock(device);
+    SpiWaitQueued(device, 0);
+    spi_bus_remove_device(dev->handle);
+    dev->handle = NULL;
+    SpiUnlock(device);
+    return true;
 }
 
 /** @} doxygen end group definition */
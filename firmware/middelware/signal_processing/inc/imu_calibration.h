@@ -0,0 +1,179 @@
+#ifndef IMU_CALIBRATION_H_
+#define IMU_CALIBRATION_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Middelware Middelware
+ ** @{ */
+/** \addtogroup IMU_Calibration IMU Calibration
+ */
+
+/** \brief Calibration and unit conversion of accelerometer and gyroscope sample blocks, in fixed point
+ *
+ * @note Each sensor is corrected as out = M * (raw - offset): offset in raw LSB and M a
+ * 3 x 3 matrix from raw LSB to output units (scale, cross axis sensitivity and misalignment).
+ * Output units are chosen at ImuCalInit() (i.e. 1000 per g for mg, 10 per deg/s), the
+ * full scale in those units must fit in 16 bits: calibrations whose output could overflow
+ * 16 bits (summing the cross axis terms of every axis at full scale) are rejected.
+ * - Gyroscope: offset estimated with the sensor still (ImuCalGyroBias()), M from its sensitivity.
+ * - Accelerometer: six position calibration, each axis pointing up and down
+ * (ImuCalAccelPosition() and ImuCalAccelSolve()) gives the offset and the full matrix.
+ * The calibration can be kept in NVS (ImuCalSave() and ImuCalLoad()).
+ *
+ * @note ImuCalApply() converts whole blocks of interleaved samples (i.e. mpu6050_sample_t
+ * arrays or MPU6050_getMotion6() values) into one array per axis, ready for filtering or FFT.
+ * Blocks are processed with the ESP-DSP 16 bit vector routines (dsps_sub_s16, dsps_mul_s16
+ * and dsps_add_s16), 32 samples at a time: one subtraction per axis and one multiply (plus one
+ * add) for each non zero matrix coefficient. The difference to the offset is halved to fit in
+ * 16 bits, and the average rounding error of the fixed point steps is compensated in the offset.
+ * Only initialization and calibration use floating point.
+ *
+ * @author Peñalva Albano
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 17/10/2026 | Document creation		                         						|
+ * | 17/10/2026 | Calibrations that could overflow the 16 bit outputs are rejected		|
+ *
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+/*==================[macros]=================================================*/
+#define IMU_CAL_POSITIONS   6       /*!< Number of accelerometer calibration positions */
+
+/*==================[typedef]================================================*/
+/**
+ * @brief Accelerometer calibration positions: axis pointing up (measuring +1 g) or down
+ */
+typedef enum imu_cal_position {
+    IMU_CAL_X_UP,           /*!< X axis up */
+    IMU_CAL_X_DOWN,         /*!< X axis down */
+    IMU_CAL_Y_UP,           /*!< Y axis up */
+    IMU_CAL_Y_DOWN,         /*!< Y axis down */
+    IMU_CAL_Z_UP,           /*!< Z axis up */
+    IMU_CAL_Z_DOWN          /*!< Z axis down */
+} imu_cal_position_t;
+
+/**
+ * @brief Calibration of a 3 axis sensor
+ */
+typedef struct {
+    float units;                /*!< Output units per g or per deg/s */
+    float offset[3];            /*!< Offset (raw LSB) */
+    float matrix[3][3];         /*!< Output units per raw LSB */
+    int16_t offset_q[3];        /*!< Offset used by ImuCalApply(), with rounding compensation (raw LSB) */
+    int16_t matrix_q[3][3];     /*!< Coefficients used by ImuCalApply() (output units per 2 raw LSB, times 2^shift) */
+    uint8_t shift;              /*!< Scale of the coefficients */
+} imu_cal_axes_t;
+
+/**
+ * @brief Accelerometer and gyroscope calibration
+ */
+typedef struct {
+    imu_cal_axes_t accel;       /*!< Accelerometer */
+    imu_cal_axes_t gyro;        /*!< Gyroscope */
+} imu_cal_t;
+
+/**
+ * @brief Accelerometer six position measurements
+ */
+typedef struct {
+    float mean[IMU_CAL_POSITIONS][3];   /*!< Average of each position (raw LSB) */
+    uint8_t done;                       /*!< Measured positions (bit for each imu_cal_position_t) */
+} imu_cal_capture_t;
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief Initialize a calibration with the nominal sensitivities (no offsets nor cross axis terms)
+ *
+ * @param cal               Calibration
+ * @param accel_sensitivity Accelerometer sensitivity (LSB per g, i.e. 16384 for MPU6050 at +/- 2 g)
+ * @param gyro_sensitivity  Gyroscope sensitivity (LSB per deg/s, i.e. 131 for MPU6050 at +/- 250 deg/s)
+ * @param accel_units       Accelerometer output units per g (i.e. 1000 for mg)
+ * @param gyro_units        Gyroscope output units per deg/s (i.e. 10 for tenths of deg/s)
+ * @return true     Calibration initialized
+ * @return false    Units out of range for 16 bit coefficients or outputs
+ */
+bool ImuCalInit(imu_cal_t * cal, float accel_sensitivity, float gyro_sensitivity, float accel_units, float gyro_units);
+
+/**
+ * @brief Estimate the gyroscope offset from a block taken with the sensor still
+ *
+ * @param cal               Calibration
+ * @param gyro              Gyroscope X of the first sample (Y and Z must follow it)
+ * @param step              Distance between samples (int16_t values, i.e. 3 for int16_t[][3] arrays)
+ * @param len               Number of samples
+ * @param max_range         Maximum difference between samples of an axis (raw LSB), to detect movement
+ * @return true     Offset updated
+ * @return false    Sensor moved during the block or offset out of range (calibration not changed)
+ */
+bool ImuCalGyroBias(imu_cal_t * cal, const int16_t * gyro, uint16_t step, uint16_t len, uint16_t max_range);
+
+/**
+ * @brief Measure one of the six accelerometer calibration positions, with the sensor still
+ *
+ * @param capture           Measurements (set done to 0 before the first position)
+ * @param position          Position measured
+ * @param accel             Accelerometer X of the first sample (Y and Z must follow it)
+ * @param step              Distance between samples (int16_t values)
+ * @param len               Number of samples
+ * @param max_range         Maximum difference between samples of an axis (raw LSB), to detect movement
+ * @return true     Position measured
+ * @return false    Sensor moved during the block
+ */
+bool ImuCalAccelPosition(imu_cal_capture_t * capture, imu_cal_position_t position, const int16_t * accel, uint16_t step, uint16_t len, uint16_t max_range);
+
+/**
+ * @brief Calculate the accelerometer offset and matrix from the six positions
+ *
+ * @param cal               Calibration
+ * @param capture           Measurements
+ * @return true     Accelerometer calibration updated
+ * @return false    Positions missing or not valid (calibration not changed)
+ */
+bool ImuCalAccelSolve(imu_cal_t * cal, const imu_cal_capture_t * capture);
+
+/**
+ * @brief Save a calibration in NVS
+ *
+ * @param cal               Calibration
+ * @return true     Calibration saved
+ * @return false    NVS not available
+ */
+bool ImuCalSave(const imu_cal_t * cal);
+
+/**
+ * @brief Load a calibration saved in NVS
+ *
+ * @note ImuCalInit() must be called first: the saved calibration is converted to its output units.
+ *
+ * @param cal               Calibration
+ * @return true     Calibration loaded
+ * @return false    No calibration saved (calibration not changed)
+ */
+bool ImuCalLoad(imu_cal_t * cal);
+
+/**
+ * @brief Calibrate a block of samples and split it into one array per axis
+ *
+ * @param cal               Calibration
+ * @param accel             Accelerometer X of the first sample, Y and Z following (NULL to skip)
+ * @param gyro              Gyroscope X of the first sample, Y and Z following (NULL to skip)
+ * @param step              Distance between samples (int16_t values, i.e. sizeof(mpu6050_sample_t) / 2)
+ * @param len               Number of samples
+ * @param accel_out         Accelerometer X, Y and Z output arrays of len values (output units)
+ * @param gyro_out          Gyroscope X, Y and Z output arrays of len values (output units)
+ */
+void ImuCalApply(const imu_cal_t * cal, const int16_t * accel, const int16_t * gyro, uint16_t step, uint16_t len,
+        int16_t * accel_out[3], int16_t * gyro_out[3]);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* IMU_CALIBRATION_H_ */
+
+/*==================[end of file]============================================*/
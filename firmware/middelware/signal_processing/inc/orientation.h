@@ -0,0 +1,106 @@
+#ifndef ORIENTATION_H_
+#define ORIENTATION_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Middelware Middelware
+ ** @{ */
+/** \addtogroup Orientation Orientation
+ */
+
+/** \brief Orientation estimation from accelerometer and gyroscope, in fixed point
+ *
+ * @note Two filters are available, both integrating the gyroscope into a quaternion and
+ * correcting its drift with the gravity direction measured by the accelerometer:
+ * - Complementary: the error between measured and estimated gravity is fed back to
+ * the gyroscope (Mahony, proportional only). Gain: Kp (1/s, i.e. 1 to 5).
+ * - Madgwick: a gradient descent step towards the measured gravity. Gain: beta (rad/s, i.e. 0.05 to 0.2).
+ * Without a magnetometer, yaw is gyroscope only and drifts.
+ *
+ * @note Inputs are raw sensor values (i.e. MPU6050_getMotion6()): accelerometer in any
+ * scale, gyroscope in LSB. Only OrientationInit() uses floating point. Updates use 32 bit
+ * integers with 64 bit products (quaternion in Q30), no division nor loops depending
+ * on data, so every update takes the same time. Cost of OrientationUpdate(): about 70
+ * products of 32 x 32 bits (mul + mulh on RV32IMAC) and 3 inverse square roots
+ * (normalization, a table lookup and 2 Newton iterations of 4 products each), plus
+ * one less normalization for the complementary filter.
+ *
+ * @note The gyroscope scale takes the finest format that fits in 32 bits for the
+ * sample period, so slow rates and wide gyroscope ranges don't overflow. The half
+ * rotation of one sample is limited to 1 rad (i.e. 2000 deg/s needs at least 18 Hz).
+ *
+ * @author Peñalva Albano
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 17/10/2026 | Document creation		                         						|
+ * | 17/10/2026 | Gyroscope scale format from the sample period							|
+ *
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+/*==================[macros]=================================================*/
+#define ORIENTATION_ONE     (1L << 30)      /*!< 1.0 in quaternion format (Q30) */
+
+/*==================[typedef]================================================*/
+/**
+ * @brief Orientation filters
+ */
+typedef enum orientation_filter {
+    ORIENTATION_COMPLEMENTARY,      /*!< Complementary (Mahony) filter */
+    ORIENTATION_MADGWICK            /*!< Madgwick filter */
+} orientation_filter_t;
+
+/**
+ * @brief Orientation filter state
+ */
+typedef struct {
+    orientation_filter_t filter;    /*!< Filter */
+    int32_t q[4];                   /*!< Orientation quaternion W, X, Y, Z (Q30), sensor to world */
+    int32_t gyro_scale;             /*!< Half rotation per gyroscope LSB and sample (rad, Q gyro_shift) */
+    int8_t gyro_shift;              /*!< Format of gyro_scale (30 to 46, 46 unless the sample period is long) */
+    int32_t gain;                   /*!< Correction per sample (Q30): Kp * dt / 2 or beta * dt */
+} orientation_t;
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief Initialize an orientation filter, level and facing forward
+ *
+ * @param orientation       Filter state
+ * @param filter            ORIENTATION_COMPLEMENTARY or ORIENTATION_MADGWICK
+ * @param sample_freq       Sample frequency (Hz)
+ * @param gyro_sensitivity  Gyroscope sensitivity (LSB per deg/s, i.e. 131 for MPU6050 at +/- 250 deg/s)
+ * @param gain              Kp (complementary, 1/s) or beta (Madgwick, rad/s)
+ */
+void OrientationInit(orientation_t * orientation, orientation_filter_t filter, float sample_freq, float gyro_sensitivity, float gain);
+
+/**
+ * @brief Update the orientation with a new sample
+ *
+ * @param orientation       Filter state
+ * @param accel             Accelerometer X, Y, Z (raw, any scale). Not used if all are 0
+ * @param gyro              Gyroscope X, Y, Z (raw)
+ */
+void OrientationUpdate(orientation_t * orientation, const int16_t accel[3], const int16_t gyro[3]);
+
+/**
+ * @brief Get the orientation as Euler angles (Z-Y-X: yaw, pitch, roll)
+ *
+ * @note Uses a table for the arc tangent (error about 0.01 degrees) and one division for each angle.
+ *
+ * @param orientation       Filter state
+ * @param roll              Rotation around X (hundredths of degree, -18000 to 18000)
+ * @param pitch             Rotation around Y (hundredths of degree, -9000 to 9000)
+ * @param yaw               Rotation around Z (hundredths of degree, -18000 to 18000)
+ */
+void OrientationGetEuler(const orientation_t * orientation, int16_t * roll, int16_t * pitch, int16_t * yaw);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* ORIENTATION_H_ */
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,339 @@
+/**
+ * @file imu_calibration.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "imu_calibration.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsps_add.h"
+#include "dsps_sub.h"
+#include "dsps_mul.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+/*==================[macros and definitions]=================================*/
+#define CHUNK           32          /*!< Samples processed by each call to the vector routines */
+#define NVS_NAMESPACE   "imu_cal"
+#define NVS_KEY         "cal"
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Average of a block of 3 axis samples
+ *
+ * @param x         X of the first sample
+ * @param step      Distance between samples (int16_t values)
+ * @param len       Number of samples
+ * @param mean      Average of each axis
+ * @param max_range Maximum difference between samples of an axis
+ * @return true     Average calculated
+ * @return false    Empty block or difference above max_range
+ */
+static bool Mean(const int16_t * x, uint16_t step, uint16_t len, float mean[3], uint16_t max_range){
+    int64_t sum;
+    int16_t min, max;
+    uint16_t i;
+    uint8_t j;
+
+    if(len == 0){
+        return false;
+    }
+    for(j = 0; j < 3; j++){
+        sum = 0;
+        min = INT16_MAX;
+        max = INT16_MIN;
+        for(i = 0; i < len; i++){
+            int16_t v = x[(uint32_t)i * step + j];
+            sum += v;
+            min = (v < min) ? v : min;
+            max = (v > max) ? v : max;
+        }
+        if(max - min > max_range){
+            return false;
+        }
+        mean[j] = (float)sum / len;
+    }
+    return true;
+}
+
+/**
+ * @brief Inverse of a 3 x 3 matrix
+ *
+ * @param a         Matrix
+ * @param inv       Inverse
+ * @return true     Inverse calculated
+ * @return false    Singular matrix
+ */
+static bool Invert(const float a[3][3], float inv[3][3]){
+    float det;
+    uint8_t i, j;
+
+    /* Adjugate (transposed cofactors) */
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            inv[j][i] = a[(i + 1) % 3][(j + 1) % 3] * a[(i + 2) % 3][(j + 2) % 3] -
+                        a[(i + 1) % 3][(j + 2) % 3] * a[(i + 2) % 3][(j + 1) % 3];
+        }
+    }
+    det = a[0][0] * inv[0][0] + a[0][1] * inv[1][0] + a[0][2] * inv[2][0];
+    if(det == 0.0f || !isfinite(det)){
+        return false;
+    }
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            inv[i][j] /= det;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Calculate the fixed point values used by ImuCalApply() from offset and matrix
+ *
+ * @param axes      Sensor calibration
+ * @return true     Values calculated
+ * @return false    Singular matrix, values out of 16 bits or outputs that could overflow 16 bits
+ */
+static bool Quantize(imu_cal_axes_t * axes){
+    float inv[3][3], max = 0, bias[3], offset;
+    int32_t low, high;
+    int64_t sum;
+    uint8_t i, j, shift = 0;
+
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            max = fmaxf(max, fabsf(axes->matrix[i][j]));
+        }
+    }
+    /* Coefficients multiply (raw - offset) / 2 */
+    max *= 2.0f;
+    if(max == 0.0f || max > INT16_MAX || !Invert(axes->matrix, inv)){
+        return false;
+    }
+    while(shift < 30 && max * (float)(1UL << (shift + 1)) <= INT16_MAX){
+        shift++;
+    }
+    axes->shift = shift;
+    for(i = 0; i < 3; i++){
+        bias[i] = 0;
+        for(j = 0; j < 3; j++){
+            axes->matrix_q[i][j] = lroundf(axes->matrix[i][j] * 2.0f * (float)(1UL << shift));
+            /* Each product is truncated: half an output unit less on average */
+            if(axes->matrix_q[i][j] != 0){
+                bias[i] -= 0.5f;
+            }
+        }
+    }
+    for(i = 0; i < 3; i++){
+        /* Output bias moved to the input, and half a raw LSB for the truncated halving */
+        offset = axes->offset[i] - 0.5f;
+        for(j = 0; j < 3; j++){
+            offset += inv[i][j] * bias[j];
+        }
+        if(offset < INT16_MIN || offset > INT16_MAX){
+            return false;
+        }
+        axes->offset_q[i] = lroundf(offset);
+    }
+    /* The vector routines don't saturate: the largest output (every axis at the rail
+     * away from its offset, plus the truncation of each product) must fit in 16 bits */
+    for(i = 0; i < 3; i++){
+        sum = 0;
+        for(j = 0; j < 3; j++){
+            low = ((int32_t)INT16_MIN - axes->offset_q[j]) >> 1;
+            high = ((int32_t)INT16_MAX - axes->offset_q[j]) >> 1;
+            sum += (int64_t)abs(axes->matrix_q[i][j]) * ((-low > high) ? -low : high);
+        }
+        if((sum >> shift) + 3 > INT16_MAX){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Calibrate the samples of a sensor, CHUNK at a time
+ *
+ * @param axes      Sensor calibration
+ * @param in        X of the first sample
+ * @param step      Distance between samples (int16_t values)
+ * @param len       Number of samples
+ * @param out       Output array of each axis
+ */
+static void ApplyAxes(const imu_cal_axes_t * axes, const int16_t * in, uint16_t step, uint16_t len, int16_t * out[3]){
+    int16_t diff[3][CHUNK], product[CHUNK];
+    uint16_t start, n;
+    uint8_t i, j;
+    bool first;
+
+    for(start = 0; start < len; start += n){
+        n = (len - start < CHUNK) ? (len - start) : CHUNK;
+        /* (raw - offset) / 2, one array per axis */
+        for(j = 0; j < 3; j++){
+            dsps_sub_s16(&in[(uint32_t)start * step + j], &axes->offset_q[j], diff[j], n, step, 0, 1, 1);
+        }
+        for(i = 0; i < 3; i++){
+            first = true;
+            for(j = 0; j < 3; j++){
+                if(axes->matrix_q[i][j] == 0){
+                    continue;
+                }
+                if(first){
+                    dsps_mul_s16(diff[j], &axes->matrix_q[i][j], &out[i][start], n, 1, 0, 1, axes->shift);
+                    first = false;
+                } else{
+                    dsps_mul_s16(diff[j], &axes->matrix_q[i][j], product, n, 1, 0, 1, axes->shift);
+                    dsps_add_s16(&out[i][start], product, &out[i][start], n, 1, 1, 1, 0);
+                }
+            }
+            if(first){
+                memset(&out[i][start], 0, n * sizeof(int16_t));
+            }
+        }
+    }
+}
+
+/*==================[external functions definition]==========================*/
+
+bool ImuCalInit(imu_cal_t * cal, float accel_sensitivity, float gyro_sensitivity, float accel_units, float gyro_units){
+    imu_cal_t new_cal;
+    uint8_t i;
+
+    memset(&new_cal, 0, sizeof(new_cal));
+    new_cal.accel.units = accel_units;
+    new_cal.gyro.units = gyro_units;
+    for(i = 0; i < 3; i++){
+        new_cal.accel.matrix[i][i] = accel_units / accel_sensitivity;
+        new_cal.gyro.matrix[i][i] = gyro_units / gyro_sensitivity;
+    }
+    if(!Quantize(&new_cal.accel) || !Quantize(&new_cal.gyro)){
+        return false;
+    }
+    *cal = new_cal;
+    return true;
+}
+
+bool ImuCalGyroBias(imu_cal_t * cal, const int16_t * gyro, uint16_t step, uint16_t len, uint16_t max_range){
+    imu_cal_axes_t axes = cal->gyro;
+
+    if(!Mean(gyro, step, len, axes.offset, max_range) || !Quantize(&axes)){
+        return false;
+    }
+    cal->gyro = axes;
+    return true;
+}
+
+bool ImuCalAccelPosition(imu_cal_capture_t * capture, imu_cal_position_t position, const int16_t * accel, uint16_t step, uint16_t len, uint16_t max_range){
+    if(position >= IMU_CAL_POSITIONS || !Mean(accel, step, len, capture->mean[position], max_range)){
+        return false;
+    }
+    capture->done |= 1 << position;
+    return true;
+}
+
+bool ImuCalAccelSolve(imu_cal_t * cal, const imu_cal_capture_t * capture){
+    imu_cal_axes_t axes = cal->accel;
+    float sensitivity[3][3];
+    uint8_t i, j;
+
+    if(capture->done != (1 << IMU_CAL_POSITIONS) - 1){
+        return false;
+    }
+    for(i = 0; i < 3; i++){
+        axes.offset[i] = 0;
+        for(j = 0; j < 3; j++){
+            /* Column j: raw LSB per g along axis j */
+            sensitivity[i][j] = (capture->mean[2 * j][i] - capture->mean[2 * j + 1][i]) / 2.0f;
+            axes.offset[i] += (capture->mean[2 * j][i] + capture->mean[2 * j + 1][i]) / 6.0f;
+        }
+        /* Positions swapped or sensor still */
+        if(sensitivity[i][i] <= 0.0f){
+            return false;
+        }
+    }
+    if(!Invert(sensitivity, axes.matrix)){
+        return false;
+    }
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            axes.matrix[i][j] *= axes.units;
+        }
+    }
+    if(!Quantize(&axes)){
+        return false;
+    }
+    cal->accel = axes;
+    return true;
+}
+
+bool ImuCalSave(const imu_cal_t * cal){
+    nvs_handle_t handle;
+    esp_err_t ret;
+
+    if(nvs_flash_init() != ESP_OK || nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK){
+        return false;
+    }
+    ret = nvs_set_blob(handle, NVS_KEY, cal, sizeof(imu_cal_t));
+    if(ret == ESP_OK){
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret == ESP_OK;
+}
+
+bool ImuCalLoad(imu_cal_t * cal){
+    nvs_handle_t handle;
+    imu_cal_t saved;
+    size_t size = sizeof(imu_cal_t);
+    esp_err_t ret;
+    uint8_t i, j;
+
+    if(nvs_flash_init() != ESP_OK || nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK){
+        return false;
+    }
+    ret = nvs_get_blob(handle, NVS_KEY, &saved, &size);
+    nvs_close(handle);
+    if(ret != ESP_OK || size != sizeof(imu_cal_t) || saved.accel.units == 0.0f || saved.gyro.units == 0.0f){
+        return false;
+    }
+    /* Keep the output units of the current calibration */
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            saved.accel.matrix[i][j] *= cal->accel.units / saved.accel.units;
+            saved.gyro.matrix[i][j] *= cal->gyro.units / saved.gyro.units;
+        }
+    }
+    saved.accel.units = cal->accel.units;
+    saved.gyro.units = cal->gyro.units;
+    if(!Quantize(&saved.accel) || !Quantize(&saved.gyro)){
+        return false;
+    }
+    *cal = saved;
+    return true;
+}
+
+void ImuCalApply(const imu_cal_t * cal, const int16_t * accel, const int16_t * gyro, uint16_t step, uint16_t len,
+        int16_t * accel_out[3], int16_t * gyro_out[3]){
+    if(accel != NULL){
+        ApplyAxes(&cal->accel, accel, step, len, accel_out);
+    }
+    if(gyro != NULL){
+        ApplyAxes(&cal->gyro, gyro, step, len, gyro_out);
+    }
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,233 @@
+/**
+ * @file orientation.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "orientation.h"
+#include <stdbool.h>
+/*==================[macros and definitions]=================================*/
+#define PI              3.14159265358979f
+#define ATAN_STEPS      64          /*!< Arc tangent table steps between 0 and 1 */
+#define GYRO_SHIFT_MAX  46          /*!< Finest format of gyro_scale (Q46) */
+#define GYRO_SHIFT_MIN  30          /*!< Coarsest format of gyro_scale (Q30, as the half rotation) */
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+/** 1 / sqrt(u) (Q30), for u in the middle of each 1/32 step between 0.25 and 1 */
+static const uint32_t inv_sqrt_table[24] = {
+    2083365155, 1970666148, 1874477404, 1791125178, 1717986918, 1653133683, 1595110809, 1542797797,
+    1495315679, 1451963954, 1412176548, 1375490368, 1341522400, 1309952745, 1280511845, 1252970736,
+    1227133513, 1202831433, 1179918260, 1158266544, 1137764631, 1118314230, 1099828424, 1082230034
+};
+
+/** atan(i / 64) (hundredths of degree) */
+static const int16_t atan_table[ATAN_STEPS + 1] = {
+    0, 90, 179, 268, 358, 447, 536, 624, 713, 800, 888, 975, 1062, 1148, 1234, 1319,
+    1404, 1488, 1571, 1653, 1735, 1817, 1897, 1977, 2056, 2134, 2211, 2287, 2363, 2438, 2511, 2584,
+    2657, 2728, 2798, 2867, 2936, 3003, 3070, 3136, 3201, 3264, 3327, 3390, 3451, 3511, 3571, 3629,
+    3687, 3744, 3800, 3855, 3909, 3963, 4016, 4067, 4119, 4169, 4218, 4267, 4315, 4363, 4409, 4455,
+    4500
+};
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Inverse square root: 1 / sqrt(x) = y / 2^shift
+ *
+ * @param x         Value (greater than 0)
+ * @param shift     Scale of the result
+ * @return uint32_t y, between 2^30 and 2^31
+ */
+static uint32_t InvSqrt(uint64_t x, int8_t * shift){
+    int8_t e = __builtin_clzll(x) - 3;
+    uint64_t m;
+    uint32_t u, y, y2, t;
+
+    /* x = m / 4^k, m between 2^60 and 2^62 (u = m / 2^62 between 0.25 and 1) */
+    if(e & 1){
+        e++;
+    }
+    m = (e >= 0) ? (x << e) : (x >> -e);
+    y = inv_sqrt_table[(m >> 57) - 8];
+    u = m >> 32;
+    /* Newton: y = y * (3 - u * y^2) / 2 */
+    y2 = ((uint64_t)y * y) >> 31;
+    t = ((uint64_t)u * y2) >> 29;
+    y = ((uint64_t)y * ((3UL << 30) - t)) >> 31;
+    y2 = ((uint64_t)y * y) >> 31;
+    t = ((uint64_t)u * y2) >> 29;
+    y = ((uint64_t)y * ((3UL << 30) - t)) >> 31;
+    *shift = 61 - e / 2;
+    return y;
+}
+
+/**
+ * @brief Scale a vector to length 1 (Q30)
+ *
+ * @param v         Vector (not all 0)
+ * @param n         Number of components
+ */
+static void Normalize(int32_t * v, uint8_t n){
+    uint64_t sum = 0;
+    uint32_t y;
+    int8_t shift;
+    uint8_t i;
+
+    for(i = 0; i < n; i++){
+        sum += (int64_t)v[i] * v[i];
+    }
+    y = InvSqrt(sum, &shift);
+    for(i = 0; i < n; i++){
+        v[i] = ((int64_t)v[i] * y) >> (shift - 30);
+    }
+}
+
+/**
+ * @brief Arc tangent of y / x, from a table with linear interpolation
+ *
+ * @param y         Y coordinate
+ * @param x         X coordinate
+ * @return int16_t Angle (hundredths of degree, -18000 to 18000)
+ */
+static int16_t Atan2(int32_t y, int32_t x){
+    uint32_t ax = (x < 0) ? -(int64_t)x : x;
+    uint32_t ay = (y < 0) ? -(int64_t)y : y;
+    uint32_t r, i, f;
+    int32_t angle;
+    bool swap = ay > ax;
+
+    if(ax == 0 && ay == 0){
+        return 0;
+    }
+    /* First octant: ratio between 0 and 1 (Q16) */
+    r = swap ? (((uint64_t)ax << 16) / ay) : (((uint64_t)ay << 16) / ax);
+    i = r >> 10;
+    f = r & 0x3FF;
+    angle = atan_table[i];
+    if(i < ATAN_STEPS){
+        angle += ((atan_table[i + 1] - atan_table[i]) * (int32_t)f + 512) >> 10;
+    }
+    if(swap){
+        angle = 9000 - angle;
+    }
+    if(x < 0){
+        angle = 18000 - angle;
+    }
+    return (y < 0) ? -angle : angle;
+}
+
+/*==================[external functions definition]==========================*/
+
+void OrientationInit(orientation_t * orientation, orientation_filter_t filter, float sample_freq, float gyro_sensitivity, float gain){
+    float dt = 1.0f / sample_freq;
+    float scale;
+
+    orientation->filter = filter;
+    orientation->q[0] = ORIENTATION_ONE;
+    orientation->q[1] = 0;
+    orientation->q[2] = 0;
+    orientation->q[3] = 0;
+    /* Half rotation per LSB: (pi / 180) / sensitivity * dt / 2, in the finest format that
+     * fits in 32 bits (longer sample periods take coarser formats) */
+    scale = (PI / 180.0f) / gyro_sensitivity * dt / 2.0f;
+    orientation->gyro_shift = GYRO_SHIFT_MAX;
+    while(orientation->gyro_shift > GYRO_SHIFT_MIN && scale * (float)(1LL << orientation->gyro_shift) >= (float)INT32_MAX){
+        orientation->gyro_shift--;
+    }
+    scale *= (float)(1LL << orientation->gyro_shift);
+    orientation->gyro_scale = (scale < (float)INT32_MAX) ? (int32_t)scale : INT32_MAX;
+    if(filter == ORIENTATION_COMPLEMENTARY){
+        orientation->gain = gain * dt / 2.0f * (float)ORIENTATION_ONE;
+    } else{
+        orientation->gain = gain * dt * (float)ORIENTATION_ONE;
+    }
+}
+
+void OrientationUpdate(orientation_t * orientation, const int16_t accel[3], const int16_t gyro[3]){
+    int32_t *q = orientation->q;
+    int64_t w = q[0], x = q[1], y = q[2], z = q[3];
+    int32_t h[3], a[3], v[3], f[3], s[4];
+    int64_t t;
+    uint8_t i;
+    bool correct = (accel[0] != 0 || accel[1] != 0 || accel[2] != 0);
+
+    /* Half rotation in this sample (rad, Q30), up to 1 rad: the update is first order */
+    for(i = 0; i < 3; i++){
+        t = ((int64_t)gyro[i] * orientation->gyro_scale) >> (orientation->gyro_shift - GYRO_SHIFT_MIN);
+        h[i] = (t > ORIENTATION_ONE) ? ORIENTATION_ONE : (t < -ORIENTATION_ONE) ? -ORIENTATION_ONE : t;
+    }
+    if(correct){
+        for(i = 0; i < 3; i++){
+            a[i] = accel[i];
+        }
+        Normalize(a, 3);
+        /* Gravity direction estimated by the quaternion (third row of rotation matrix) */
+        v[0] = (x * z - w * y) >> 29;
+        v[1] = (w * x + y * z) >> 29;
+        v[2] = (w * w - x * x - y * y + z * z) >> 30;
+    }
+    if(correct && orientation->filter == ORIENTATION_COMPLEMENTARY){
+        /* Rotation from estimated to measured gravity, fed back to the gyroscope */
+        h[0] += ((((int64_t)a[1] * v[2] - (int64_t)a[2] * v[1]) >> 30) * orientation->gain) >> 30;
+        h[1] += ((((int64_t)a[2] * v[0] - (int64_t)a[0] * v[2]) >> 30) * orientation->gain) >> 30;
+        h[2] += ((((int64_t)a[0] * v[1] - (int64_t)a[1] * v[0]) >> 30) * orientation->gain) >> 30;
+    }
+    /* q = q + q * (0, h) */
+    q[0] = w + ((-x * h[0] - y * h[1] - z * h[2]) >> 30);
+    q[1] = x + (( w * h[0] + y * h[2] - z * h[1]) >> 30);
+    q[2] = y + (( w * h[1] - x * h[2] + z * h[0]) >> 30);
+    q[3] = z + (( w * h[2] + x * h[1] - y * h[0]) >> 30);
+    if(correct && orientation->filter == ORIENTATION_MADGWICK){
+        /* Gradient of the gravity error, f (Q28) and J' * f (Q26), of the previous quaternion */
+        for(i = 0; i < 3; i++){
+            f[i] = ((int64_t)v[i] - a[i]) >> 2;
+        }
+        s[0] = (-2 * y * f[0] + 2 * x * f[1]) >> 32;
+        s[1] = ( 2 * z * f[0] + 2 * w * f[1] - 4 * x * f[2]) >> 32;
+        s[2] = (-2 * w * f[0] + 2 * z * f[1] - 4 * y * f[2]) >> 32;
+        s[3] = ( 2 * x * f[0] + 2 * y * f[1]) >> 32;
+        if(s[0] != 0 || s[1] != 0 || s[2] != 0 || s[3] != 0){
+            Normalize(s, 4);
+            for(i = 0; i < 4; i++){
+                q[i] -= ((int64_t)s[i] * orientation->gain) >> 30;
+            }
+        }
+    }
+    Normalize(q, 4);
+}
+
+void OrientationGetEuler(const orientation_t * orientation, int16_t * roll, int16_t * pitch, int16_t * yaw){
+    int64_t w = orientation->q[0], x = orientation->q[1], y = orientation->q[2], z = orientation->q[3];
+    int32_t sin_r, cos_r, sin_p, sin_y, cos_y, cos_p;
+    uint64_t sum;
+    uint32_t inv;
+    int8_t shift;
+
+    /* Q30 */
+    sin_r = (w * x + y * z) >> 29;
+    cos_r = ORIENTATION_ONE - ((x * x + y * y) >> 29);
+    sin_p = (w * y - z * x) >> 29;
+    sin_y = (w * z + x * y) >> 29;
+    cos_y = ORIENTATION_ONE - ((y * y + z * z) >> 29);
+    /* cos(pitch) = sqrt(sin_r^2 + cos_r^2) = sum / sqrt(sum) */
+    sum = ((int64_t)sin_r * sin_r + (int64_t)cos_r * cos_r) >> 30;
+    cos_p = 0;
+    if(sum != 0){
+        inv = InvSqrt(sum, &shift);
+        cos_p = (sum * inv) >> (shift - 15);
+    }
+    *roll = Atan2(sin_r, cos_r);
+    *pitch = Atan2(sin_p, cos_p);
+    *yaw = Atan2(sin_y, cos_y);
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,82 @@
+/**
+ * @file bench_motion6.c
+ * @brief Sample rate of MPU6050_getMotion6() (14 byte burst) on the virtual bus:
+ * register select and read as two transactions (before the repeated START) and as
+ * one transaction (I2C_readBytes()).
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <esp_timer.h>
+#include "i2c_mcu.h"
+#include "mpu6050.h"
+#include "virtual_i2c.h"
+#include "mpu6050_model.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define SAMPLES		1000
+/*==================[internal data definition]===============================*/
+static mpu6050_model_t model;
+/*==================[internal functions definition]==========================*/
+/** getMotion6() as it was: register select (START, address, register, STOP), then a
+ * read only transaction in a link of its own. */
+static void GetMotion6TwoTransactions(int16_t *ax, int16_t *ay, int16_t *az, int16_t *gx, int16_t *gy, int16_t *gz){
+	uint8_t data[14];
+	i2c_cmd_handle_t cmd;
+
+	I2C_SelectRegister(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_ACCEL_XOUT_H);
+	cmd = i2c_cmd_link_create();
+	i2c_master_start(cmd);
+	i2c_master_write_byte(cmd, (MPU6050_DEFAULT_ADDRESS << 1) | I2C_MASTER_READ, 1);
+	i2c_master_read(cmd, data, sizeof(data) - 1, I2C_MASTER_ACK);
+	i2c_master_read_byte(cmd, &data[sizeof(data) - 1], I2C_MASTER_NACK);
+	i2c_master_stop(cmd);
+	i2c_master_cmd_begin(I2C_NUM_0, cmd, 1000 / portTICK_PERIOD_MS);
+	i2c_cmd_link_delete(cmd);
+	*ax = (((int16_t)data[0]) << 8) | data[1];
+	*ay = (((int16_t)data[2]) << 8) | data[3];
+	*az = (((int16_t)data[4]) << 8) | data[5];
+	*gx = (((int16_t)data[8]) << 8) | data[9];
+	*gy = (((int16_t)data[10]) << 8) | data[11];
+	*gz = (((int16_t)data[12]) << 8) | data[13];
+}
+
+/** Samples per second of back to back reads.
+ * @param read getMotion6 implementation
+ * @param transactions Bus transactions of each read
+ */
+static double Rate(void (*read)(int16_t*, int16_t*, int16_t*, int16_t*, int16_t*, int16_t*), uint32_t *transactions){
+	int16_t ax, ay, az, gx, gy, gz;
+	int64_t start;
+
+	VirtualI2CReset();
+	MPU6050ModelInit(&model, MPU6050_DEFAULT_ADDRESS);
+	VirtualI2CResetCounters();
+	start = esp_timer_get_time();
+	for(int i = 0; i < SAMPLES; i++){
+		read(&ax, &ay, &az, &gx, &gy, &gz);
+	}
+	*transactions = VirtualI2CTransactions() / SAMPLES;
+	return SAMPLES * 1e6 / (double)(esp_timer_get_time() - start);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	static const uint32_t clocks[] = {100000, 400000};
+	uint32_t before_trans, after_trans;
+	double before, after;
+
+	printf("clock_hz before_trans before_sps after_trans after_sps gain\n");
+	for(unsigned i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++){
+		I2C_initialize(clocks[i]);
+		before = Rate(GetMotion6TwoTransactions, &before_trans);
+		after = Rate(MPU6050_getMotion6, &after_trans);
+		printf("%lu %lu %.0f %lu %.0f %+.1f%%\n", (unsigned long)clocks[i], (unsigned long)before_trans, before,
+				(unsigned long)after_trans, after, 100.0 * (after / before - 1));
+		CHECK_EQ(before_trans, 2);
+		CHECK_EQ(after_trans, 1);
+		CHECK(after > before);
+	}
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
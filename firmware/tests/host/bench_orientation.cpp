@@ -0,0 +1,220 @@
+/**
+ * @file bench_orientation.cpp
+ * @brief Accuracy and speed of the fixed point orientation filters (orientation.h)
+ * against the ESP-DSP 13 state EKF (ekf_imu13states), on the same synthetic data.
+ *
+ * The data is not a sensor capture: 60 s of MPU6050 output at 100 Hz are generated
+ * here from a known motion, smooth rotations on the three axes (up to 60 deg/s).
+ * The gyroscope model is +/- 250 deg/s with a constant bias and Gaussian noise, the
+ * accelerometer +/- 2 g with Gaussian noise, both quantized to int16_t as
+ * MPU6050_getMotion6() gives them. A real sensor adds what this model leaves out
+ * (bias drift, scale and cross axis errors, vibration, linear acceleration). Roll and pitch are compared with the
+ * true motion after the first 5 s (yaw has no reference without a magnetometer, so
+ * the EKF magnetometer measurement gets a variance that makes it count for nothing).
+ * Times are of this PC: what matters is the ratio, not the values.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "ekf_imu13states.h"
+extern "C" {
+#include "orientation.h"
+#include "test.h"
+}
+/*==================[macros and definitions]=================================*/
+#define SAMPLE_FREQ     100
+#define SAMPLES         (60 * SAMPLE_FREQ)
+#define SETTLE          (5 * SAMPLE_FREQ)       /*!< Samples not compared (filters converging) */
+#define GYRO_LSB        131.0                   /*!< LSB per deg/s (+/- 250 deg/s) */
+#define ACCEL_LSB       16384.0                 /*!< LSB per g (+/- 2 g) */
+#define PASSES          20                      /*!< Passes over the data to time the fixed point filters */
+#define DEG             (180.0 / M_PI)
+
+typedef struct {
+    int16_t accel[SAMPLES][3];
+    int16_t gyro[SAMPLES][3];
+    double roll[SAMPLES];           /*!< True roll (degrees) */
+    double pitch[SAMPLES];          /*!< True pitch (degrees) */
+} synthetic_t;
+
+typedef struct {
+    double rms_roll;
+    double rms_pitch;
+    double max;
+    double us;                      /*!< Time of one update (microseconds) */
+} result_t;
+/*==================[internal data definition]===============================*/
+static synthetic_t sim;
+static uint32_t seed = 12345;
+/*==================[internal functions definition]==========================*/
+/** Gaussian noise (Box-Muller on a fixed seed LCG, same data on every run) */
+static double Noise(double sigma){
+    double u1, u2;
+
+    seed = seed * 1664525u + 1013904223u;
+    u1 = (seed + 1.0) / 4294967297.0;
+    seed = seed * 1664525u + 1013904223u;
+    u2 = seed / 4294967296.0;
+    return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static int16_t Quantize(double value){
+    value = round(value);
+    return (value > 32767) ? 32767 : (value < -32768) ? -32768 : (int16_t)value;
+}
+
+static double Now(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/** Angular rate of the true motion (deg/s) */
+static void Rate(double t, double w[3]){
+    w[0] = 60.0 * sin(2.0 * M_PI * 0.30 * t);
+    w[1] = 45.0 * sin(2.0 * M_PI * 0.17 * t + 1.0);
+    w[2] = 30.0 * sin(2.0 * M_PI * 0.11 * t + 2.0);
+}
+
+/** Roll and pitch (degrees) of a quaternion, sensor to world */
+static void Euler(double w, double x, double y, double z, double *roll, double *pitch){
+    double s = 2.0 * (w * y - z * x);
+
+    *roll = atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y)) * DEG;
+    *pitch = asin((s > 1.0) ? 1.0 : (s < -1.0) ? -1.0 : s) * DEG;
+}
+
+/** Generate the sensor output of the true motion */
+static void Synthesize(void){
+    const double bias[3] = {0.5, -0.3, 0.8};
+    double q[4] = {1, 0, 0, 0}, r[4], w[3], h[3], n, s, c;
+    double dt = 1.0 / SAMPLE_FREQ;
+
+    for(int k = 0; k < SAMPLES; k++){
+        /* Exact rotation of this sample: q = q * (cos(|h|), sin(|h|) h / |h|), h = w dt / 2 */
+        Rate((k + 0.5) * dt, w);
+        for(int i = 0; i < 3; i++){
+            h[i] = w[i] / DEG * dt / 2.0;
+        }
+        n = sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+        c = cos(n);
+        s = (n > 0) ? sin(n) / n : 1.0;
+        r[0] = q[0] * c - s * (q[1] * h[0] + q[2] * h[1] + q[3] * h[2]);
+        r[1] = q[1] * c + s * (q[0] * h[0] + q[2] * h[2] - q[3] * h[1]);
+        r[2] = q[2] * c + s * (q[0] * h[1] - q[1] * h[2] + q[3] * h[0]);
+        r[3] = q[3] * c + s * (q[0] * h[2] + q[1] * h[1] - q[2] * h[0]);
+        for(int i = 0; i < 4; i++){
+            q[i] = r[i];
+        }
+        for(int i = 0; i < 3; i++){
+            sim.gyro[k][i] = Quantize((w[i] + bias[i] + Noise(0.05)) * GYRO_LSB);
+        }
+        /* Gravity in the sensor frame: third row of the rotation matrix */
+        sim.accel[k][0] = Quantize((2.0 * (q[1] * q[3] - q[0] * q[2]) + Noise(0.01)) * ACCEL_LSB);
+        sim.accel[k][1] = Quantize((2.0 * (q[0] * q[1] + q[2] * q[3]) + Noise(0.01)) * ACCEL_LSB);
+        sim.accel[k][2] = Quantize((q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3] + Noise(0.01)) * ACCEL_LSB);
+        Euler(q[0], q[1], q[2], q[3], &sim.roll[k], &sim.pitch[k]);
+    }
+}
+
+/** Add the error of a sample to a result (sums of squares until Finish()) */
+static void Compare(result_t *res, int k, double roll, double pitch){
+    double er = fmod(roll - sim.roll[k] + 540.0, 360.0) - 180.0;
+    double ep = pitch - sim.pitch[k];
+
+    if(k < SETTLE){
+        return;
+    }
+    res->rms_roll += er * er;
+    res->rms_pitch += ep * ep;
+    res->max = fmax(res->max, fmax(fabs(er), fabs(ep)));
+}
+
+static void Finish(result_t *res){
+    res->rms_roll = sqrt(res->rms_roll / (SAMPLES - SETTLE));
+    res->rms_pitch = sqrt(res->rms_pitch / (SAMPLES - SETTLE));
+}
+
+static result_t RunFixed(orientation_filter_t filter, float gain){
+    orientation_t o;
+    result_t res = {0, 0, 0, 0};
+    int16_t roll, pitch, yaw;
+    double start;
+
+    OrientationInit(&o, filter, SAMPLE_FREQ, GYRO_LSB, gain);
+    for(int k = 0; k < SAMPLES; k++){
+        OrientationUpdate(&o, sim.accel[k], sim.gyro[k]);
+        OrientationGetEuler(&o, &roll, &pitch, &yaw);
+        Compare(&res, k, roll / 100.0, pitch / 100.0);
+    }
+    Finish(&res);
+    start = Now();
+    for(int p = 0; p < PASSES; p++){
+        OrientationInit(&o, filter, SAMPLE_FREQ, GYRO_LSB, gain);
+        for(int k = 0; k < SAMPLES; k++){
+            OrientationUpdate(&o, sim.accel[k], sim.gyro[k]);
+        }
+    }
+    res.us = (Now() - start) / (PASSES * SAMPLES);
+    return res;
+}
+
+static result_t RunEkf(void){
+    ekf_imu13states *ekf = new ekf_imu13states();
+    result_t res = {0, 0, 0, 0};
+    /* Magnetometer variances first: no magnetometer on the MPU6050 */
+    float R[6] = {1e6, 1e6, 1e6, 0.01, 0.01, 0.01};
+    float gyro[3], accel[3], magn[3] = {1, 0, 0}, n;
+    double roll, pitch, start, time = 0;
+
+    ekf->Init();
+    for(int k = 0; k < SAMPLES; k++){
+        start = Now();
+        for(int i = 0; i < 3; i++){
+            gyro[i] = sim.gyro[k][i] / GYRO_LSB / DEG;
+            accel[i] = sim.accel[k][i];
+        }
+        n = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+        for(int i = 0; i < 3; i++){
+            accel[i] /= n;
+        }
+        ekf->Process(gyro, 1.0f / SAMPLE_FREQ);
+        ekf->UpdateRefMeasurement(accel, magn, R);
+        time += Now() - start;
+        Euler(ekf->X(0, 0), ekf->X(1, 0), ekf->X(2, 0), ekf->X(3, 0), &roll, &pitch);
+        Compare(&res, k, roll, pitch);
+    }
+    Finish(&res);
+    res.us = time / SAMPLES;
+    delete ekf;
+    return res;
+}
+
+static void Print(const char *name, const result_t *res, const result_t *ekf){
+    printf("%-14s %8.3f %9.3f %8.3f %9.2f %8.1f\n", name, res->rms_roll, res->rms_pitch, res->max, res->us, ekf->us / res->us);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+    result_t ekf, complementary, madgwick;
+
+    Synthesize();
+    ekf = RunEkf();
+    complementary = RunFixed(ORIENTATION_COMPLEMENTARY, 2.0f);
+    madgwick = RunFixed(ORIENTATION_MADGWICK, 0.1f);
+
+    printf("filter         rms_roll rms_pitch  max_err us/update speedup (degrees, after %d s)\n", SETTLE / SAMPLE_FREQ);
+    Print("ekf13", &ekf, &ekf);
+    Print("complementary", &complementary, &ekf);
+    Print("madgwick", &madgwick, &ekf);
+
+    CHECK(complementary.rms_roll < 2.0 && complementary.rms_pitch < 2.0);
+    CHECK(madgwick.rms_roll < 2.0 && madgwick.rms_pitch < 2.0);
+    CHECK(complementary.us < ekf.us && madgwick.us < ekf.us);
+    return TEST_END();
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,200 @@
+/**
+ * @file bench_triangle.c
+ * @brief Filled triangles: ILI9341DrawFilledTriangle() (fixed point edge walker of
+ * ILI9341DrawFilledPolygon()) against the float scanline fill it replaced, on the
+ * SPI panel fake.
+ *
+ * The old fill is kept here as it was: vertices sorted, the triangle split in a flat
+ * bottom and a flat top half, float slopes, one ILI9341DrawLine() for each row. Both
+ * draw the same random triangles (partly off the LCD included). SPI traffic and time
+ * are compared, and the pixels of both with an exact fill (the old one truncates its
+ * x coordinates and leaves out the flat top or bottom row of a triangle). Times are of this PC, which has a floating point unit: the
+ * ESP32-C6 has none, so every float step of the old fill is a library call there.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "ili9341.h"
+#include "fake_panel.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define TRIANGLES	2000
+#define PASSES		5		/*!< Passes over the triangles to time them */
+#define COMPARED	500		/*!< Triangles compared pixel by pixel */
+/*==================[internal data definition]===============================*/
+static int16_t vertex[TRIANGLES][6];
+static uint16_t expected[FAKE_PANEL_PAGES][FAKE_PANEL_COLUMNS];
+static uint32_t seed = 10;
+/*==================[internal functions definition]==========================*/
+static int16_t Random(int16_t min, int16_t max){
+	seed = seed * 1664525u + 1013904223u;
+	return min + (int16_t)((seed >> 8) % (uint32_t)(max - min + 1));
+}
+
+static double Now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/** Rows of a flat bottom (direction 1) or flat top (direction -1) half, as the old fill did */
+static void OldHalf(float x_start, int16_t y_start, int16_t y_stop, float invslope1, float invslope2, int8_t direction, uint16_t color){
+	float curx1 = x_start, curx2 = x_start;
+	int16_t y;
+
+	for (y = y_start; (direction > 0) ? (y < y_stop) : (y > y_stop); y += direction){
+		ILI9341DrawLine((int)curx1, y, (int)curx2, y, color);
+		curx1 += direction * invslope1;
+		curx2 += direction * invslope2;
+	}
+}
+
+/** ILI9341DrawFilledTriangle() before the edge walker (statics made locals) */
+static void OldFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
+	int16_t p[3][2] = {{x0, y0}, {x1, y1}, {x2, y2}}, t[2], x_aux;
+	int i, j;
+
+	/* Sorted by y, stable as the old comparisons were */
+	for (i = 1; i < 3; i++){
+		for (j = i; j > 0 && p[j][1] < p[j - 1][1]; j--){
+			memcpy(t, p[j], sizeof(t));
+			memcpy(p[j], p[j - 1], sizeof(t));
+			memcpy(p[j - 1], t, sizeof(t));
+		}
+	}
+	if (p[1][1] == p[2][1]){
+		OldHalf(p[0][0], p[0][1], p[1][1], (float)(p[1][0] - p[0][0]) / (float)(p[1][1] - p[0][1]),
+				(float)(p[2][0] - p[0][0]) / (float)(p[2][1] - p[0][1]), 1, color);
+	}
+	else if (p[0][1] == p[1][1]){
+		OldHalf(p[2][0], p[2][1], p[0][1], (float)(p[2][0] - p[0][0]) / (float)(p[2][1] - p[0][1]),
+				(float)(p[2][0] - p[1][0]) / (float)(p[2][1] - p[1][1]), -1, color);
+	}
+	else{
+		x_aux = (int)(p[0][0] + (float)(p[1][1] - p[0][1]) / (float)(p[2][1] - p[0][1]) * (p[2][0] - p[0][0]));
+		OldHalf(p[0][0], p[0][1], p[1][1], (float)(p[1][0] - p[0][0]) / (float)(p[1][1] - p[0][1]),
+				(float)(x_aux - p[0][0]) / (float)(p[1][1] - p[0][1]), 1, color);
+		OldHalf(p[2][0], p[2][1], p[1][1], (float)(p[2][0] - p[1][0]) / (float)(p[2][1] - p[1][1]),
+				(float)(p[2][0] - x_aux) / (float)(p[2][1] - p[1][1]), -1, color);
+		ILI9341DrawLine(p[1][0], p[1][1], x_aux, p[1][1], color);
+	}
+}
+
+static double Run(void (*fill)(int16_t, int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t), uint32_t *bytes, uint32_t *transfers){
+	double start;
+	int16_t *v;
+
+	FakePanelReset(ILI9341_BLACK);
+	start = Now();
+	for (int p = 0; p < PASSES; p++){
+		for (int k = 0; k < TRIANGLES; k++){
+			v = vertex[k];
+			fill(v[0], v[1], v[2], v[3], v[4], v[5], ILI9341_WHITE);
+		}
+	}
+	ILI9341WaitTransfer();
+	*bytes = FakePanelBytes() / PASSES;
+	*transfers = FakePanelStats.transfers / PASSES;
+	return (Now() - start) / (PASSES * TRIANGLES);
+}
+
+/** Exact fill: in each row, from the leftmost to the rightmost crossing of the
+ * outline, rounded to the nearest pixel */
+static void ReferenceTriangle(const int16_t *v, uint16_t color){
+	double x, left, right;
+	int16_t ymin, ymax;
+	const int16_t *a, *b;
+
+	ymin = v[1] < v[3] ? (v[1] < v[5] ? v[1] : v[5]) : (v[3] < v[5] ? v[3] : v[5]);
+	ymax = v[1] > v[3] ? (v[1] > v[5] ? v[1] : v[5]) : (v[3] > v[5] ? v[3] : v[5]);
+	for (int y = (ymin < 0) ? 0 : ymin; y <= ymax && y < ILI9341_HEIGHT; y++){
+		left = 1e9;
+		right = -1e9;
+		for (int e = 0; e < 3; e++){
+			a = &v[2 * e];
+			b = &v[2 * ((e + 1) % 3)];
+			if ((y < a[1] && y < b[1]) || (y > a[1] && y > b[1])){
+				continue;
+			}
+			for (int end = 0; end < 2; end++){
+				/* Both ends of a horizontal edge, the crossing of the others */
+				x = (a[1] == b[1]) ? (end ? b[0] : a[0]) : a[0] + (double)(b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]);
+				left = (x < left) ? x : left;
+				right = (x > right) ? x : right;
+			}
+		}
+		for (int px = (int)floor(left + 0.5); px <= (int)floor(right + 0.5); px++){
+			if (px >= 0 && px < ILI9341_WIDTH){
+				expected[y][px] = color;
+			}
+		}
+	}
+}
+
+/** Count the pixels of the panel that differ from the expected image */
+static uint32_t Compare(uint32_t *drawn){
+	uint32_t diff = 0;
+
+	for (int y = 0; y < FAKE_PANEL_PAGES; y++){
+		for (int x = 0; x < FAKE_PANEL_COLUMNS; x++){
+			diff += (FakePanel[y][x] != expected[y][x]);
+			*drawn += (FakePanel[y][x] == ILI9341_WHITE);
+		}
+	}
+	return diff;
+}
+
+/** Pixels drawn by each fill that differ from the exact fill, each triangle on its own */
+static void Differences(uint32_t *old_diff, uint32_t *old_drawn, uint32_t *new_diff, uint32_t *new_drawn){
+	int16_t *v;
+
+	*old_diff = *old_drawn = *new_diff = *new_drawn = 0;
+	for (int k = 0; k < COMPARED; k++){
+		v = vertex[k];
+		for (int y = 0; y < FAKE_PANEL_PAGES; y++){
+			for (int x = 0; x < FAKE_PANEL_COLUMNS; x++){
+				expected[y][x] = ILI9341_BLACK;
+			}
+		}
+		ReferenceTriangle(v, ILI9341_WHITE);
+		FakePanelReset(ILI9341_BLACK);
+		OldFilledTriangle(v[0], v[1], v[2], v[3], v[4], v[5], ILI9341_WHITE);
+		ILI9341WaitTransfer();
+		*old_diff += Compare(old_drawn);
+		FakePanelReset(ILI9341_BLACK);
+		ILI9341DrawFilledTriangle(v[0], v[1], v[2], v[3], v[4], v[5], ILI9341_WHITE);
+		ILI9341WaitTransfer();
+		*new_diff += Compare(new_drawn);
+	}
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	uint32_t old_bytes, old_transfers, new_bytes, new_transfers, old_diff, old_drawn, new_diff, new_drawn;
+	double old_us, new_us;
+
+	ILI9341Init(SPI_1, GPIO_2, GPIO_3);
+	for (int k = 0; k < TRIANGLES; k++){
+		for (int i = 0; i < 3; i++){
+			vertex[k][2 * i] = Random(-40, ILI9341_WIDTH + 40);
+			vertex[k][2 * i + 1] = Random(-40, ILI9341_HEIGHT + 40);
+		}
+	}
+	old_us = Run(OldFilledTriangle, &old_bytes, &old_transfers);
+	new_us = Run(ILI9341DrawFilledTriangle, &new_bytes, &new_transfers);
+	Differences(&old_diff, &old_drawn, &new_diff, &new_drawn);
+
+	printf("fill        us/triangle  SPI bytes  transfers  wrong pixels (%d triangles, first %d compared)\n", TRIANGLES, COMPARED);
+	printf("float       %11.2f %10u %10u %13.3f%%\n", old_us, old_bytes, old_transfers, 100.0 * old_diff / old_drawn);
+	printf("edge walker %11.2f %10u %10u %13.3f%%\n", new_us, new_bytes, new_transfers, 100.0 * new_diff / new_drawn);
+
+	/* The edge walker is the exact fill but for the 16.16 truncation of the steps */
+	CHECK(new_diff < new_drawn / 1000);
+	CHECK(new_transfers <= old_transfers);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
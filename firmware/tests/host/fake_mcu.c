@@ -0,0 +1,249 @@
+/**
+ * @file fake_mcu.c
+ * @brief GPIO, delay, UART and NVS for host tests (see fake_mcu.h).
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <string.h>
+#include "gpio_mcu.h"
+#include "delay_mcu.h"
+#include "uart_mcu.h"
+#include "nvs_flash.h"
+#include "virtual_i2c.h"
+#include "fake_mcu.h"
+/*==================[macros and definitions]=================================*/
+#define FAKE_GPIOS	32
+#define NVS_ENTRIES	8
+#define NVS_NAME	16		/*!< Namespace and key size (15 characters, as ESP-IDF) */
+#define NVS_BLOB	512
+#define NVS_HANDLES	4
+#define UART_OUTPUT	2048	/*!< Characters kept of the UART output */
+
+typedef struct {
+	char name[NVS_NAME];
+	char key[NVS_NAME];
+	uint8_t data[NVS_BLOB];
+	size_t size;			/*!< 0 if the entry is free */
+} nvs_entry_t;
+
+typedef struct {
+	char name[NVS_NAME];
+	nvs_open_mode_t mode;
+	bool open;
+} nvs_open_t;
+/*==================[internal data definition]===============================*/
+static void (*handlers[FAKE_GPIOS])(void *);
+static void *handler_args[FAKE_GPIOS];
+static bool levels[FAKE_GPIOS];
+static nvs_entry_t nvs[NVS_ENTRIES];
+static nvs_open_t nvs_handles[NVS_HANDLES];
+static char uart_output[UART_OUTPUT];
+static size_t uart_used;
+/*==================[internal functions definition]==========================*/
+/** Print UART output and keep it for FakeUartOutput() */
+static void UartOut(const char *data, size_t size){
+	fwrite(data, 1, size, stdout);
+	if(size > UART_OUTPUT - 1 - uart_used){
+		size = UART_OUTPUT - 1 - uart_used;
+	}
+	memcpy(&uart_output[uart_used], data, size);
+	uart_used += size;
+	uart_output[uart_used] = '\0';
+}
+static nvs_entry_t* NvsFind(nvs_handle_t handle, const char *key){
+	for(int i = 0; i < NVS_ENTRIES; i++){
+		if(nvs[i].size > 0 && strcmp(nvs[i].name, nvs_handles[handle].name) == 0 && strcmp(nvs[i].key, key) == 0){
+			return &nvs[i];
+		}
+	}
+	return NULL;
+}
+/*==================[external functions definition]==========================*/
+void FakeGpioInterrupt(gpio_t pin){
+	if(pin < FAKE_GPIOS && handlers[pin] != NULL){
+		handlers[pin](handler_args[pin]);
+	}
+}
+
+bool FakeGpioHasInterrupt(gpio_t pin){
+	return pin < FAKE_GPIOS && handlers[pin] != NULL;
+}
+
+void FakeGpioReset(void){
+	memset(handlers, 0, sizeof(handlers));
+	memset(handler_args, 0, sizeof(handler_args));
+}
+
+void GPIOInit(gpio_t pin, io_t io){
+	(void)pin;
+	(void)io;
+}
+
+void GPIOOn(gpio_t pin){
+	GPIOState(pin, true);
+}
+
+void GPIOOff(gpio_t pin){
+	GPIOState(pin, false);
+}
+
+void GPIOState(gpio_t pin, bool state){
+	if(pin < FAKE_GPIOS){
+		levels[pin] = state;
+	}
+}
+
+void GPIOToggle(gpio_t pin){
+	GPIOState(pin, !GPIORead(pin));
+}
+
+bool GPIORead(gpio_t pin){
+	return pin < FAKE_GPIOS && levels[pin];
+}
+
+void GPIOActivInt(gpio_t pin, void *ptr_int_func, bool edge, void *args){
+	(void)edge;
+	if(pin < FAKE_GPIOS){
+		handlers[pin] = (void (*)(void *))ptr_int_func;
+		handler_args[pin] = args;
+	}
+}
+
+void GPIOInputFilter(gpio_t pin){
+	(void)pin;
+}
+
+void GPIODeinit(void){
+	FakeGpioReset();
+}
+
+void DelaySec(uint16_t sec){
+	VirtualI2CAdvance((int64_t)sec * 1000000);
+}
+
+void DelayMs(uint16_t msec){
+	VirtualI2CAdvance((int64_t)msec * 1000);
+}
+
+void DelayUs(uint16_t usec){
+	VirtualI2CAdvance(usec);
+}
+
+void UartInit(serial_config_t *port_config){
+	(void)port_config;
+}
+
+void UartSendByte(uart_mcu_port_t port, const char *data){
+	(void)port;
+	UartOut(data, 1);
+}
+
+void UartSendString(uart_mcu_port_t port, const char *msg){
+	(void)port;
+	UartOut(msg, strlen(msg));
+}
+
+void UartSendBuffer(uart_mcu_port_t port, const char *data, uint8_t nbytes){
+	(void)port;
+	UartOut(data, nbytes);
+}
+
+const char* FakeUartOutput(void){
+	return uart_output;
+}
+
+void FakeUartClear(void){
+	uart_used = 0;
+	uart_output[0] = '\0';
+}
+
+void FakeNvsErase(void){
+	memset(nvs, 0, sizeof(nvs));
+	memset(nvs_handles, 0, sizeof(nvs_handles));
+}
+
+esp_err_t nvs_flash_init(void){
+	return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle){
+	if(strlen(name) >= NVS_NAME){
+		return ESP_ERR_INVALID_ARG;
+	}
+	for(nvs_handle_t i = 0; i < NVS_HANDLES; i++){
+		if(!nvs_handles[i].open){
+			strcpy(nvs_handles[i].name, name);
+			nvs_handles[i].mode = open_mode;
+			nvs_handles[i].open = true;
+			*out_handle = i;
+			return ESP_OK;
+		}
+	}
+	return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length){
+	nvs_entry_t *entry = NvsFind(handle, key);
+
+	if(nvs_handles[handle].mode == NVS_READONLY){
+		return ESP_ERR_NVS_READ_ONLY;
+	}
+	if(strlen(key) >= NVS_NAME || length == 0 || length > NVS_BLOB){
+		return ESP_ERR_INVALID_ARG;
+	}
+	for(int i = 0; i < NVS_ENTRIES && entry == NULL; i++){
+		if(nvs[i].size == 0){
+			entry = &nvs[i];
+			strcpy(entry->name, nvs_handles[handle].name);
+			strcpy(entry->key, key);
+		}
+	}
+	if(entry == NULL){
+		return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+	}
+	memcpy(entry->data, value, length);
+	entry->size = length;
+	return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length){
+	nvs_entry_t *entry = NvsFind(handle, key);
+
+	if(entry == NULL){
+		return ESP_ERR_NVS_NOT_FOUND;
+	}
+	if(out_value == NULL){
+		*length = entry->size;
+		return ESP_OK;
+	}
+	if(*length < entry->size){
+		return ESP_ERR_NVS_INVALID_LENGTH;
+	}
+	memcpy(out_value, entry->data, entry->size);
+	*length = entry->size;
+	return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle){
+	(void)handle;
+	return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle){
+	nvs_handles[handle].open = false;
+}
+
+uint8_t* UartItoa(uint32_t val, uint8_t base){
+	static char text[33];
+	char *p = &text[sizeof(text) - 1];
+
+	*p = '\0';
+	do{
+		*--p = "0123456789ABCDEF"[val % base];
+		val /= base;
+	} while(val > 0);
+	return (uint8_t *)p;
+}
+
+/*==================[end of file]============================================*/
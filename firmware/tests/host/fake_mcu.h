@@ -0,0 +1,39 @@
+#ifndef FAKE_MCU_H_
+#define FAKE_MCU_H_
+/**
+ * @file fake_mcu.h
+ * @brief GPIO, delay, UART and NVS for host tests.
+ *
+ * @note Delays advance the virtual clock of virtual_i2c.c instead of sleeping.
+ * GPIO interrupts are raised by FakeGpioInterrupt(), from the caller thread.
+ * NVS keeps a few small blobs in memory, for the whole test program. UART output
+ * is printed, and kept (all ports together) until FakeUartClear().
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdbool.h>
+#include "gpio_mcu.h"
+/*==================[external functions declaration]=========================*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+/** Call the interrupt handler installed on a pin, if any. */
+void FakeGpioInterrupt(gpio_t pin);
+
+/** Check if a pin has an interrupt handler. */
+bool FakeGpioHasInterrupt(gpio_t pin);
+
+/** Remove every interrupt handler. */
+void FakeGpioReset(void);
+
+/** Characters sent to the UARTs since the last FakeUartClear() (the first 2047). */
+const char* FakeUartOutput(void);
+/** Forget the UART output. */
+void FakeUartClear(void);
+/** Erase every NVS entry (and close the handles). */
+void FakeNvsErase(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAKE_MCU_H_ */
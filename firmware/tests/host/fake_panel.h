@@ -0,0 +1,48 @@
+#ifndef FAKE_PANEL_H_
+#define FAKE_PANEL_H_
+/**
+ * @file fake_panel.h
+ * @brief SPI driver that decodes ILI9341 commands into a memory image, for host tests.
+ *
+ * @note CASET, PASET, RAMWR and RAMWR continue are decoded: pixels land on the
+ * panel as the LCD controller would store them (address window, page by page).
+ * VSCRDEF and VSCRSADD set the scroll registers. Other commands and their
+ * parameters are only counted. Transfers are done when
+ * the call returns, queued ones included.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+/*==================[macros]=================================================*/
+#define FAKE_PANEL_COLUMNS	320		/*!< Columns of the image (covers every orientation) */
+#define FAKE_PANEL_PAGES	320		/*!< Pages (rows) of the image */
+/*==================[typedef]================================================*/
+typedef struct {
+	uint32_t commands;		/*!< Command bytes */
+	uint32_t parameters;	/*!< Parameter bytes */
+	uint32_t pixels;		/*!< Pixel bytes (after RAMWR) */
+	uint32_t transfers;		/*!< SPI transactions (each segment of a list counted) */
+	uint32_t windows;		/*!< RAMWR commands */
+} fake_panel_stats_t;
+
+typedef struct {
+	uint16_t top;			/*!< Top fixed area (VSCRDEF) */
+	uint16_t length;		/*!< Vertical scrolling area (VSCRDEF) */
+	uint16_t bottom;		/*!< Bottom fixed area (VSCRDEF) */
+	uint16_t start;			/*!< Memory page shown first in the scrolling area (VSCRSADD) */
+} fake_panel_scroll_t;
+
+/*==================[external data declaration]==============================*/
+extern uint16_t FakePanel[FAKE_PANEL_PAGES][FAKE_PANEL_COLUMNS];	/*!< Pixels, RGB565 */
+extern fake_panel_stats_t FakePanelStats;
+extern fake_panel_scroll_t FakePanelScroll;		/*!< Scroll registers, kept by FakePanelReset() */
+
+/*==================[external functions declaration]=========================*/
+/** Clear the image to a color and the counters to zero. */
+void FakePanelReset(uint16_t color);
+
+/** Total bytes sent to the LCD since the last reset. */
+uint32_t FakePanelBytes(void);
+
+#endif /* FAKE_PANEL_H_ */
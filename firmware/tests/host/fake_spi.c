@@ -0,0 +1,182 @@
+/**
+ * @file fake_spi.c
+ * @brief SPI driver writing to an ILI9341 memory image (see fake_panel.h).
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include "spi_mcu.h"
+#include "fake_panel.h"
+/*==================[macros and definitions]=================================*/
+#define CMD_CASET		0x2A
+#define CMD_PASET		0x2B
+#define CMD_RAMWR		0x2C
+#define CMD_RAMWR_CONT	0x3C
+#define CMD_VSCRDEF		0x33
+#define CMD_VSCRSADD	0x37
+/*==================[internal data definition]===============================*/
+uint16_t FakePanel[FAKE_PANEL_PAGES][FAKE_PANEL_COLUMNS];
+fake_panel_stats_t FakePanelStats;
+fake_panel_scroll_t FakePanelScroll = {0, FAKE_PANEL_PAGES, 0, 0};
+
+static spi_mcu_config_t config;
+static uint8_t command;					/*!< Last command */
+static uint8_t params[6];				/*!< Parameters of the last command */
+static uint32_t param_count;
+static uint16_t columns[2], pages[2];	/*!< Address window */
+static uint16_t column, page;			/*!< Memory pointer */
+static uint8_t high_byte;
+static bool odd;						/*!< First byte of a pixel received */
+/*==================[internal functions definition]==========================*/
+static void Command(uint8_t cmd){
+	FakePanelStats.commands++;
+	command = cmd;
+	param_count = 0;
+	odd = false;
+	if(cmd == CMD_RAMWR){
+		FakePanelStats.windows++;
+		column = columns[0];
+		page = pages[0];
+	}
+}
+
+static void Pixel(uint16_t color){
+	if(page < FAKE_PANEL_PAGES && column < FAKE_PANEL_COLUMNS && page <= pages[1]){
+		FakePanel[page][column] = color;
+	}
+	if(++column > columns[1]){
+		column = columns[0];
+		page++;
+	}
+}
+
+static void Data(const uint8_t *data, uint32_t size){
+	for(uint32_t i = 0; i < size; i++){
+		if(command == CMD_RAMWR || command == CMD_RAMWR_CONT){
+			FakePanelStats.pixels++;
+			if(odd){
+				Pixel((high_byte << 8) | data[i]);
+			} else{
+				high_byte = data[i];
+			}
+			odd = !odd;
+			continue;
+		}
+		FakePanelStats.parameters++;
+		if(param_count < sizeof(params)){
+			params[param_count] = data[i];
+		}
+		if(++param_count == 4 && (command == CMD_CASET || command == CMD_PASET)){
+			uint16_t *window = (command == CMD_CASET) ? columns : pages;
+			window[0] = (params[0] << 8) | params[1];
+			window[1] = (params[2] << 8) | params[3];
+		}
+		if(param_count == 6 && command == CMD_VSCRDEF){
+			FakePanelScroll.top = (params[0] << 8) | params[1];
+			FakePanelScroll.length = (params[2] << 8) | params[3];
+			FakePanelScroll.bottom = (params[4] << 8) | params[5];
+		}
+		if(param_count == 2 && command == CMD_VSCRSADD){
+			FakePanelScroll.start = (params[0] << 8) | params[1];
+		}
+	}
+}
+
+static void Done(void){
+	if(config.func_p != NULL){
+		((void (*)(void *))config.func_p)(config.param_p);
+	}
+}
+/*==================[external functions definition]==========================*/
+void FakePanelReset(uint16_t color){
+	for(uint32_t p = 0; p < FAKE_PANEL_PAGES; p++){
+		for(uint32_t c = 0; c < FAKE_PANEL_COLUMNS; c++){
+			FakePanel[p][c] = color;
+		}
+	}
+	memset(&FakePanelStats, 0, sizeof(FakePanelStats));
+}
+
+uint32_t FakePanelBytes(void){
+	return FakePanelStats.commands + FakePanelStats.parameters + FakePanelStats.pixels;
+}
+
+uint8_t SpiInit(spi_mcu_config_t *spi){
+	config = *spi;
+	return 1;
+}
+
+uint8_t SpiSetBitrate(spi_dev_t device, uint32_t bitrate){
+	(void)device;
+	config.bitrate = bitrate;
+	return 1;
+}
+
+void SpiWrite(spi_dev_t device, uint8_t *tx_buffer, uint32_t tx_buffer_size){
+	(void)device;
+	FakePanelStats.transfers++;
+	Data(tx_buffer, tx_buffer_size);
+}
+
+void SpiWriteCommand(spi_dev_t device, uint8_t cmd, uint8_t *param, uint32_t param_size){
+	(void)device;
+	FakePanelStats.transfers++;
+	Command(cmd);
+	if(param != NULL && param_size > 0){
+		FakePanelStats.transfers++;
+		Data(param, param_size);
+	}
+}
+
+void SpiTransferList(spi_dev_t device, const spi_segment_t *segments, uint8_t count){
+	(void)device;
+	for(uint8_t i = 0; i < count; i++){
+		FakePanelStats.transfers++;
+		if(segments[i].command){
+			Command(segments[i].tx_buffer[0]);
+			Data(&segments[i].tx_buffer[1], segments[i].size - 1);
+		} else{
+			Data(segments[i].tx_buffer, segments[i].size);
+		}
+		if(segments[i].notify){
+			Done();
+		}
+	}
+}
+
+void SpiWriteQueued(spi_dev_t device, uint8_t *tx_buffer, uint32_t tx_buffer_size, bool notify){
+	(void)device;
+	FakePanelStats.transfers++;
+	Data(tx_buffer, tx_buffer_size);
+	if(notify){
+		Done();
+	}
+}
+
+void SpiWaitQueued(spi_dev_t device, uint8_t pending){
+	(void)device;
+	(void)pending;
+}
+
+void SpiFlush(spi_dev_t device){
+	(void)device;
+}
+
+void SpiRead(spi_dev_t device, uint8_t *rx_buffer, uint32_t rx_buffer_size){
+	(void)device;
+	memset(rx_buffer, 0, rx_buffer_size);
+}
+
+void SpiReadWrite(spi_dev_t device, uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t buffer_size){
+	(void)device;
+	FakePanelStats.transfers++;
+	Data(tx_buffer, buffer_size);
+	memset(rx_buffer, 0, buffer_size);
+}
+
+uint8_t SpiDeInit(spi_dev_t device){
+	(void)device;
+	return 1;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,191 @@
+/**
+ * @file fake_spi_master.c
+ * @brief ESP-IDF SPI master on the host (see fake_spi_master.h).
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "driver/spi_master.h"
+#include "fake_spi_master.h"
+/*==================[macros and definitions]=================================*/
+#define RESULTS		64		/*!< Result queue size (above any queue_size used) */
+
+struct fake_spi_device {
+	fake_spi_device_state_t state;
+	spi_device_interface_config_t config;
+	spi_transaction_t *results[RESULTS];	/*!< Ended queued transfers, oldest first */
+	uint32_t first;
+};
+/*==================[internal data definition]===============================*/
+static struct fake_spi_device devices[FAKE_SPI_DEVICES];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;	/*!< Device states */
+static pthread_mutex_t bus = PTHREAD_MUTEX_INITIALIZER;		/*!< Taken by spi_device_acquire_bus() */
+static uint32_t errors;
+/*==================[internal functions definition]==========================*/
+static void Error(void){
+	pthread_mutex_lock(&lock);
+	errors++;
+	pthread_mutex_unlock(&lock);
+}
+
+/** Make a transfer: callbacks around it, received bytes are the sent ones */
+static void Transfer(struct fake_spi_device *dev, spi_transaction_t *trans){
+	uint8_t *rx = (trans->flags & SPI_TRANS_USE_RXDATA) ? trans->rx_data : trans->rx_buffer;
+	const uint8_t *tx = (trans->flags & SPI_TRANS_USE_TXDATA) ? trans->tx_data : trans->tx_buffer;
+	size_t size = trans->rxlength / 8;
+
+	if(dev->config.pre_cb != NULL){
+		dev->config.pre_cb(trans);
+	}
+	if(rx != NULL){
+		if(tx != NULL){
+			memcpy(rx, tx, size);
+		} else{
+			memset(rx, 0xFF, size);
+		}
+	}
+	if(dev->config.post_cb != NULL){
+		dev->config.post_cb(trans);
+	}
+	pthread_mutex_lock(&lock);
+	dev->state.transfers++;
+	pthread_mutex_unlock(&lock);
+}
+/*==================[external functions definition]==========================*/
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, spi_dma_chan_t dma_chan){
+	(void)host;
+	(void)bus_config;
+	(void)dma_chan;
+	return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config, spi_device_handle_t *handle){
+	struct fake_spi_device *dev = NULL;
+
+	(void)host;
+	pthread_mutex_lock(&lock);
+	for(int i = 0; i < FAKE_SPI_DEVICES && dev == NULL; i++){
+		if(devices[i].state.adds == 0 || devices[i].state.cs == dev_config->spics_io_num){
+			dev = &devices[i];
+		}
+	}
+	if(dev == NULL || dev->state.added || dev_config->queue_size > RESULTS){
+		errors++;
+		pthread_mutex_unlock(&lock);
+		return ESP_ERR_INVALID_STATE;
+	}
+	dev->config = *dev_config;
+	dev->state.cs = dev_config->spics_io_num;
+	dev->state.added = true;
+	dev->state.adds++;
+	dev->state.clock_speed_hz = dev_config->clock_speed_hz;
+	dev->state.mode = dev_config->mode;
+	*handle = dev;
+	pthread_mutex_unlock(&lock);
+	return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle){
+	pthread_mutex_lock(&lock);
+	if(!handle->state.added || handle->state.pending > 0){
+		errors++;
+	}
+	handle->state.added = false;
+	handle->state.removes++;
+	pthread_mutex_unlock(&lock);
+	return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks){
+	struct fake_spi_device *dev = handle;
+	bool queued = false;
+
+	(void)ticks;
+	/* Give the CPU away, as the ESP-IDF driver does while it sets the transfer up */
+	sched_yield();
+	pthread_mutex_lock(&lock);
+	for(uint32_t i = 0; i < dev->state.pending; i++){
+		queued |= dev->results[(dev->first + i) % RESULTS] == trans;
+	}
+	if(!dev->state.added || queued || dev->state.pending >= (uint32_t)dev->config.queue_size){
+		errors++;
+		pthread_mutex_unlock(&lock);
+		return ESP_ERR_INVALID_STATE;
+	}
+	pthread_mutex_unlock(&lock);
+	Transfer(dev, trans);
+	pthread_mutex_lock(&lock);
+	dev->results[(dev->first + dev->state.pending) % RESULTS] = trans;
+	dev->state.pending++;
+	if(dev->state.pending > dev->state.max_pending){
+		dev->state.max_pending = dev->state.pending;
+	}
+	pthread_mutex_unlock(&lock);
+	return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks){
+	struct fake_spi_device *dev = handle;
+
+	pthread_mutex_lock(&lock);
+	if(dev->state.pending == 0){
+		/* Nothing will ever end: the real driver would wait here for good */
+		if(ticks == portMAX_DELAY){
+			errors++;
+		}
+		pthread_mutex_unlock(&lock);
+		return ESP_ERR_TIMEOUT;
+	}
+	*trans = dev->results[dev->first];
+	dev->first = (dev->first + 1) % RESULTS;
+	dev->state.pending--;
+	pthread_mutex_unlock(&lock);
+	return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans){
+	if(!handle->state.added){
+		Error();
+		return ESP_ERR_INVALID_STATE;
+	}
+	Transfer(handle, trans);
+	return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans){
+	return spi_device_transmit(handle, trans);
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait){
+	(void)handle;
+	(void)wait;
+	pthread_mutex_lock(&bus);
+	return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle){
+	(void)handle;
+	pthread_mutex_unlock(&bus);
+}
+
+const fake_spi_device_state_t* FakeSpiDevice(int cs){
+	for(int i = 0; i < FAKE_SPI_DEVICES; i++){
+		if(devices[i].state.adds > 0 && devices[i].state.cs == cs){
+			return &devices[i].state;
+		}
+	}
+	return NULL;
+}
+
+uint32_t FakeSpiErrors(void){
+	uint32_t count;
+
+	pthread_mutex_lock(&lock);
+	count = errors;
+	pthread_mutex_unlock(&lock);
+	return count;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,51 @@
+#ifndef FAKE_SPI_MASTER_H_
+#define FAKE_SPI_MASTER_H_
+/**
+ * @file fake_spi_master.h
+ * @brief ESP-IDF SPI master (driver/spi_master.h) on the host, for tests of spi_mcu.c.
+ *
+ * @note Devices are looked up by chip select pin. Transfers end as soon as they
+ * are started: pre_cb and post_cb are called from the calling task, and queued
+ * transfers wait in a result queue until spi_device_get_trans_result() takes them.
+ *
+ * @note Calls the ESP-IDF driver would reject or block on forever are counted as
+ * errors: a queue beyond queue_size, a transaction queued while still in the queue,
+ * a result waited for with nothing queued, or a device removed with transfers
+ * pending.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+/*==================[macros]=================================================*/
+#define FAKE_SPI_DEVICES	4		/*!< Maximum number of chip select pins seen */
+/*==================[typedef]================================================*/
+/**
+ * @brief State and counters of a chip select
+ */
+typedef struct {
+	int cs;					/*!< Chip select pin */
+	bool added;				/*!< On the bus */
+	uint32_t adds;			/*!< spi_bus_add_device() calls */
+	uint32_t removes;		/*!< spi_bus_remove_device() calls */
+	int clock_speed_hz;		/*!< Clock of the last add */
+	uint8_t mode;			/*!< SPI mode of the last add */
+	uint32_t transfers;		/*!< Transfers made (queued and blocking) */
+	uint32_t pending;		/*!< Queued transfers whose result wasn't taken */
+	uint32_t max_pending;	/*!< Maximum of pending */
+} fake_spi_device_state_t;
+
+/*==================[external functions declaration]=========================*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+/** State of the device on a chip select pin, NULL if never added. */
+const fake_spi_device_state_t* FakeSpiDevice(int cs);
+
+/** Number of errors (see the file notes) since the start. */
+uint32_t FakeSpiErrors(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAKE_SPI_MASTER_H_ */
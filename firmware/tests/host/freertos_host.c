@@ -0,0 +1,153 @@
+/**
+ * @file freertos_host.c
+ * @brief FreeRTOS tasks, notifications and mutexes on POSIX threads, for host tests.
+ *
+ * Tasks are detached threads that run until the test program ends. Priorities
+ * are ignored, so code under test must not depend on preemption order.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+/*==================[macros and definitions]=================================*/
+struct host_task {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint32_t notify;			/*!< Notification value (counting) */
+	TaskFunction_t code;
+	void *param;
+};
+/*==================[internal data definition]===============================*/
+static __thread struct host_task *current;
+/*==================[internal functions definition]==========================*/
+static struct host_task* TaskNew(void){
+	struct host_task *task = calloc(1, sizeof(struct host_task));
+
+	pthread_mutex_init(&task->lock, NULL);
+	pthread_cond_init(&task->cond, NULL);
+	return task;
+}
+
+static void* TaskRun(void *param){
+	current = param;
+	current->code(current->param);
+	return NULL;
+}
+/*==================[external functions definition]==========================*/
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack, void *param, UBaseType_t priority, TaskHandle_t *task){
+	struct host_task *t = TaskNew();
+
+	(void)name;
+	(void)stack;
+	(void)priority;
+	t->code = code;
+	t->param = param;
+	if(task != NULL){
+		*task = t;
+	}
+	if(pthread_create(&t->thread, NULL, TaskRun, t) != 0){
+		return pdFAIL;
+	}
+	pthread_detach(t->thread);
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task){
+	if(task == NULL || task == current){
+		pthread_exit(NULL);
+	}
+}
+
+void vTaskDelay(TickType_t ticks){
+	usleep(ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void){
+	/* Threads not created by xTaskCreate() (main) get a handle on first use */
+	if(current == NULL){
+		current = TaskNew();
+		current->thread = pthread_self();
+	}
+	return current;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks){
+	struct host_task *task = xTaskGetCurrentTaskHandle();
+	struct timespec deadline;
+	uint32_t value;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += ticks / 1000;
+	deadline.tv_nsec += (long)(ticks % 1000) * 1000000L;
+	if(deadline.tv_nsec >= 1000000000L){
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	pthread_mutex_lock(&task->lock);
+	while(task->notify == 0 && ticks != 0){
+		if(ticks == portMAX_DELAY){
+			pthread_cond_wait(&task->cond, &task->lock);
+		} else if(pthread_cond_timedwait(&task->cond, &task->lock, &deadline) == ETIMEDOUT){
+			break;
+		}
+	}
+	value = task->notify;
+	if(clear){
+		task->notify = 0;
+	} else if(value > 0){
+		task->notify--;
+	}
+	pthread_mutex_unlock(&task->lock);
+	return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task){
+	pthread_mutex_lock(&task->lock);
+	task->notify++;
+	pthread_cond_signal(&task->cond);
+	pthread_mutex_unlock(&task->lock);
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken){
+	xTaskNotifyGive(task);
+	if(woken != NULL){
+		*woken = pdTRUE;
+	}
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer){
+	pthread_mutex_init(&buffer->mutex, NULL);
+	return buffer;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *buffer){
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&buffer->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return buffer;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks){
+	if(ticks == 0){
+		return (pthread_mutex_trylock(&sem->mutex) == 0) ? pdTRUE : pdFALSE;
+	}
+	pthread_mutex_lock(&sem->mutex);
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem){
+	pthread_mutex_unlock(&sem->mutex);
+	return pdTRUE;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,61 @@
+/**
+ * @file img565_picture.c
+ * @brief Writes the synthetic RGB565 picture (raw, big endian) that
+ * firmware/tools/img565.py compresses for test_img565.
+ *
+ * Bands of rows, each meant for one kind of opcode: color blocks from a small
+ * palette (runs and color table hits), a smooth gradient (small differences),
+ * steep green steps (differences with green), noise (raw colors) and a single
+ * color long enough for a 16 bits run across several pixel buffers.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <stdint.h>
+/*==================[macros and definitions]=================================*/
+#define Rgb565(r, g, b)	((uint16_t)(((r) << 11) | ((g) << 5) | (b)))
+/*==================[internal data definition]===============================*/
+static const uint16_t palette[] = {
+	Rgb565(31, 0, 0), Rgb565(0, 63, 0), Rgb565(0, 0, 31), Rgb565(31, 63, 0), Rgb565(12, 40, 20), Rgb565(3, 9, 27),
+};
+static uint32_t seed = 565;
+/*==================[internal functions definition]==========================*/
+static uint16_t Pixel(uint32_t x, uint32_t y){
+	uint32_t g;
+
+	if (y < PICTURE_HEIGHT / 5){
+		return palette[(x / 20 + y / 10) % (sizeof(palette) / sizeof(palette[0]))];
+	}
+	if (y < 2 * PICTURE_HEIGHT / 5){
+		return Rgb565((x / 8) % 32, (x / 4 + y) % 64, y % 32);
+	}
+	if (y < 3 * PICTURE_HEIGHT / 5){
+		g = (x * 9 + y) % 64;
+		return Rgb565((g / 2 + x % 3) % 32, g, (g / 2 + 31 - x % 4) % 32);
+	}
+	if (y < 4 * PICTURE_HEIGHT / 5){
+		seed = seed * 1664525u + 1013904223u;
+		return (uint16_t)(seed >> 16);
+	}
+	return Rgb565(20, 10, 5);
+}
+/*==================[external functions definition]==========================*/
+int main(int argc, char *argv[]){
+	FILE *f;
+	uint16_t c;
+
+	if (argc != 2 || (f = fopen(argv[1], "wb")) == NULL){
+		fprintf(stderr, "usage: img565_picture picture.bin\n");
+		return 1;
+	}
+	for (uint32_t y = 0; y < PICTURE_HEIGHT; y++){
+		for (uint32_t x = 0; x < PICTURE_WIDTH; x++){
+			c = Pixel(x, y);
+			fputc(c >> 8, f);
+			fputc(c & 0xFF, f);
+		}
+	}
+	return fclose(f) == 0 ? 0 : 1;
+}
+
+/*==================[end of file]============================================*/
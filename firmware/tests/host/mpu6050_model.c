@@ -0,0 +1,234 @@
+/**
+ * @file mpu6050_model.c
+ * @brief MPU6050 register model for host tests (see mpu6050_model.h).
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include "mpu6050_model.h"
+#include "fake_mcu.h"
+#include "esp_timer.h"
+/*==================[macros and definitions]=================================*/
+#define REG_SMPLRT_DIV		0x19
+#define REG_CONFIG			0x1A
+#define REG_FIFO_EN			0x23
+#define REG_INT_ENABLE		0x38
+#define REG_INT_STATUS		0x3A
+#define REG_ACCEL_XOUT_H	0x3B
+#define REG_SIGNAL_PATH_RESET	0x68
+#define REG_USER_CTRL		0x6A
+#define REG_PWR_MGMT_1		0x6B
+#define REG_BANK_SEL		0x6D
+#define REG_MEM_START_ADDR	0x6E
+#define REG_MEM_R_W			0x6F
+#define REG_FIFO_COUNTH		0x72
+#define REG_FIFO_COUNTL		0x73
+#define REG_FIFO_R_W		0x74
+#define REG_WHO_AM_I		0x75
+
+#define INT_DATA_RDY		0x01
+#define INT_FIFO_OFLOW		0x10
+#define USER_FIFO_EN		0x40
+#define USER_RESETS			0x0F
+#define USER_FIFO_RESET		0x04
+#define PWR1_RESET			0x80
+#define PWR1_SLEEP			0x40
+/*==================[internal functions definition]==========================*/
+static void Reset(mpu6050_model_t *model){
+	memset(model->regs, 0, sizeof(model->regs));
+	model->regs[REG_PWR_MGMT_1] = PWR1_SLEEP;
+	model->regs[REG_WHO_AM_I] = 0x68;
+	model->fifo_head = 0;
+	model->fifo_count = 0;
+}
+
+static void FifoPush(mpu6050_model_t *model, const uint8_t *data, uint8_t length){
+	for(uint8_t i = 0; i < length; i++){
+		if(model->fifo_count == MPU6050_MODEL_FIFO_SIZE){
+			model->fifo_head = (model->fifo_head + 1) % MPU6050_MODEL_FIFO_SIZE;
+			model->fifo_count--;
+		}
+		model->fifo[(model->fifo_head + model->fifo_count) % MPU6050_MODEL_FIFO_SIZE] = data[i];
+		model->fifo_count++;
+	}
+}
+
+static void TakeSample(mpu6050_model_t *model){
+	int16_t values[7];
+	uint8_t *out = &model->regs[REG_ACCEL_XOUT_H];
+	uint8_t fifo_en = model->regs[REG_FIFO_EN];
+	uint16_t needed = 0;
+
+	if(model->generate != NULL){
+		model->generate(model, model->samples, values);
+	} else{
+		MPU6050ModelSample(model->samples, values);
+	}
+	model->samples++;
+	for(uint8_t i = 0; i < 7; i++){
+		out[2 * i] = (uint16_t)values[i] >> 8;
+		out[2 * i + 1] = (uint16_t)values[i] & 0xFF;
+	}
+	if(model->regs[REG_USER_CTRL] & USER_FIFO_EN){
+		/* Register order: accel, temp, gyro X, Y, Z */
+		needed = ((fifo_en & 0x08) ? 6 : 0) + ((fifo_en & 0x80) ? 2 : 0) +
+				((fifo_en & 0x40) ? 2 : 0) + ((fifo_en & 0x20) ? 2 : 0) + ((fifo_en & 0x10) ? 2 : 0);
+		if(model->fifo_count + needed > MPU6050_MODEL_FIFO_SIZE){
+			model->fifo_overflows++;
+			model->regs[REG_INT_STATUS] |= INT_FIFO_OFLOW;
+		}
+		if(fifo_en & 0x08){
+			FifoPush(model, &out[0], 6);
+		}
+		if(fifo_en & 0x80){
+			FifoPush(model, &out[6], 2);
+		}
+		for(uint8_t axis = 0; axis < 3; axis++){
+			if(fifo_en & (0x40 >> axis)){
+				FifoPush(model, &out[8 + 2 * axis], 2);
+			}
+		}
+	}
+	model->regs[REG_INT_STATUS] |= INT_DATA_RDY;
+	if((model->regs[REG_INT_ENABLE] & INT_DATA_RDY) && model->int_pin != MPU6050_MODEL_NO_PIN){
+		FakeGpioInterrupt(model->int_pin);
+	}
+}
+
+static void Tick(void *ctx, int64_t now){
+	mpu6050_model_t *model = ctx;
+	double period = MPU6050ModelPeriod(model);
+
+	if(period == 0){
+		return;
+	}
+	while(model->next_sample <= (double)now){
+		TakeSample(model);
+		model->next_sample += period;
+	}
+}
+
+static void WriteRegister(mpu6050_model_t *model, uint8_t reg, uint8_t value){
+	uint8_t *mem_addr = &model->regs[REG_MEM_START_ADDR];
+	bool asleep = (MPU6050ModelPeriod(model) == 0);
+
+	switch(reg){
+	case REG_MEM_R_W:
+		model->mem[model->regs[REG_BANK_SEL] & 0x07][(*mem_addr)++] = value;
+		return;
+	case REG_FIFO_R_W:
+		return;
+	case REG_PWR_MGMT_1:
+		if(value & PWR1_RESET){
+			Reset(model);
+			return;
+		}
+		model->regs[reg] = value;
+		break;
+	case REG_USER_CTRL:
+		if(value & USER_FIFO_RESET){
+			model->fifo_head = 0;
+			model->fifo_count = 0;
+		}
+		model->regs[reg] = value & ~USER_RESETS;
+		break;
+	case REG_SIGNAL_PATH_RESET:
+		break;
+	default:
+		/* Data, status, FIFO count and WHO_AM_I are read only */
+		if((reg >= REG_INT_STATUS && reg <= 0x60) || reg == REG_FIFO_COUNTH || reg == REG_FIFO_COUNTL || reg == REG_WHO_AM_I){
+			break;
+		}
+		model->regs[reg] = value;
+		break;
+	}
+	if(asleep && MPU6050ModelPeriod(model) != 0){
+		model->next_sample = (double)esp_timer_get_time() + MPU6050ModelPeriod(model);
+	}
+}
+
+static uint8_t ReadRegister(mpu6050_model_t *model, uint8_t reg){
+	uint8_t *mem_addr = &model->regs[REG_MEM_START_ADDR];
+	uint8_t value;
+
+	switch(reg){
+	case REG_MEM_R_W:
+		return model->mem[model->regs[REG_BANK_SEL] & 0x07][(*mem_addr)++];
+	case REG_FIFO_R_W:
+		if(model->fifo_count == 0){
+			return 0;
+		}
+		value = model->fifo[model->fifo_head];
+		model->fifo_head = (model->fifo_head + 1) % MPU6050_MODEL_FIFO_SIZE;
+		model->fifo_count--;
+		return value;
+	case REG_FIFO_COUNTH:
+		return model->fifo_count >> 8;
+	case REG_FIFO_COUNTL:
+		return model->fifo_count & 0xFF;
+	case REG_INT_STATUS:
+		value = model->regs[reg];
+		model->regs[reg] = 0;
+		return value;
+	default:
+		return model->regs[reg];
+	}
+}
+
+static void Write(void *ctx, const uint8_t *data, uint16_t length){
+	mpu6050_model_t *model = ctx;
+
+	model->pointer = data[0] & 0x7F;
+	for(uint16_t i = 1; i < length; i++){
+		WriteRegister(model, model->pointer, data[i]);
+		if(model->pointer != REG_MEM_R_W && model->pointer != REG_FIFO_R_W){
+			model->pointer = (model->pointer + 1) & 0x7F;
+		}
+	}
+}
+
+static void Read(void *ctx, uint8_t *data, uint16_t length){
+	mpu6050_model_t *model = ctx;
+
+	for(uint16_t i = 0; i < length; i++){
+		data[i] = ReadRegister(model, model->pointer);
+		if(model->pointer != REG_MEM_R_W && model->pointer != REG_FIFO_R_W){
+			model->pointer = (model->pointer + 1) & 0x7F;
+		}
+	}
+}
+/*==================[external functions definition]==========================*/
+void MPU6050ModelInit(mpu6050_model_t *model, uint8_t address){
+	memset(model, 0, sizeof(mpu6050_model_t));
+	Reset(model);
+	model->int_pin = MPU6050_MODEL_NO_PIN;
+	model->dev.address = address;
+	model->dev.ctx = model;
+	model->dev.write = Write;
+	model->dev.read = Read;
+	model->dev.tick = Tick;
+	VirtualI2CAttach(&model->dev);
+}
+
+void MPU6050ModelSample(uint32_t n, int16_t values[7]){
+	values[0] = (int16_t)n;
+	values[1] = 100;
+	values[2] = 16384;
+	values[3] = 0;
+	values[4] = 10;
+	values[5] = 20;
+	values[6] = (int16_t)-n;
+}
+
+double MPU6050ModelPeriod(const mpu6050_model_t *model){
+	uint8_t dlpf = model->regs[REG_CONFIG] & 0x07;
+	double rate = (dlpf == 0 || dlpf == 7) ? 8000.0 : 1000.0;
+
+	if(model->regs[REG_PWR_MGMT_1] & PWR1_SLEEP){
+		return 0;
+	}
+	rate /= model->regs[REG_SMPLRT_DIV] + 1;
+	return 1e6 / rate * (1.0 + model->clock_ppm * 1e-6);
+}
+
+/*==================[end of file]============================================*/
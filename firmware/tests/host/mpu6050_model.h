@@ -0,0 +1,63 @@
+#ifndef MPU6050_MODEL_H_
+#define MPU6050_MODEL_H_
+/**
+ * @file mpu6050_model.h
+ * @brief MPU6050 register model on the virtual I2C bus, for host tests.
+ *
+ * @note Modelled behaviour:
+ * - 128 registers with the power on values (PWR_MGMT_1 = 0x40, WHO_AM_I = 0x68),
+ *   register pointer auto-increment, read only data and status registers.
+ * - FIFO_R_W and MEM_R_W don't increment the pointer: bursts read the FIFO or
+ *   the DMP memory (8 banks of 256 bytes, BANK_SEL and MEM_START_ADDR).
+ * - DEVICE_RESET, FIFO_RESET and the other reset bits clear themselves.
+ * - While awake, samples are taken at 8 kHz (DLPF_CFG 0 or 7) or 1 kHz divided
+ *   by SMPLRT_DIV + 1, on a clock off by clock_ppm. Each sample updates the data
+ *   registers, is pushed to the 1024 byte FIFO in FIFO_EN order (the oldest bytes
+ *   are lost when it is full, setting FIFO_OFLOW_INT), sets DATA_RDY_INT and
+ *   raises int_pin when DATA_RDY_EN is set.
+ * - Sample n has accel X = n and gyro Z = -n (16 bits) unless generate is set,
+ *   so lost, repeated or garbage samples can be found.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "virtual_i2c.h"
+#include "gpio_mcu.h"
+/*==================[macros]=================================================*/
+#define MPU6050_MODEL_FIFO_SIZE		1024
+#define MPU6050_MODEL_NO_PIN		0xFF	/*!< int_pin value for no interrupt line */
+/*==================[typedef]================================================*/
+typedef struct mpu6050_model {
+	virtual_i2c_device_t dev;				/*!< Bus device (address set by MPU6050ModelInit()) */
+	uint8_t regs[128];						/*!< Register values */
+	uint8_t pointer;						/*!< Register pointer */
+	uint8_t fifo[MPU6050_MODEL_FIFO_SIZE];	/*!< FIFO ring */
+	uint16_t fifo_head;						/*!< Oldest FIFO byte */
+	uint16_t fifo_count;					/*!< Bytes in the FIFO */
+	uint8_t mem[8][256];					/*!< DMP memory */
+	double next_sample;						/*!< Virtual time of next sample (us) */
+	uint32_t samples;						/*!< Samples taken since init */
+	double clock_ppm;						/*!< Sample clock error (ppm) */
+	uint8_t int_pin;						/*!< GPIO connected to INT (MPU6050_MODEL_NO_PIN for none) */
+	uint32_t fifo_overflows;				/*!< Samples pushed to a full FIFO */
+	void (*generate)(struct mpu6050_model *model, uint32_t n, int16_t values[7]);	/*!< Sample values (accel, temp, gyro), NULL for default */
+} mpu6050_model_t;
+
+/*==================[external functions declaration]=========================*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+/** Set the power on state and connect the model to the virtual bus. */
+void MPU6050ModelInit(mpu6050_model_t *model, uint8_t address);
+
+/** Default value of sample n (accel X, Y, Z, temp, gyro X, Y, Z). */
+void MPU6050ModelSample(uint32_t n, int16_t values[7]);
+
+/** Sample period (us) for the current configuration, 0 while sleeping. */
+double MPU6050ModelPeriod(const mpu6050_model_t *model);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_MODEL_H_ */
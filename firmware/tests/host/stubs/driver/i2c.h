@@ -0,0 +1,59 @@
+/* Host build: legacy I2C master API, executed on the virtual bus (see virtual_i2c.c) */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef int i2c_port_t;
+typedef int i2c_mode_t;
+typedef struct i2c_cmd_link *i2c_cmd_handle_t;
+
+#define I2C_NUM_0				0
+#define I2C_MODE_MASTER			1
+#define I2C_MASTER_WRITE		0
+#define I2C_MASTER_READ			1
+#define GPIO_PULLUP_DISABLE		0
+#define GPIO_PULLUP_ENABLE		1
+
+typedef enum {
+	I2C_MASTER_ACK = 0,
+	I2C_MASTER_NACK = 1,
+	I2C_MASTER_LAST_NACK = 2,
+} i2c_ack_type_t;
+
+#define I2C_INTERNAL_STRUCT_SIZE				32
+#define I2C_LINK_RECOMMENDED_SIZE(TRANSACTIONS)	(2 * I2C_INTERNAL_STRUCT_SIZE + I2C_INTERNAL_STRUCT_SIZE * (5 * (TRANSACTIONS)))
+
+typedef struct {
+	i2c_mode_t mode;
+	int sda_io_num;
+	int scl_io_num;
+	bool sda_pullup_en;
+	bool scl_pullup_en;
+	struct {
+		uint32_t clk_speed;
+	} master;
+	uint32_t clk_flags;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *conf);
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t rx_buf, size_t tx_buf, int flags);
+i2c_cmd_handle_t i2c_cmd_link_create(void);
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size);
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd);
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en);
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t length, bool ack_en);
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd, uint8_t *data, i2c_ack_type_t ack);
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t length, i2c_ack_type_t ack);
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+/* Host build: placement attributes have no meaning */
+#pragma once
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define WORD_ALIGNED_ATTR	__attribute__((aligned(4)))
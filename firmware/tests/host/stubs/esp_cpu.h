@@ -0,0 +1,2 @@
+/* Host build: ESP-DSP includes it, nothing is used */
+#pragma once
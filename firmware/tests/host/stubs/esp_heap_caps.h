@@ -0,0 +1,11 @@
+/* Host build: capability allocations map to the C heap */
+#pragma once
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA		(1 << 3)
+#define MALLOC_CAP_8BIT		(1 << 2)
+#define MALLOC_CAP_INTERNAL	(1 << 11)
+
+#define heap_caps_malloc(size, caps)		malloc(size)
+#define heap_caps_calloc(n, size, caps)		calloc(n, size)
+#define heap_caps_free(p)					free(p)
@@ -0,0 +1,9 @@
+/* Host build: ESP-IDF log macros (silent) */
+#pragma once
+#include "esp_err.h"
+
+#define ESP_LOGE(tag, fmt, ...)	(void)(tag)
+#define ESP_LOGW(tag, fmt, ...)	(void)(tag)
+#define ESP_LOGI(tag, fmt, ...)	(void)(tag)
+#define ESP_LOGD(tag, fmt, ...)	(void)(tag)
+#define ESP_LOGV(tag, fmt, ...)	(void)(tag)
@@ -0,0 +1,11 @@
+/* Host build: esp_timer_get_time() returns the virtual bus time (see virtual_i2c.h) */
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int64_t esp_timer_get_time(void);
+#ifdef __cplusplus
+}
+#endif
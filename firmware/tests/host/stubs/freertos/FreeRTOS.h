@@ -0,0 +1,22 @@
+/* Host build: FreeRTOS types, tasks run as threads (see freertos_host.c) */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY			((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS		1
+#define pdMS_TO_TICKS(ms)		((TickType_t)(ms))
+#define pdTRUE					1
+#define pdFALSE					0
+#define pdPASS					1
+#define pdFAIL					0
+#define portYIELD_FROM_ISR(x)	(void)(x)
+#define configMAX_PRIORITIES	25
+#define tskIDLE_PRIORITY		0
+#define configASSERT(x)			(void)(x)
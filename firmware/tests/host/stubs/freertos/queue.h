@@ -0,0 +1,3 @@
+/* Host build: queues are not used by the drivers under test */
+#pragma once
+#include "FreeRTOS.h"
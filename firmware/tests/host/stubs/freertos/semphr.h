@@ -0,0 +1,22 @@
+/* Host build: FreeRTOS mutexes (plain and recursive) */
+#pragma once
+#include <pthread.h>
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct {
+	pthread_mutex_t mutex;
+} StaticSemaphore_t;
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *buffer);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+#define xSemaphoreTakeRecursive(sem, ticks)	xSemaphoreTake(sem, ticks)
+#define xSemaphoreGiveRecursive(sem)		xSemaphoreGive(sem)
+#ifdef __cplusplus
+}
+#endif
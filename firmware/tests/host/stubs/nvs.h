@@ -0,0 +1,29 @@
+/* Host build: NVS key-value storage, kept in memory (see fake_mcu.c) */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+	NVS_READONLY,
+	NVS_READWRITE,
+} nvs_open_mode_t;
+
+#define ESP_ERR_NVS_NOT_FOUND		0x1102
+#define ESP_ERR_NVS_READ_ONLY		0x1104
+#define ESP_ERR_NVS_NOT_ENOUGH_SPACE	0x1105
+#define ESP_ERR_NVS_INVALID_LENGTH	0x110c
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length);
+esp_err_t nvs_commit(nvs_handle_t handle);
+void nvs_close(nvs_handle_t handle);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,11 @@
+/* Host build: NVS partition, kept in memory (see fake_mcu.c) */
+#pragma once
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t nvs_flash_init(void);
+#ifdef __cplusplus
+}
+#endif
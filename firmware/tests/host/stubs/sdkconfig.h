@@ -0,0 +1,2 @@
+/* Host build: no Kconfig options */
+#pragma once
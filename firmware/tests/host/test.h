@@ -0,0 +1,35 @@
+#ifndef TEST_H_
+#define TEST_H_
+/**
+ * @file test.h
+ * @brief Minimal checks for host tests: a failed CHECK prints its location and
+ * makes TEST_END() return 1.
+ */
+#include <stdio.h>
+
+static int test_failures;
+
+#define CHECK(cond) do { \
+		if(!(cond)){ \
+			printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+			test_failures++; \
+		} \
+	} while(0)
+
+#define CHECK_EQ(a, b) do { \
+		long long va_ = (long long)(a), vb_ = (long long)(b); \
+		if(va_ != vb_){ \
+			printf("%s:%d: CHECK failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, va_, vb_); \
+			test_failures++; \
+		} \
+	} while(0)
+
+#define TEST_RUN(test) do { \
+		int before_ = test_failures; \
+		test(); \
+		printf("%s %s\n", (test_failures == before_) ? "PASS" : "FAIL", #test); \
+	} while(0)
+
+#define TEST_END()	((test_failures == 0) ? 0 : 1)
+
+#endif /* TEST_H_ */
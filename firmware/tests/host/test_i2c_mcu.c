@@ -0,0 +1,258 @@
+/**
+ * @file test_i2c_mcu.c
+ * @brief Host tests of the I2C driver: register access, shadow copy, queue and bus
+ * statistics.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <string.h>
+#include "i2c_mcu.h"
+#include "virtual_i2c.h"
+#include "fake_mcu.h"
+#include "mpu6050_model.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define DEV		0x68
+#define ABSENT	0x50	/*!< Address without a device */
+/*==================[internal data definition]===============================*/
+static mpu6050_model_t model;
+static i2c_shadow_t shadow;
+static const i2c_reg_range_t volatile_regs[] = {{0x3A, 0x60}, {0x6A, 0x75}};
+/*==================[internal functions definition]==========================*/
+static void Setup(void){
+	VirtualI2CReset();
+	MPU6050ModelInit(&model, DEV);
+	I2C_shadowInvalidate(DEV);
+}
+
+static void TestRegisterAccess(void){
+	uint8_t data[4] = {1, 2, 3, 4}, back[4];
+
+	Setup();
+	CHECK(I2C_writeBytes(DEV, 0x19, 4, data));
+	CHECK(memcmp(&model.regs[0x19], data, 4) == 0);
+	CHECK_EQ(I2C_readBytes(DEV, 0x19, 4, back, I2C_MASTER_TIMEOUT_MS), 4);
+	CHECK(memcmp(back, data, 4) == 0);
+	CHECK(I2C_writeBits(DEV, 0x1B, 4, 2, 3));
+	CHECK_EQ(model.regs[0x1B], 0x03 | 0x18);
+	CHECK_EQ(I2C_readByte(DEV, 0x75, back, I2C_MASTER_TIMEOUT_MS), 1);
+	CHECK_EQ(back[0], 0x68);
+}
+
+static void TestShadowCache(void){
+	uint8_t value;
+
+	Setup();
+	model.regs[0x1A] = 0x03;
+	CHECK(I2C_shadowInit(&shadow, DEV, volatile_regs, 2));
+	I2C_readByte(DEV, 0x1A, &value, I2C_MASTER_TIMEOUT_MS);
+	VirtualI2CResetCounters();
+	/* Known register: no bus transaction */
+	CHECK_EQ(I2C_readByte(DEV, 0x1A, &value, I2C_MASTER_TIMEOUT_MS), 1);
+	CHECK_EQ(value, 0x03);
+	CHECK_EQ(VirtualI2CTransactions(), 0);
+	/* Volatile register: always read */
+	I2C_readByte(DEV, 0x75, &value, I2C_MASTER_TIMEOUT_MS);
+	I2C_readByte(DEV, 0x75, &value, I2C_MASTER_TIMEOUT_MS);
+	CHECK_EQ(VirtualI2CTransactions(), 2);
+}
+
+static void TestShadowCommit(void){
+	Setup();
+	VirtualI2CResetCounters();
+	I2C_shadowBegin(DEV);
+	CHECK(I2C_writeByte(DEV, 0x19, 9));
+	CHECK(I2C_writeByte(DEV, 0x1A, 2));
+	CHECK(I2C_writeByte(DEV, 0x1B, 8));
+	CHECK_EQ(VirtualI2CTransactions(), 0);
+	CHECK(I2C_shadowCommit(DEV));
+	/* Consecutive registers in one burst */
+	CHECK_EQ(VirtualI2CTransactions(), 1);
+	CHECK_EQ(model.regs[0x19], 9);
+	CHECK_EQ(model.regs[0x1A], 2);
+	CHECK_EQ(model.regs[0x1B], 8);
+}
+
+static void TestFailedCommit(void){
+	Setup();
+	CHECK(I2C_shadowInit(&shadow, DEV, volatile_regs, 2));
+	I2C_shadowBegin(DEV);
+	CHECK(I2C_writeByte(DEV, 0x1A, 0x02));
+	VirtualI2CFail(DEV, 0, 1, ESP_FAIL);
+	CHECK(!I2C_shadowCommit(DEV));
+	CHECK_EQ(model.regs[0x1A], 0x00);
+	/* The value not written is not taken as known: written again */
+	I2C_shadowBegin(DEV);
+	CHECK(I2C_writeByte(DEV, 0x1A, 0x02));
+	CHECK(I2C_shadowCommit(DEV));
+	CHECK_EQ(model.regs[0x1A], 0x02);
+}
+
+static void TestFailedWrite(void){
+	uint8_t value;
+
+	Setup();
+	CHECK(I2C_shadowInit(&shadow, DEV, volatile_regs, 2));
+	CHECK(I2C_writeByte(DEV, 0x1A, 0x01));
+	VirtualI2CFail(DEV, 0, 1, ESP_FAIL);
+	CHECK(!I2C_writeByte(DEV, 0x1A, 0x02));
+	CHECK_EQ(model.regs[0x1A], 0x01);
+	/* The value not written is not taken as known */
+	VirtualI2CResetCounters();
+	CHECK_EQ(I2C_readByte(DEV, 0x1A, &value, I2C_MASTER_TIMEOUT_MS), 1);
+	CHECK_EQ(value, 0x01);
+	CHECK_EQ(VirtualI2CTransactions(), 1);
+	/* Nor a bit changed over it */
+	VirtualI2CFail(DEV, 0, 1, ESP_FAIL);
+	CHECK(!I2C_writeBit(DEV, 0x1A, 7, 1));
+	CHECK(I2C_writeBit(DEV, 0x1A, 1, 1));
+	CHECK_EQ(model.regs[0x1A], 0x03);
+}
+
+static void TestQueue(void){
+	uint8_t data[2][2];
+	i2c_trans_t trans[2] = {
+		{.type = I2C_TRANS_READ, .devAddr = DEV, .regAddr = 0x3B, .length = 2, .data = data[0], .batch = true},
+		{.type = I2C_TRANS_READ, .devAddr = DEV, .regAddr = 0x3D, .length = 2, .data = data[1], .batch = true},
+	};
+
+	Setup();
+	model.regs[0x3B] = 0x12;
+	model.regs[0x3E] = 0x34;
+	/* Nothing queued without the I2C task */
+	CHECK(!I2C_queueTransfers(trans, 2));
+	CHECK(I2C_queueInit(5));
+	VirtualI2CResetCounters();
+	trans[1].task = xTaskGetCurrentTaskHandle();
+	CHECK(I2C_queueTransfers(trans, 2));
+	while(!trans[1].done){
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+	CHECK(trans[0].success && trans[1].success);
+	CHECK_EQ(data[0][0], 0x12);
+	CHECK_EQ(data[1][1], 0x34);
+	/* Adjacent reads joined */
+	CHECK_EQ(VirtualI2CTransactions(), 1);
+}
+
+static void TestQueueWrite(void){
+	uint8_t value = 0x05;
+	i2c_trans_t trans = {.type = I2C_TRANS_WRITE, .devAddr = DEV, .regAddr = 0x1B, .length = 1, .data = &value};
+
+	Setup();
+	CHECK(I2C_shadowInit(&shadow, DEV, volatile_regs, 2));
+	CHECK(I2C_queueInit(5));
+	I2C_shadowBegin(DEV);
+	CHECK(I2C_writeByte(DEV, 0x1A, 0x02));
+	CHECK(I2C_writeByte(DEV, 0x1C, 0x08));
+	/* A queued write is made even while another task delays its writes */
+	trans.task = xTaskGetCurrentTaskHandle();
+	CHECK(I2C_queueTransfer(&trans));
+	while(!trans.done){
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+	CHECK(trans.success);
+	CHECK_EQ(model.regs[0x1B], 0x05);
+	CHECK_EQ(model.regs[0x1A], 0x00);
+	/* Pending writes are left for the commit */
+	CHECK(I2C_shadowCommit(DEV));
+	CHECK_EQ(model.regs[0x1A], 0x02);
+	CHECK_EQ(model.regs[0x1C], 0x08);
+	CHECK_EQ(model.regs[0x1B], 0x05);
+}
+
+static void TestStats(void){
+	virtual_i2c_transaction_t logged;
+	i2c_stats_t stats;
+	uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+	uint32_t latency, min = UINT32_MAX, max = 0;
+	uint64_t total = 0;
+	char line[128];
+
+	Setup();
+	VirtualI2CSetOverhead(25);
+	I2C_resetStats();
+	CHECK(!I2C_getStats(DEV, &stats));
+	VirtualI2CResetCounters();
+
+	/* Good transactions, then one of each failure */
+	CHECK(I2C_writeBytes(DEV, 0x13, 6, data));
+	CHECK(I2C_writeByte(DEV, 0x6B, 0x01));
+	CHECK_EQ(I2C_readBytes(DEV, 0x3B, 6, data, I2C_MASTER_TIMEOUT_MS), 6);
+	CHECK_EQ(I2C_readBytes(DEV, 0x43, 2, data, I2C_MASTER_TIMEOUT_MS), 2);
+	CHECK_EQ(VirtualI2CBytes(), (1 + 6) + (1 + 1) + (1 + 6) + (1 + 2));
+	VirtualI2CFail(DEV, 0, 1, ESP_FAIL);
+	CHECK(I2C_readBytes(DEV, 0x3B, 6, data, I2C_MASTER_TIMEOUT_MS) <= 0);
+	VirtualI2CFail(DEV, 0, 1, ESP_ERR_TIMEOUT);
+	CHECK(!I2C_writeByte(DEV, 0x6B, 0x00));
+	VirtualI2CFail(DEV, 0, 2, ESP_ERR_INVALID_STATE);
+	CHECK(I2C_readBytes(DEV, 0x43, 2, data, I2C_MASTER_TIMEOUT_MS) <= 0);
+	CHECK(!I2C_writeByte(DEV, 0x6B, 0x00));
+
+	CHECK(I2C_getStats(DEV, &stats));
+	CHECK_EQ(stats.devAddr, DEV);
+	CHECK_EQ(stats.transactions, 8);
+	CHECK_EQ(stats.transactions, VirtualI2CTransactions());
+	/* Failed transactions carry no bytes: the bus counts the same */
+	CHECK_EQ(stats.bytes, VirtualI2CBytes());
+	CHECK_EQ(stats.nacks, 1);
+	CHECK_EQ(stats.timeouts, 1);
+	CHECK_EQ(stats.errors, 2);
+
+	/* Latency: start to end of each transaction on the virtual bus clock */
+	for(uint32_t i = 0; i < stats.transactions; i++){
+		CHECK(VirtualI2CTransaction(i, &logged));
+		latency = (uint32_t)(logged.end - logged.start);
+		min = (latency < min) ? latency : min;
+		max = (latency > max) ? latency : max;
+		total += latency;
+	}
+	CHECK_EQ(stats.latency_min, min);
+	CHECK_EQ(stats.latency_max, max);
+	CHECK_EQ(stats.latency_total, total);
+	/* The timeout is the longest: the whole driver timeout (1 s) */
+	CHECK_EQ(stats.latency_max, 1000000);
+	/* Register write, 400 kHz: START, address, register, data, STOP = 29 bits, 73 us, plus the overhead */
+	CHECK_EQ(stats.latency_min, 73 + 25);
+
+	/* No device: NACKed, counted on its own */
+	CHECK(I2C_readByte(ABSENT, 0x00, data, I2C_MASTER_TIMEOUT_MS) <= 0);
+	CHECK(I2C_getStats(ABSENT, &stats));
+	CHECK_EQ(stats.transactions, 1);
+	CHECK_EQ(stats.nacks, 1);
+	CHECK_EQ(stats.bytes, 0);
+
+	/* Sent as a table: header, then a line for each device */
+	FakeUartClear();
+	I2C_sendStats(UART_PC);
+	CHECK(strncmp(FakeUartOutput(), "addr transactions bytes nacks timeouts errors min_us avg_us max_us\r\n", 68) == 0);
+	CHECK(I2C_getStats(DEV, &stats));
+	snprintf(line, sizeof(line), "0x68 8 %lu 1 1 2 %lu %lu 1000000\r\n", (unsigned long)stats.bytes,
+			(unsigned long)min, (unsigned long)(total / 8));
+	CHECK(strstr(FakeUartOutput(), line) != NULL);
+	CHECK(strstr(FakeUartOutput(), "0x50 1 0 1 0 0 ") != NULL);
+
+	I2C_resetStats();
+	CHECK(!I2C_getStats(DEV, &stats));
+	CHECK(!I2C_getStats(ABSENT, &stats));
+	FakeUartClear();
+	I2C_sendStats(UART_PC);
+	CHECK_EQ(strlen(FakeUartOutput()), 68);
+	VirtualI2CSetOverhead(VIRTUAL_I2C_OVERHEAD_US);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	I2C_initialize(400000);
+	TEST_RUN(TestRegisterAccess);
+	TEST_RUN(TestShadowCache);
+	TEST_RUN(TestShadowCommit);
+	TEST_RUN(TestFailedCommit);
+	TEST_RUN(TestFailedWrite);
+	TEST_RUN(TestQueue);
+	TEST_RUN(TestQueueWrite);
+	TEST_RUN(TestStats);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,306 @@
+/**
+ * @file test_ili9341.c
+ * @brief Host tests of ILI9341 drawing functions on the SPI panel fake. Lines and
+ * circles are compared with the pixel by pixel drawing they replaced.
+ */
+
+/*==================[inclusions]=============================================*/
+#include "ili9341.h"
+#include "fake_panel.h"
+#include "test.h"
+/*==================[internal data definition]===============================*/
+static uint16_t expected[FAKE_PANEL_PAGES][FAKE_PANEL_COLUMNS];
+static uint32_t done;
+static uint8_t picture[120 * 100 * 2];	/*!< More than one pixel buffer */
+/*==================[internal functions definition]==========================*/
+/** Per pixel reference: a pixel of the expected image, if it is on the LCD */
+static void RefPixel(int x, int y){
+	if (x >= 0 && y >= 0 && x < ILI9341_WIDTH && y < ILI9341_HEIGHT){
+		expected[y][x] = ILI9341_RED;
+	}
+}
+
+static void RefRow(int x0, int x1, int y){
+	for (int x = x0; x <= x1; x++){
+		RefPixel(x, y);
+	}
+}
+
+/** Bresenham, one pixel at a time, as ILI9341DrawLine() did before runs */
+static void RefLine(int x0, int y0, int x1, int y1){
+	int x_dist = (x1 > x0) ? x1 - x0 : x0 - x1, y_dist = (y1 > y0) ? y1 - y0 : y0 - y1;
+	int x_grow = (x0 > x1) ? -1 : 1, y_grow = (y0 > y1) ? -1 : 1;
+	int error = x_dist - y_dist, error_2;
+
+	while (1){
+		RefPixel(x0, y0);
+		if (x0 == x1 && y0 == y1){
+			break;
+		}
+		error_2 = 2 * error;
+		if (error_2 > -y_dist){
+			error -= y_dist;
+			x0 += x_grow;
+		}
+		if (error_2 < x_dist){
+			error += x_dist;
+			y0 += y_grow;
+		}
+	}
+}
+
+/** Midpoint circle, eight pixels at a time (filled: rows between them), as before runs */
+static void RefCircle(int x0, int y0, int r, bool filled){
+	int f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+
+	RefPixel(x0, y0 + r);
+	RefPixel(x0, y0 - r);
+	RefPixel(x0 + r, y0);
+	RefPixel(x0 - r, y0);
+	if (filled){
+		RefRow(x0 - r, x0 + r, y0);
+	}
+	while (x < y){
+		if (f >= 0){
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+		if (filled){
+			RefRow(x0 - x, x0 + x, y0 + y);
+			RefRow(x0 - x, x0 + x, y0 - y);
+			RefRow(x0 - y, x0 + y, y0 + x);
+			RefRow(x0 - y, x0 + y, y0 - x);
+		}
+		else{
+			RefPixel(x0 + x, y0 + y);
+			RefPixel(x0 - x, y0 + y);
+			RefPixel(x0 + x, y0 - y);
+			RefPixel(x0 - x, y0 - y);
+			RefPixel(x0 + y, y0 + x);
+			RefPixel(x0 - y, y0 + x);
+			RefPixel(x0 + y, y0 - x);
+			RefPixel(x0 - y, y0 - x);
+		}
+	}
+}
+
+/** Start a drawing on a black panel and a black expected image */
+static void Clear(void){
+	for (int y = 0; y < FAKE_PANEL_PAGES; y++){
+		for (int x = 0; x < FAKE_PANEL_COLUMNS; x++){
+			expected[y][x] = ILI9341_BLACK;
+		}
+	}
+	FakePanelReset(ILI9341_BLACK);
+}
+
+/** Pixels of the panel that differ from the expected image */
+static uint32_t Differences(void){
+	uint32_t diff = 0;
+
+	ILI9341WaitTransfer();
+	for (int y = 0; y < FAKE_PANEL_PAGES; y++){
+		for (int x = 0; x < FAKE_PANEL_COLUMNS; x++){
+			diff += (FakePanel[y][x] != expected[y][x]);
+		}
+	}
+	return diff;
+}
+
+static void Done(void *param){
+	(void)param;
+	done++;
+}
+
+/** Transfer done callbacks of the drawings since the last call */
+static uint32_t Callbacks(void){
+	uint32_t count;
+
+	ILI9341WaitTransfer();
+	count = done;
+	done = 0;
+	return count;
+}
+
+static void TestFilledPolygonWide(void){
+	/* Right side edges are 60000 pixels wide over 10 rows: 60000 doesn't fit 16.16 in 32 bits */
+	const ili9341_point_t points[] = {{-30000, 100}, {30000, 110}, {-30000, 120}};
+	uint16_t x, y;
+	uint32_t filled;
+
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341DrawFilledPolygon(points, 3, ILI9341_RED);
+	ILI9341WaitTransfer();
+	/* Right edge at x = 6000 * (y - 105) going down, then back */
+	for (y = 99; y <= 121; y++){
+		filled = 0;
+		for (x = 0; x < ILI9341_WIDTH; x++){
+			filled += (FakePanel[y][x] == ILI9341_RED);
+		}
+		if (y < 105 || y > 115){
+			CHECK_EQ(filled, 0);
+		}
+		else if (y == 105 || y == 115){
+			CHECK_EQ(filled, 1);
+		}
+		else{
+			CHECK_EQ(filled, ILI9341_WIDTH);
+		}
+	}
+}
+
+static uint32_t Filled(uint16_t y){
+	uint32_t filled = 0;
+
+	for (uint16_t x = 0; x < ILI9341_WIDTH; x++){
+		filled += (FakePanel[y][x] == ILI9341_RED);
+	}
+	return filled;
+}
+
+static void TestFilledPolygonClipped(void){
+	/* Right side turns above the LCD: the walk starts at row 0 on its second edge */
+	const ili9341_point_t quad[] = {{0, -1000}, {0, 400}, {200, 400}, {200, -500}};
+	/* Bottom vertex on the last int16_t row, top one far above */
+	const ili9341_point_t tall[] = {{10, INT16_MIN}, {10, INT16_MAX}, {50, INT16_MAX}};
+	const ili9341_point_t below[] = {{10, 400}, {10, INT16_MAX}, {50, INT16_MAX}};
+	uint16_t y;
+	uint32_t ok = 0;
+
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341DrawFilledPolygon(quad, 4, ILI9341_RED);
+	ILI9341WaitTransfer();
+	for (y = 0; y < ILI9341_HEIGHT; y++){
+		ok += (Filled(y) == 201 && FakePanel[y][0] == ILI9341_RED && FakePanel[y][200] == ILI9341_RED);
+	}
+	CHECK_EQ(ok, ILI9341_HEIGHT);
+
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341DrawFilledPolygon(tall, 3, ILI9341_RED);
+	ILI9341WaitTransfer();
+	/* Right edge from x = 10 to 50 over 65535 rows: x = 30 on the LCD rows */
+	CHECK_EQ(Filled(0), 21);
+	CHECK_EQ(Filled(ILI9341_HEIGHT - 1), 21);
+	CHECK_EQ(FakePanelStats.pixels, 2 * 21 * ILI9341_HEIGHT);
+
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341DrawFilledPolygon(below, 3, ILI9341_RED);
+	ILI9341WaitTransfer();
+	CHECK_EQ(FakePanelStats.pixels, 0);
+}
+
+static void TestLines(void){
+	/* Octant edges (45 degrees, horizontal, vertical), one step off them, a single
+	 * point, and lines that leave the LCD */
+	const int16_t lines[][4] = {
+		{10, 10, 110, 110}, {110, 110, 10, 10}, {200, 20, 100, 120}, {100, 120, 200, 20},
+		{10, 50, 200, 50}, {200, 60, 10, 60}, {30, 10, 30, 300}, {40, 300, 40, 10},
+		{10, 10, 111, 110}, {10, 10, 110, 111}, {110, 111, 10, 10}, {111, 10, 10, 110},
+		{20, 20, 220, 120}, {20, 20, 120, 220}, {220, 120, 20, 20}, {120, 220, 20, 20},
+		{0, 0, 239, 319}, {239, 0, 0, 319}, {17, 33, 18, 301}, {5, 5, 5, 5},
+		{-50, -20, 300, 100}, {-30, 400, 270, -60}, {100, -100, 130, 500}, {-10, 5, 260, 5},
+	};
+	uint32_t seed = 4;
+	int16_t v[4];
+
+	for (uint32_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++){
+		Clear();
+		RefLine(lines[i][0], lines[i][1], lines[i][2], lines[i][3]);
+		ILI9341DrawLine(lines[i][0], lines[i][1], lines[i][2], lines[i][3], ILI9341_RED);
+		CHECK_EQ(Differences(), 0);
+	}
+	for (int i = 0; i < 200; i++){
+		for (int k = 0; k < 4; k++){
+			seed = seed * 1664525u + 1013904223u;
+			v[k] = (int16_t)((seed >> 8) % 400) - 80;
+		}
+		Clear();
+		RefLine(v[0], v[1], v[2], v[3]);
+		ILI9341DrawLine(v[0], v[1], v[2], v[3], ILI9341_RED);
+		CHECK_EQ(Differences(), 0);
+	}
+}
+
+static void TestCircles(void){
+	/* Center, radius: a point, the smallest circles, large ones past the LCD sides */
+	const int16_t circles[][3] = {
+		{120, 160, 0}, {120, 160, 1}, {120, 160, 2}, {120, 160, 3}, {50, 60, 7},
+		{120, 160, 100}, {120, 160, 119}, {120, 160, 150}, {120, 160, 300},
+		{0, 0, 40}, {239, 319, 60}, {-20, 160, 50}, {120, 340, 45}, {300, 100, 70},
+	};
+
+	for (uint32_t i = 0; i < sizeof(circles) / sizeof(circles[0]); i++){
+		Clear();
+		RefCircle(circles[i][0], circles[i][1], circles[i][2], false);
+		ILI9341DrawCircle(circles[i][0], circles[i][1], circles[i][2], ILI9341_RED);
+		CHECK_EQ(Differences(), 0);
+		Clear();
+		RefCircle(circles[i][0], circles[i][1], circles[i][2], true);
+		ILI9341DrawFilledCircle(circles[i][0], circles[i][1], circles[i][2], ILI9341_RED);
+		CHECK_EQ(Differences(), 0);
+	}
+	for (int16_t r = 4; r < 120; r += 5){
+		Clear();
+		RefCircle(120, 160, r, false);
+		ILI9341DrawCircle(120, 160, r, ILI9341_RED);
+		CHECK_EQ(Differences(), 0);
+	}
+}
+
+static void TestTransferDone(void){
+	const ili9341_point_t pentagon[] = {{100, 10}, {180, 70}, {150, 160}, {50, 160}, {20, 70}};
+	const ili9341_point_t outside[] = {{10, 400}, {10, 500}, {50, 500}};
+
+	/* Once for each drawing, whatever the number of transfers it takes */
+	FakePanelReset(ILI9341_BLACK);
+	ILI9341SetTransferDoneCallback(Done, NULL);
+	ILI9341DrawPixel(5, 5, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawLine(0, 0, 200, 57, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawRectangle(10, 10, 100, 60, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawFilledRectangle(10, 10, 20, 20, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawFilledRectangle(0, 0, 200, 200, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341Fill(ILI9341_BLACK);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawCircle(120, 160, 50, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawFilledCircle(120, 160, 50, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawTriangle(10, 10, 200, 40, 60, 300, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawFilledPolygon(pentagon, 5, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawString(0, 0, "Two\nlines", &font_11, ILI9341_WHITE, ILI9341_BLACK);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawInt(0, 100, 1234, 4, &font_19, ILI9341_WHITE, ILI9341_BLACK);
+	CHECK_EQ(Callbacks(), 1);
+	ILI9341DrawPicture(0, 0, 120, 100, picture);
+	CHECK_EQ(Callbacks(), 1);
+	CHECK(FakePanelStats.transfers > 0);
+
+	/* Nothing sent, nothing to tell */
+	ILI9341DrawFilledPolygon(outside, 3, ILI9341_RED);
+	ILI9341DrawFilledCircle(-100, -100, 20, ILI9341_RED);
+	CHECK_EQ(Callbacks(), 0);
+	ILI9341SetTransferDoneCallback(NULL, NULL);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	ILI9341Init(SPI_1, GPIO_2, GPIO_3);
+	TEST_RUN(TestFilledPolygonWide);
+	TEST_RUN(TestFilledPolygonClipped);
+	TEST_RUN(TestLines);
+	TEST_RUN(TestCircles);
+	TEST_RUN(TestTransferDone);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
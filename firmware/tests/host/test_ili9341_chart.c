@@ -0,0 +1,176 @@
+/**
+ * @file test_ili9341_chart.c
+ * @brief Host tests of the ILI9341 strip chart on the SPI panel fake: the trace
+ * shown through the scroll registers, past the wrap of the chart lines, and the
+ * grouping of lines in windows.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <math.h>
+#include "ili9341_chart.h"
+#include "fake_panel.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define MAX_SAMPLES		2000
+/*==================[internal data definition]===============================*/
+static ili9341_chart_t chart;
+static uint8_t trace[MAX_SAMPLES];		/*!< Trace pixel of every sample added */
+static uint32_t added;
+/*==================[internal functions definition]==========================*/
+/** Trace pixel of a sample, as the chart rounds and clamps it */
+static uint8_t TracePixel(const ili9341_chart_config_t *config, float sample){
+	float value = (config->max - sample) * ((config->amp_size - 1) / (config->max - config->min));
+
+	if (value <= 0){
+		return 0;
+	}
+	if (value >= config->amp_size - 1){
+		return config->amp_size - 1;
+	}
+	return (uint8_t)(value + 0.5f);
+}
+
+static void Add(const float *samples, uint32_t count){
+	for (uint32_t i = 0; i < count; i++){
+		trace[added++] = TracePixel(&chart.config, samples[i]);
+	}
+	ILI9341ChartAddSamples(&chart, samples, count);
+	ILI9341WaitTransfer();
+}
+
+/** Panel pixel of a chart line (memory order), across it */
+static uint16_t LinePixel(uint16_t line, uint16_t a, bool exchanged){
+	return exchanged ? FakePanel[a][line] : FakePanel[line][a];
+}
+
+/**
+ * Lines of the scrolling area in the order they are shown (from the scroll start
+ * register) that differ from the trace: the oldest sample first, the newest last,
+ * each line joining a sample with the one before it.
+ */
+static uint32_t ShownDifferences(bool exchanged){
+	const ili9341_chart_config_t *config = &chart.config;
+	uint16_t line, lo, hi, expected;
+	uint32_t wrong = 0;
+	bool bad;
+	int32_t j;
+
+	for (uint16_t k = 0; k < config->length; k++){
+		line = FakePanelScroll.top + (FakePanelScroll.start - FakePanelScroll.top + k) % FakePanelScroll.length;
+		j = (int32_t)added - config->length + k;
+		lo = (j <= 0) ? ((j == 0) ? trace[0] : UINT8_MAX) : ((trace[j] < trace[j - 1]) ? trace[j] : trace[j - 1]);
+		hi = (j <= 0) ? ((j == 0) ? trace[0] : 0) : ((trace[j] > trace[j - 1]) ? trace[j] : trace[j - 1]);
+		bad = false;
+		/* Across the whole LCD: lines scroll entirely */
+		for (uint16_t a = 0; a < ILI9341_WIDTH; a++){
+			expected = (a >= config->amp_start && a - config->amp_start >= lo && a - config->amp_start <= hi) ?
+					config->color : config->background;
+			bad |= (LinePixel(line, a, exchanged) != expected);
+		}
+		wrong += bad;
+	}
+	return wrong;
+}
+
+static void Start(ili9341_chart_config_t *config){
+	added = 0;
+	FakePanelReset(ILI9341_BLUE);
+	CHECK(ILI9341ChartInit(&chart, config));
+	ILI9341WaitTransfer();
+	CHECK_EQ(FakePanelScroll.top, config->start);
+	CHECK_EQ(FakePanelScroll.length, config->length);
+	CHECK_EQ(FakePanelScroll.bottom, ILI9341_HEIGHT - config->start - config->length);
+	CHECK_EQ(FakePanelScroll.start, config->start);
+}
+
+static void TestScrollWrap(void){
+	ili9341_chart_config_t config = {.start = 40, .length = 200, .amp_start = 20, .amp_size = 200,
+			.min = -1.0f, .max = 1.0f, .color = ILI9341_GREEN, .background = ILI9341_BLACK};
+	const uint32_t blocks[] = {7, 50, 133, 1, 90, 200, 64, 3, 250};
+	float samples[250];
+	uint32_t n = 0;
+
+	Start(&config);
+	CHECK_EQ(ShownDifferences(false), 0);
+	/* A sine a bit larger than the chart (clamped peaks), in blocks that end anywhere */
+	for (uint32_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++){
+		for (uint32_t i = 0; i < blocks[b]; i++, n++){
+			samples[i] = 1.2f * sinf(n * 0.05f) + 0.1f * sinf(n * 1.3f);
+		}
+		Add(samples, blocks[b]);
+		/* Newest sample at the end of the scrolling area */
+		CHECK_EQ(FakePanelScroll.start, config.start + added % config.length);
+		CHECK_EQ(ShownDifferences(false), 0);
+	}
+	CHECK(added > 3 * config.length);
+	/* Lines above and below the chart are untouched */
+	CHECK_EQ(FakePanel[config.start - 1][0], ILI9341_BLUE);
+	CHECK_EQ(FakePanel[config.start + config.length][ILI9341_WIDTH - 1], ILI9341_BLUE);
+}
+
+static void TestWindows(void){
+	ili9341_chart_config_t config = {.start = 0, .length = 100, .amp_start = 0, .amp_size = 200,
+			.min = 0.0f, .max = 1.0f, .color = ILI9341_WHITE, .background = ILI9341_BLACK};
+	float samples[100];
+
+	Start(&config);
+	/* A flat trace: consecutive lines in one window, two across the wrap */
+	for (int i = 0; i < 60; i++){
+		samples[i] = 0.5f;
+	}
+	FakePanelStats.windows = 0;
+	Add(samples, 60);
+	CHECK_EQ(FakePanelStats.windows, 1);
+	FakePanelStats.windows = 0;
+	Add(samples, 60);
+	CHECK_EQ(FakePanelStats.windows, 2);
+	CHECK_EQ(ShownDifferences(false), 0);
+
+	/* Full swings: 200 pixels per line, 10 lines fit a pixel buffer */
+	for (int i = 0; i < 50; i++){
+		samples[i] = i % 2;
+	}
+	Add(samples, 20);
+	FakePanelStats.windows = 0;
+	Add(samples, 50);
+	CHECK_EQ(FakePanelStats.windows, 5);
+	CHECK_EQ(ShownDifferences(false), 0);
+}
+
+static void TestLandscape(void){
+	/* Trace over the whole 240 pixels side: pixel 239 still fits the uint8_t per line */
+	ili9341_chart_config_t config = {.start = 10, .length = 300, .amp_start = 0, .amp_size = ILI9341_WIDTH,
+			.min = -1.0f, .max = 1.0f, .color = ILI9341_RED, .background = ILI9341_WHITE};
+	float samples[400];
+
+	ILI9341Rotate(ILI9341_Landscape_1);
+	Start(&config);
+	for (int i = 0; i < 400; i++){
+		samples[i] = (i % 37 < 3) ? -2.0f : 1.1f * cosf(i * 0.02f);
+	}
+	Add(samples, 170);
+	CHECK_EQ(ShownDifferences(true), 0);
+	Add(&samples[170], 230);
+	CHECK_EQ(FakePanelScroll.start, config.start + 100);
+	CHECK_EQ(ShownDifferences(true), 0);
+
+	CHECK(ILI9341ChartDeInit(&chart));
+	CHECK_EQ(FakePanelScroll.top, 0);
+	CHECK_EQ(FakePanelScroll.length, ILI9341_HEIGHT);
+	CHECK_EQ(FakePanelScroll.start, 0);
+	ILI9341Rotate(ILI9341_Portrait_1);
+
+	/* Chart out of the LCD */
+	config.length = ILI9341_HEIGHT;
+	CHECK(!ILI9341ChartInit(&chart, &config));
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	ILI9341Init(SPI_1, GPIO_2, GPIO_3);
+	TEST_RUN(TestScrollWrap);
+	TEST_RUN(TestWindows);
+	TEST_RUN(TestLandscape);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,120 @@
+/**
+ * @file test_ili9341_dl.c
+ * @brief Host tests of the ILI9341 display list: panel contents against direct
+ * drawing, joined strings, buffer alignment and string length limits.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include <stdint.h>
+#include "ili9341.h"
+#include "ili9341_dl.h"
+#include "fake_panel.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define TEXT_X		10
+#define TEXT_Y		100
+#define LONG_TEXT	70000
+/*==================[internal data definition]===============================*/
+static uint16_t expected[FAKE_PANEL_PAGES][FAKE_PANEL_COLUMNS];
+static uint8_t buffer[LONG_TEXT + 64] __attribute__((aligned(16)));	/*!< &buffer[1] is never aligned */
+static char long_text[LONG_TEXT + 1];
+static ili9341_dl_t dl;
+/*==================[internal functions definition]==========================*/
+/** Column of the second string: right after "Temp", as ILI9341DrawString() would go on */
+static uint16_t SecondX(void){
+	uint16_t width, height;
+
+	ILI9341GetStringSize("Temp", &font_19, &width, &height);
+	return TEXT_X + width;
+}
+
+/** Two strings continuing each other, and optionally a rectangle over the gap
+ * column between them (and the start of the second string) */
+static void DirectScene(bool cover){
+	ILI9341DrawString(TEXT_X, TEXT_Y, "Temp", &font_19, ILI9341_WHITE, ILI9341_BLACK);
+	ILI9341DrawString(SecondX(), TEXT_Y, ":25", &font_19, ILI9341_WHITE, ILI9341_BLACK);
+	if (cover){
+		ILI9341DrawFilledRectangle(SecondX() - 1, TEXT_Y, SecondX() + 2, TEXT_Y + font_19.font_height - 1, ILI9341_RED);
+	}
+	ILI9341WaitTransfer();
+}
+
+static uint16_t DlScene(bool cover){
+	uint16_t sent;
+
+	ILI9341DlClear(&dl);
+	CHECK(ILI9341DlString(&dl, TEXT_X, TEXT_Y, "Temp", &font_19, ILI9341_WHITE, ILI9341_BLACK));
+	CHECK(ILI9341DlString(&dl, SecondX(), TEXT_Y, ":25", &font_19, ILI9341_WHITE, ILI9341_BLACK));
+	if (cover){
+		CHECK(ILI9341DlFilledRectangle(&dl, SecondX() - 1, TEXT_Y, SecondX() + 2, TEXT_Y + font_19.font_height - 1, ILI9341_RED));
+	}
+	sent = ILI9341DlReplay(&dl);
+	ILI9341WaitTransfer();
+	return sent;
+}
+
+static void TestGapKept(void){
+	/* Nothing covers the gap: it keeps what the panel had, strings are sent apart */
+	FakePanelReset(ILI9341_BLUE);
+	DirectScene(false);
+	memcpy(expected, FakePanel, sizeof(expected));
+
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341DlInit(&dl, buffer, sizeof(buffer));
+	CHECK_EQ(DlScene(false), 2);
+	CHECK_EQ(FakePanel[TEXT_Y][SecondX() - 1], ILI9341_BLUE);
+	CHECK(memcmp(expected, FakePanel, sizeof(expected)) == 0);
+}
+
+static void TestGapCovered(void){
+	/* The rectangle paints the gap after the strings: they are sent as one */
+	FakePanelReset(ILI9341_BLUE);
+	DirectScene(true);
+	memcpy(expected, FakePanel, sizeof(expected));
+
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341DlInit(&dl, buffer, sizeof(buffer));
+	CHECK_EQ(DlScene(true), 2);
+	CHECK(memcmp(expected, FakePanel, sizeof(expected)) == 0);
+}
+
+static void TestAlignment(void){
+	ILI9341DlInit(&dl, &buffer[1], 64);
+	CHECK_EQ((uintptr_t)dl.buffer % sizeof(void *), 0);
+	CHECK(dl.buffer == &buffer[sizeof(void *)] && dl.size == 65 - sizeof(void *));
+	CHECK(ILI9341DlFilledRectangle(&dl, 0, 0, 9, 9, ILI9341_RED));
+
+	/* Too small to reach an aligned address: empty, nothing can be recorded */
+	ILI9341DlInit(&dl, &buffer[1], 1);
+	CHECK_EQ(dl.size, 0);
+	CHECK(!ILI9341DlFilledRectangle(&dl, 0, 0, 9, 9, ILI9341_RED));
+}
+
+static void TestLongString(void){
+	ILI9341DlInit(&dl, buffer, sizeof(buffer));
+	memset(long_text, 'a', LONG_TEXT);
+	/* Length doesn't fit 16 bits */
+	long_text[LONG_TEXT] = '\0';
+	CHECK(!ILI9341DlString(&dl, 0, 0, long_text, &font_19, ILI9341_WHITE, ILI9341_BLACK));
+	/* Length fits, record size doesn't */
+	long_text[UINT16_MAX - 8] = '\0';
+	CHECK(!ILI9341DlString(&dl, 0, 0, long_text, &font_19, ILI9341_WHITE, ILI9341_BLACK));
+	CHECK_EQ(dl.count, 0);
+	CHECK_EQ(dl.used, 0);
+	/* Long strings that fit are kept (and not exact: wider than the LCD) */
+	long_text[1000] = '\0';
+	CHECK(ILI9341DlString(&dl, 0, 0, long_text, &font_19, ILI9341_WHITE, ILI9341_BLACK));
+	CHECK_EQ(dl.count, 1);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	ILI9341Init(SPI_1, GPIO_2, GPIO_3);
+	TEST_RUN(TestGapKept);
+	TEST_RUN(TestGapCovered);
+	TEST_RUN(TestAlignment);
+	TEST_RUN(TestLongString);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
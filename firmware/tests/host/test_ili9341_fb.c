@@ -0,0 +1,99 @@
+/**
+ * @file test_ili9341_fb.c
+ * @brief Host tests of the ILI9341 partial framebuffer: bytes sent per frame and
+ * panel contents against direct drawing.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include "ili9341.h"
+#include "ili9341_fb.h"
+#include "fake_panel.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define STRIP_Y		100
+#define STRIP_H		40
+#define VALUE_X		110
+#define TEXT_Y		(STRIP_Y + 10)
+/*==================[internal data definition]===============================*/
+static uint16_t expected[FAKE_PANEL_PAGES][FAKE_PANEL_COLUMNS];
+/*==================[internal functions definition]==========================*/
+static void FbScene(uint32_t value){
+	ILI9341FbDrawString(10, TEXT_Y, "Temp:", &font_19, ILI9341_WHITE, ILI9341_BLACK);
+	ILI9341FbDrawInt(VALUE_X, TEXT_Y, value, 3, &font_19, ILI9341_YELLOW, ILI9341_BLACK);
+}
+
+/** The same widget drawn straight to the LCD: background, label and value */
+static void DirectScene(uint32_t value){
+	ILI9341DrawFilledRectangle(0, STRIP_Y, ILI9341_WIDTH - 1, STRIP_Y + STRIP_H - 1, ILI9341_BLACK);
+	ILI9341DrawString(10, TEXT_Y, "Temp:", &font_19, ILI9341_WHITE, ILI9341_BLACK);
+	ILI9341DrawInt(VALUE_X, TEXT_Y, value, 3, &font_19, ILI9341_YELLOW, ILI9341_BLACK);
+	ILI9341WaitTransfer();
+}
+
+static void TestBytesPerFrame(void){
+	uint32_t bytes, frame, direct;
+
+	FakePanelReset(ILI9341_BLUE);
+	CHECK(ILI9341FbInit(0, STRIP_Y, ILI9341_WIDTH, STRIP_H));
+	ILI9341FbFill(ILI9341_BLACK);
+	FbScene(25);
+	/* First flush: the whole strip */
+	bytes = ILI9341FbFlush();
+	ILI9341WaitTransfer();
+	CHECK_EQ(bytes, ILI9341_WIDTH * STRIP_H * 2);
+	CHECK_EQ(FakePanelStats.pixels, bytes);
+
+	/* Unchanged text: nothing to send */
+	FakePanelReset(ILI9341_BLUE);
+	ILI9341FbDrawString(10, TEXT_Y, "Temp:", &font_19, ILI9341_WHITE, ILI9341_BLACK);
+	CHECK_EQ(ILI9341FbFlush(), 0);
+	CHECK_EQ(FakePanelBytes(), 0);
+
+	/* One digit changes: a small area, one window */
+	FbScene(26);
+	bytes = ILI9341FbFlush();
+	ILI9341WaitTransfer();
+	frame = FakePanelBytes();
+	CHECK_EQ(FakePanelStats.pixels, bytes);
+	CHECK_EQ(FakePanelStats.windows, 1);
+	/* Less than three 32 pixels wide characters */
+	CHECK(bytes > 0 && bytes <= 3 * 32 * font_19.font_height * 2);
+
+	FakePanelReset(ILI9341_BLUE);
+	DirectScene(26);
+	direct = FakePanelBytes();
+	printf("bytes per frame: framebuffer %lu (%lu of pixels), direct redraw %lu\n",
+			(unsigned long)frame, (unsigned long)bytes, (unsigned long)direct);
+	CHECK(frame * 10 < direct);
+	ILI9341FbDeInit();
+}
+
+static void TestSameImage(void){
+	/* Digits overlap (proportional font): the LCD keeps what each call leaves */
+	FakePanelReset(ILI9341_BLUE);
+	DirectScene(99);
+	ILI9341DrawInt(VALUE_X, TEXT_Y, 137, 3, &font_19, ILI9341_YELLOW, ILI9341_BLACK);
+	ILI9341WaitTransfer();
+	memcpy(expected, FakePanel, sizeof(expected));
+
+	FakePanelReset(ILI9341_BLUE);
+	CHECK(ILI9341FbInit(0, STRIP_Y, ILI9341_WIDTH, STRIP_H));
+	ILI9341FbFill(ILI9341_BLACK);
+	FbScene(99);
+	ILI9341FbFlush();
+	FbScene(137);
+	ILI9341FbFlush();
+	ILI9341WaitTransfer();
+	CHECK(memcmp(expected, FakePanel, sizeof(expected)) == 0);
+	ILI9341FbDeInit();
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	ILI9341Init(SPI_1, GPIO_2, GPIO_3);
+	TEST_RUN(TestBytesPerFrame);
+	TEST_RUN(TestSameImage);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,165 @@
+/**
+ * @file test_img565.c
+ * @brief Host round trip of compressed pictures: a synthetic picture (img565_picture.c)
+ * encoded by firmware/tools/img565.py at build time, decoded by
+ * ILI9341DrawCompressedPicture() on the SPI panel fake and by Img565Decode() in
+ * small pieces, and compared with the source pixels.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <string.h>
+#include "ili9341.h"
+#include "img565.h"
+#include "fake_panel.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define PIXELS		(PICTURE_WIDTH * PICTURE_HEIGHT)
+#define X			20		/*!< Picture position on the LCD */
+#define Y			40
+
+enum {OP_INDEX, OP_DIFF, OP_LUMA, OP_RUN, OP_RGB, OP_RUN16, OPS};
+/*==================[internal data definition]===============================*/
+extern const uint8_t picture_565[];		/*!< Made by img565.py from PICTURE_BIN */
+static uint16_t source[PIXELS];
+static uint8_t decoded[PIXELS * 2];
+static uint32_t encoded_size;
+/*==================[internal functions definition]==========================*/
+static bool LoadSource(void){
+	uint8_t bytes[2];
+	FILE *f = fopen(PICTURE_BIN, "rb");
+
+	if (f == NULL){
+		return false;
+	}
+	for (uint32_t i = 0; i < PIXELS && fread(bytes, 1, 2, f) == 2; i++){
+		source[i] = (bytes[0] << 8) | bytes[1];
+	}
+	fclose(f);
+	return true;
+}
+
+/** Walk the opcodes of the picture, counting each kind and the pixels they make */
+static uint32_t Opcodes(uint32_t count[OPS]){
+	const uint8_t *op = picture_565 + IMG565_HEADER_SIZE;
+	uint32_t pixels = 0;
+
+	memset(count, 0, OPS * sizeof(uint32_t));
+	while (pixels < PIXELS){
+		if (*op == 0xFE){
+			count[OP_RGB]++;
+			op += 3;
+			pixels++;
+		}
+		else if (*op == 0xFF){
+			count[OP_RUN16]++;
+			pixels += ((op[1] << 8) | op[2]) + 1;
+			op += 3;
+		}
+		else if ((*op >> 6) == 3){
+			count[OP_RUN]++;
+			pixels += (*op & 0x3F) + 1;
+			op++;
+		}
+		else if ((*op >> 6) == 2){
+			count[OP_LUMA]++;
+			op += 2;
+			pixels++;
+		}
+		else{
+			count[(*op >> 6) == 1 ? OP_DIFF : OP_INDEX]++;
+			op++;
+			pixels++;
+		}
+	}
+	encoded_size = op - picture_565;
+	return pixels;
+}
+
+/** Pixels of a decoded buffer (LCD byte order) that differ from the source */
+static uint32_t Differences(const uint8_t *pixels){
+	uint32_t diff = 0;
+
+	for (uint32_t i = 0; i < PIXELS; i++){
+		diff += (((pixels[2 * i] << 8) | pixels[2 * i + 1]) != source[i]);
+	}
+	return diff;
+}
+
+static void TestOpcodes(void){
+	uint32_t count[OPS];
+
+	/* Every opcode is used, and they make the whole picture */
+	CHECK_EQ(Opcodes(count), PIXELS);
+	for (int i = 0; i < OPS; i++){
+		CHECK(count[i] > 0);
+	}
+	printf("%ux%u pixels: %u bytes (%u raw), %u index, %u diff, %u luma, %u run, %u rgb, %u run16\n",
+			PICTURE_WIDTH, PICTURE_HEIGHT, encoded_size, PIXELS * 2, count[OP_INDEX], count[OP_DIFF],
+			count[OP_LUMA], count[OP_RUN], count[OP_RGB], count[OP_RUN16]);
+	CHECK(encoded_size < PIXELS * 2);
+}
+
+static void TestDecodePieces(void){
+	/* Piece sizes that end inside runs and between the bytes of a pixel buffer */
+	const uint32_t sizes[] = {2, 6, 14, 126, ILI9341_BUFFER_SIZE};
+	img565_decoder_t decoder;
+	uint16_t width, height;
+	uint32_t used, chunk;
+
+	for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+		memset(decoded, 0, sizeof(decoded));
+		CHECK(Img565Init(&decoder, picture_565, &width, &height));
+		CHECK_EQ(width, PICTURE_WIDTH);
+		CHECK_EQ(height, PICTURE_HEIGHT);
+		used = 0;
+		do {
+			chunk = Img565Decode(&decoder, &decoded[used], (sizes[s] < sizeof(decoded) - used) ? sizes[s] : sizeof(decoded) - used);
+			used += chunk;
+		} while (chunk > 0 && used < sizeof(decoded));
+		CHECK_EQ(used, sizeof(decoded));
+		CHECK_EQ(Img565Decode(&decoder, decoded, 2), 0);
+		CHECK_EQ(Differences(decoded), 0);
+	}
+}
+
+static void TestDrawCompressed(void){
+	const uint8_t other[IMG565_HEADER_SIZE] = {'R', '6', '5', '6', 0, 8, 0, 8};
+	uint32_t diff = 0, outside = 0;
+
+	/* The 16 bits run of the last band (a fifth of the rows) crosses pixel buffers */
+	CHECK((PIXELS * 4 / 5) / (ILI9341_BUFFER_SIZE / 2) < (PIXELS - 1) / (ILI9341_BUFFER_SIZE / 2));
+	FakePanelReset(ILI9341_BLACK);
+	CHECK(ILI9341DrawCompressedPicture(X, Y, picture_565));
+	ILI9341WaitTransfer();
+	CHECK_EQ(FakePanelStats.pixels, PIXELS * 2);
+	for (uint32_t y = 0; y < FAKE_PANEL_PAGES; y++){
+		for (uint32_t x = 0; x < FAKE_PANEL_COLUMNS; x++){
+			if (x >= X && x < X + PICTURE_WIDTH && y >= Y && y < Y + PICTURE_HEIGHT){
+				diff += (FakePanel[y][x] != source[(y - Y) * PICTURE_WIDTH + (x - X)]);
+			}
+			else{
+				outside += (FakePanel[y][x] != ILI9341_BLACK);
+			}
+		}
+	}
+	CHECK_EQ(diff, 0);
+	CHECK_EQ(outside, 0);
+
+	/* Not a compressed picture */
+	CHECK(!ILI9341DrawCompressedPicture(X, Y, other));
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	if (!LoadSource()){
+		printf("can't read %s\n", PICTURE_BIN);
+		return 1;
+	}
+	ILI9341Init(SPI_1, GPIO_2, GPIO_3);
+	TEST_RUN(TestOpcodes);
+	TEST_RUN(TestDecodePieces);
+	TEST_RUN(TestDrawCompressed);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,191 @@
+/**
+ * @file test_imu_calibration.c
+ * @brief Host tests of the IMU calibration: ImuCalApply() against a floating point
+ * reference, six position accelerometer calibration, overflow rejection and NVS.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include <math.h>
+#include "imu_calibration.h"
+#include "mpu6050.h"
+#include "fake_mcu.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define SAMPLES			1000	/*!< Not a multiple of the 32 sample chunks */
+#define POSITION_LEN	200		/*!< Samples of each calibration position */
+#define NOISE			4		/*!< Peak noise of the calibration positions (raw LSB) */
+/*==================[internal data definition]===============================*/
+static mpu6050_sample_t samples[SAMPLES];
+static int16_t accel_x[SAMPLES], accel_y[SAMPLES], accel_z[SAMPLES];
+static int16_t gyro_x[SAMPLES], gyro_y[SAMPLES], gyro_z[SAMPLES];
+static int16_t position[POSITION_LEN][3];
+static uint32_t seed = 2026;
+static imu_cal_t cal;			/*!< Calibration solved by TestAccelSolve(), used by the tests after it */
+/* Accelerometer under test: LSB per g (column j is the output for 1 g along axis j) and offset */
+static const float sensitivity[3][3] = {
+	{16500, 120, -90},
+	{-150, 16200, 60},
+	{80, -40, 16700},
+};
+static const float accel_offset[3] = {310, -205, 480};
+/*==================[internal functions definition]==========================*/
+static int32_t Random(int32_t min, int32_t max){
+	seed = seed * 1664525u + 1013904223u;
+	return min + (int32_t)((seed >> 8) % (uint32_t)(max - min + 1));
+}
+
+static int16_t Clamp(float value){
+	value = roundf(value);
+	return (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : (int16_t)value;
+}
+
+/** Capture the six positions of an accelerometer with the given sensitivity */
+static void Capture(imu_cal_capture_t *capture, const float sens[3][3]){
+	capture->done = 0;
+	for(int p = 0; p < IMU_CAL_POSITIONS; p++){
+		float g = (p % 2 == 0) ? 1.0f : -1.0f;
+
+		for(int k = 0; k < POSITION_LEN; k++){
+			for(int i = 0; i < 3; i++){
+				position[k][i] = Clamp(sens[i][p / 2] * g + accel_offset[i] + Random(-NOISE, NOISE));
+			}
+		}
+		CHECK(ImuCalAccelPosition(capture, p, &position[0][0], 3, POSITION_LEN, 2 * NOISE));
+	}
+}
+
+/** Largest error and average error of a calibrated block against the floating point result */
+static void Compare(const imu_cal_axes_t *axes, const int16_t *raw, int16_t *out[3], float *max, float *mean){
+	float ref, error, sum = 0;
+
+	*max = 0;
+	for(int k = 0; k < SAMPLES; k++){
+		for(int i = 0; i < 3; i++){
+			ref = 0;
+			for(int j = 0; j < 3; j++){
+				ref += axes->matrix[i][j] * (raw[k * (sizeof(mpu6050_sample_t) / 2) + j] - axes->offset[j]);
+			}
+			error = out[i][k] - ref;
+			*max = fmaxf(*max, fabsf(error));
+			sum += error;
+		}
+	}
+	*mean = sum / (3 * SAMPLES);
+}
+
+static void TestAccelSolve(void){
+	imu_cal_capture_t capture;
+	float product;
+
+	CHECK(ImuCalInit(&cal, 16384, 131, 1000, 10));
+	Capture(&capture, sensitivity);
+	CHECK(ImuCalAccelSolve(&cal, &capture));
+	for(int i = 0; i < 3; i++){
+		CHECK(fabsf(cal.accel.offset[i] - accel_offset[i]) < 0.5f);
+	}
+	/* Matrix times sensitivity: 1000 mg per g on the diagonal, nothing across */
+	for(int i = 0; i < 3; i++){
+		for(int j = 0; j < 3; j++){
+			product = 0;
+			for(int k = 0; k < 3; k++){
+				product += cal.accel.matrix[i][k] * sensitivity[k][j];
+			}
+			CHECK(fabsf(product - ((i == j) ? 1000.0f : 0.0f)) < 0.5f);
+		}
+	}
+	/* A missing position */
+	capture.done &= ~(1 << IMU_CAL_Y_DOWN);
+	CHECK(!ImuCalAccelSolve(&cal, &capture));
+}
+
+static void TestApply(void){
+	int16_t *accel_out[3] = {accel_x, accel_y, accel_z};
+	int16_t *gyro_out[3] = {gyro_x, gyro_y, gyro_z};
+	int16_t still[64][3];
+	float max, mean;
+
+	for(int k = 0; k < 64; k++){
+		still[k][0] = -150 + Random(-2, 2);
+		still[k][1] = 95 + Random(-2, 2);
+		still[k][2] = 12 + Random(-2, 2);
+	}
+	CHECK(ImuCalGyroBias(&cal, &still[0][0], 3, 64, 8));
+	/* Whole range, the rails first */
+	for(int k = 0; k < SAMPLES; k++){
+		for(int i = 0; i < 3; i++){
+			samples[k].accel[i] = (k < 8) ? (((k >> i) & 1) ? INT16_MAX : INT16_MIN) : Random(INT16_MIN, INT16_MAX);
+			samples[k].gyro[i] = (k < 8) ? (((k >> i) & 1) ? INT16_MIN : INT16_MAX) : Random(INT16_MIN, INT16_MAX);
+		}
+		samples[k].timestamp = k;
+	}
+	ImuCalApply(&cal, samples[0].accel, samples[0].gyro, sizeof(mpu6050_sample_t) / 2, SAMPLES, accel_out, gyro_out);
+
+	/* Full matrix: within the truncation of the products, no bias left */
+	Compare(&cal.accel, samples[0].accel, accel_out, &max, &mean);
+	printf("accel: max error %.2f mg, mean error %.3f mg\n", max, mean);
+	CHECK(max < 2.0f);
+	CHECK(fabsf(mean) < 0.1f);
+	Compare(&cal.gyro, samples[0].gyro, gyro_out, &max, &mean);
+	printf("gyro: max error %.2f, mean error %.3f (0.1 deg/s)\n", max, mean);
+	CHECK(max < 2.0f);
+	CHECK(fabsf(mean) < 0.1f);
+
+	/* NULL sensor: its outputs are left alone */
+	memset(gyro_x, 0x55, sizeof(gyro_x));
+	ImuCalApply(&cal, samples[0].accel, NULL, sizeof(mpu6050_sample_t) / 2, SAMPLES, accel_out, gyro_out);
+	CHECK_EQ((uint16_t)gyro_x[0], 0x5555);
+}
+
+static void TestOverflow(void){
+	float cross[3][3];
+	imu_cal_capture_t capture;
+	imu_cal_t other, before;
+
+	/* Raw units: -32768 would come out as +32768 */
+	CHECK(!ImuCalInit(&other, 16384, 131, 16384, 10));
+	CHECK(ImuCalInit(&other, 16384, 131, 15000, 10));
+
+	/* The sensor under test fits, strong cross axis terms push the sums over */
+	memcpy(cross, sensitivity, sizeof(cross));
+	Capture(&capture, cross);
+	CHECK(ImuCalAccelSolve(&other, &capture));
+	for(int i = 0; i < 3; i++){
+		for(int j = 0; j < 3; j++){
+			cross[i][j] = (i == j) ? 16384 : 1500;
+		}
+	}
+	Capture(&capture, cross);
+	before = other;
+	CHECK(!ImuCalAccelSolve(&other, &capture));
+	CHECK(memcmp(&before, &other, sizeof(other)) == 0);
+}
+
+static void TestSaveLoad(void){
+	imu_cal_t loaded;
+
+	FakeNvsErase();
+	CHECK(ImuCalInit(&loaded, 16384, 131, 100, 100));
+	CHECK(!ImuCalLoad(&loaded));
+	CHECK(ImuCalSave(&cal));
+	/* Saved in mg and 0.1 deg/s, loaded in 0.01 g and 0.01 deg/s */
+	CHECK(ImuCalLoad(&loaded));
+	CHECK_EQ(loaded.accel.units, 100);
+	for(int i = 0; i < 3; i++){
+		CHECK(loaded.accel.offset[i] == cal.accel.offset[i] && loaded.gyro.offset[i] == cal.gyro.offset[i]);
+		for(int j = 0; j < 3; j++){
+			CHECK(fabsf(loaded.accel.matrix[i][j] - cal.accel.matrix[i][j] / 10) < 1e-6f);
+			CHECK(fabsf(loaded.gyro.matrix[i][j] - cal.gyro.matrix[i][j] * 10) < 1e-5f);
+		}
+	}
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	TEST_RUN(TestAccelSolve);
+	TEST_RUN(TestApply);
+	TEST_RUN(TestOverflow);
+	TEST_RUN(TestSaveLoad);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,332 @@
+/**
+ * @file test_mpu6050.c
+ * @brief Host tests of the MPU6050 driver on the register model.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include <esp_timer.h>
+#include "mpu6050.h"
+#include "virtual_i2c.h"
+#include "mpu6050_model.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define SKEW_PPM	3000		/*!< Clock error of the second sensor of a group (0.3%) */
+/*==================[internal data definition]===============================*/
+static mpu6050_model_t model, model_high;
+static mpu6050_sample_t samples[64], samples_high[64];
+static mpu6050_t dev_low, dev_high;
+static mpu6050_group_t group;
+/*==================[internal functions definition]==========================*/
+static void Setup(void){
+	VirtualI2CReset();
+	MPU6050ModelInit(&model, MPU6050_DEFAULT_ADDRESS);
+	I2C_shadowInvalidate(MPU6050_DEFAULT_ADDRESS);
+	MPU6050_initialize();
+}
+
+static void TestInitialize(void){
+	Setup();
+	CHECK(MPU6050_testConnection());
+	/* Awake, PLL clock, 1 kHz */
+	CHECK_EQ(model.regs[MPU6050_RA_PWR_MGMT_1], MPU6050_CLOCK_PLL_XGYRO);
+	CHECK(MPU6050ModelPeriod(&model) > 0);
+}
+
+static void TestConfigure(void){
+	const mpu6050_config_t config = {9, MPU6050_DLPF_BW_42, MPU6050_GYRO_FS_500, MPU6050_ACCEL_FS_4,
+			MPU6050_CLOCK_PLL_XGYRO, MPU6050_STREAM_ACCEL, 0x10, 0x01, false};
+
+	Setup();
+	/* PWR_MGMT_1 written, then the three bursts fail: read back as before */
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 1, 3, ESP_FAIL);
+	CHECK(!MPU6050_configure(&config));
+	VirtualI2CResetCounters();
+	CHECK(MPU6050_configure(&config));
+	CHECK_EQ(model.regs[MPU6050_RA_SMPLRT_DIV], 9);
+	CHECK_EQ(model.regs[MPU6050_RA_FIFO_EN], MPU6050_STREAM_ACCEL);
+	CHECK_EQ(model.regs[MPU6050_RA_INT_PIN_CFG], 0x10);
+	CHECK_EQ(model.regs[MPU6050_RA_INT_ENABLE], 0x01);
+	/* PWR_MGMT_1, three bursts and one read back */
+	CHECK_EQ(VirtualI2CTransactions(), 5);
+	MPU6050_setIntEnabled(0);
+}
+
+static void TestMotion6(void){
+	int16_t ax, ay, az, gx, gy, gz;
+	int16_t expected[7];
+
+	Setup();
+	VirtualI2CAdvance(10000);
+	MPU6050_getMotion6(&ax, &ay, &az, &gx, &gy, &gz);
+	MPU6050ModelSample(model.samples - 1, expected);
+	CHECK_EQ(ax, expected[0]);
+	CHECK_EQ(az, expected[2]);
+	CHECK_EQ(gz, expected[6]);
+}
+
+static void TestStream(void){
+	mpu6050_stream_t stream;
+	mpu6050_sample_t sample;
+	uint32_t first, count = 0;
+	bool ordered = true;
+
+	Setup();
+	CHECK(MPU6050_streamStart(&stream, samples, 64, MPU6050_STREAM_ACCEL | MPU6050_STREAM_GYRO, MPU6050_DLPF_BW_42, 9));
+	first = model.samples;
+	for(int i = 0; i < 10; i++){
+		VirtualI2CAdvance(20000);
+		MPU6050_streamRead(&stream);
+		while(MPU6050_streamGet(&stream, &sample)){
+			ordered &= (uint16_t)sample.accel[0] == (uint16_t)(first + count);
+			ordered &= sample.gyro[2] == (int16_t)-sample.accel[0];
+			count++;
+		}
+	}
+	CHECK(ordered);
+	CHECK_EQ(stream.overflows, 0);
+	/* 100 Hz for 200 ms */
+	CHECK(count >= 19 && count <= 21);
+	MPU6050_streamStop();
+}
+
+static void TestStreamReadFailure(void){
+	mpu6050_stream_t stream;
+	mpu6050_sample_t sample;
+	uint16_t head;
+	int64_t next_time;
+	uint32_t first, count = 0;
+	bool ordered = true;
+
+	Setup();
+	CHECK(MPU6050_streamStart(&stream, samples, 64, MPU6050_STREAM_ACCEL | MPU6050_STREAM_GYRO, MPU6050_DLPF_BW_42, 9));
+	first = model.samples;
+	VirtualI2CAdvance(50000);
+	/* Failed count read, then failed burst after a good count: nothing taken */
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 0, 1, ESP_FAIL);
+	CHECK_EQ(MPU6050_streamRead(&stream), 0);
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 1, 1, ESP_FAIL);
+	head = stream.head;
+	next_time = stream.next_time;
+	CHECK_EQ(MPU6050_streamRead(&stream), 0);
+	CHECK_EQ(stream.head, head);
+	CHECK_EQ(stream.next_time, next_time);
+	/* The samples left in the FIFO come with the next read, in order */
+	CHECK(MPU6050_streamRead(&stream) >= 4);
+	while(MPU6050_streamGet(&stream, &sample)){
+		ordered &= (uint16_t)sample.accel[0] == (uint16_t)(first + count);
+		count++;
+	}
+	CHECK(ordered);
+	CHECK_EQ(stream.overflows, 0);
+	MPU6050_streamStop();
+}
+
+/** Wait for the data ready task to take a sample or lose it. */
+static void WaitDataReady(const mpu6050_stream_t *stream, uint16_t head, uint32_t overflows){
+	for(int i = 0; i < 200 && stream->head == head && stream->overflows == overflows; i++){
+		vTaskDelay(1);
+	}
+}
+
+static void TestDataReady(void){
+	mpu6050_stream_t stream;
+	mpu6050_sample_t sample;
+
+	Setup();
+	model.int_pin = GPIO_3;
+	CHECK(MPU6050_dataReadyStart(&stream, samples, 64, MPU6050_DLPF_BW_42, 9, GPIO_3, 5));
+	VirtualI2CAdvance(10000);
+	WaitDataReady(&stream, 0, 0);
+	CHECK(MPU6050_streamGet(&stream, &sample));
+	CHECK_EQ((uint16_t)sample.accel[0], (uint16_t)(model.samples - 1));
+	CHECK_EQ(stream.overflows, 0);
+	/* A failed read is a lost sample, not a sample */
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 0, 1, ESP_FAIL);
+	VirtualI2CAdvance(10000);
+	WaitDataReady(&stream, stream.head, 0);
+	CHECK_EQ(stream.overflows, 1);
+	CHECK(!MPU6050_streamGet(&stream, &sample));
+	/* The interrupt stays on the first pin */
+	CHECK(!MPU6050_dataReadyStart(&stream, samples, 64, MPU6050_DLPF_BW_42, 9, GPIO_4, 5));
+	CHECK(MPU6050_dataReadyStart(&stream, samples, 64, MPU6050_DLPF_BW_42, 4, GPIO_3, 5));
+	MPU6050_dataReadyStop();
+}
+
+static void TestDmp(void){
+	uint8_t block[12], back[12];
+	mpu6050_dmp_packet_t packet;
+
+	Setup();
+	for(int i = 0; i < 12; i++){
+		block[i] = 0xA0 + i;
+	}
+	/* Across the end of bank 1 */
+	CHECK(MPU6050_writeMemoryBlock(block, 12, 1, 250, true));
+	CHECK_EQ(model.mem[2][5], 0xAB);
+	CHECK(MPU6050_readMemoryBlock(back, 12, 1, 250));
+	CHECK(memcmp(block, back, 12) == 0);
+	CHECK(!MPU6050_readMemoryBlock(back, 12, 7, 250));
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 2, 1, ESP_FAIL);
+	CHECK(!MPU6050_readMemoryBlock(back, 12, 1, 250));
+	/* A packet in the FIFO: a failed count read leaves it there */
+	memset(model.fifo, 0, MPU6050_DMP_PACKET_SIZE);
+	model.fifo[2] = 0x40;
+	model.fifo_head = 0;
+	model.fifo_count = MPU6050_DMP_PACKET_SIZE;
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 0, 1, ESP_FAIL);
+	CHECK(!MPU6050_dmpGetPacket(&packet));
+	CHECK_EQ(model.fifo_count, MPU6050_DMP_PACKET_SIZE);
+	CHECK(MPU6050_dmpGetPacket(&packet));
+	CHECK_EQ(packet.quat[0], 0x4000);
+	/* A failed packet read may leave the FIFO unaligned: emptied */
+	model.fifo_count = MPU6050_DMP_PACKET_SIZE + 10;
+	VirtualI2CFail(MPU6050_DEFAULT_ADDRESS, 1, 1, ESP_FAIL);
+	CHECK(!MPU6050_dmpGetPacket(&packet));
+	CHECK_EQ(model.fifo_count, 0);
+}
+
+/** Two sensors on the bus as instances, the second one with a skewed clock */
+static void GroupSetup(void){
+	mpu6050_t *const devices[] = {&dev_low, &dev_high};
+
+	Setup();
+	MPU6050ModelInit(&model_high, MPU6050_ADDRESS_AD0_HIGH);
+	model_high.clock_ppm = SKEW_PPM;
+	CHECK(MPU6050_deviceInit(&dev_low, MPU6050_ADDRESS_AD0_LOW));
+	CHECK(MPU6050_deviceInit(&dev_high, MPU6050_ADDRESS_AD0_HIGH));
+	CHECK(MPU6050_groupInit(&group, devices, 2, 5));
+}
+
+static void TestDeviceGetMotion6(void){
+	mpu6050_sample_t sample = {0};
+
+	GroupSetup();
+	VirtualI2CAdvance(10000);
+	CHECK(MPU6050_deviceGetMotion6(&dev_high, &sample));
+	CHECK_EQ((uint16_t)sample.accel[0], (uint16_t)(model_high.samples - 1));
+	/* A failed read leaves the sample as it was */
+	VirtualI2CFail(MPU6050_ADDRESS_AD0_HIGH, 0, 1, ESP_FAIL);
+	sample.accel[0] = 1234;
+	CHECK(!MPU6050_deviceGetMotion6(&dev_high, &sample));
+	CHECK_EQ(sample.accel[0], 1234);
+}
+
+static void TestDeviceDataReady(void){
+	mpu6050_stream_t stream;
+	mpu6050_sample_t sample;
+
+	GroupSetup();
+	model_high.int_pin = GPIO_3;
+	/* Set up on the instance address, not on the MPU6050_Address() one */
+	CHECK(MPU6050_deviceDataReadyStart(&dev_high, &stream, samples, 64, MPU6050_DLPF_BW_42, 9, GPIO_3, 5));
+	CHECK(model_high.regs[MPU6050_RA_INT_ENABLE] & (1 << MPU6050_INTERRUPT_DATA_RDY_BIT));
+	CHECK(!(model.regs[MPU6050_RA_INT_ENABLE] & (1 << MPU6050_INTERRUPT_DATA_RDY_BIT)));
+	VirtualI2CAdvance(10000);
+	WaitDataReady(&stream, 0, 0);
+	CHECK(MPU6050_streamGet(&stream, &sample));
+	CHECK_EQ((uint16_t)sample.accel[0], (uint16_t)(model_high.samples - 1));
+	MPU6050_deviceDataReadyStop(&dev_high);
+	CHECK(!(model_high.regs[MPU6050_RA_INT_ENABLE] & (1 << MPU6050_INTERRUPT_DATA_RDY_BIT)));
+}
+
+static void TestGroupSample(void){
+	mpu6050_sample_t set[2];
+	virtual_i2c_transaction_t low, high;
+	int64_t queued;
+
+	GroupSetup();
+	/* Nothing queued without the I2C task */
+	CHECK(!MPU6050_groupSample(&group, set));
+	CHECK(I2C_queueInit(5));
+	VirtualI2CAdvance(10000);
+	VirtualI2CResetCounters();
+	queued = esp_timer_get_time();
+	CHECK(MPU6050_groupSample(&group, set));
+	/* One batch: both reads back to back, nothing in between */
+	CHECK_EQ(VirtualI2CTransactions(), 2);
+	CHECK(VirtualI2CTransaction(0, &low) && VirtualI2CTransaction(1, &high));
+	CHECK_EQ(low.address, MPU6050_ADDRESS_AD0_LOW);
+	CHECK_EQ(high.address, MPU6050_ADDRESS_AD0_HIGH);
+	CHECK_EQ(high.start, low.end);
+	CHECK(low.start >= queued);
+	/* Common timestamp, each sensor's sample of the time of the reads (8 kHz: a few
+	 * more were taken while reading) */
+	CHECK_EQ(set[0].timestamp, queued);
+	CHECK_EQ(set[1].timestamp, queued);
+	CHECK((uint16_t)(model.samples - 1 - set[0].accel[0]) < 8);
+	CHECK((uint16_t)(model_high.samples - 1 - set[1].accel[0]) < 8);
+	/* One failed read fails the group */
+	VirtualI2CFail(MPU6050_ADDRESS_AD0_HIGH, 0, 1, ESP_FAIL);
+	CHECK(!MPU6050_groupSample(&group, set));
+}
+
+static void TestGroupStream(void){
+	mpu6050_sample_t *const rings[] = {samples, samples_high};
+	mpu6050_sample_t set[2];
+	uint16_t last[2] = {0, 0};
+	uint32_t sets = 0, skipped = 0;
+	bool paired = true;
+
+	GroupSetup();
+	CHECK(MPU6050_groupStreamStart(&group, rings, 64, MPU6050_STREAM_ACCEL | MPU6050_STREAM_GYRO, MPU6050_DLPF_BW_42, 9));
+	/* 100 Hz for 5.4 s (reads included): the clocks drift 1.6 periods apart */
+	for(int i = 0; i < 250; i++){
+		VirtualI2CAdvance(20000);
+		MPU6050_groupStreamRead(&group);
+		while(MPU6050_groupStreamGet(&group, set)){
+			paired &= set[0].timestamp == set[1].timestamp;
+			/* Each sensor goes on with its next sample, or skips the dropped ones */
+			for(int k = 0; sets > 0 && k < 2; k++){
+				paired &= (uint16_t)(set[k].accel[0] - last[k]) >= 1;
+				skipped += (uint16_t)(set[k].accel[0] - last[k]) - 1;
+			}
+			last[0] = set[0].accel[0];
+			last[1] = set[1].accel[0];
+			sets++;
+		}
+	}
+	CHECK(paired);
+	CHECK_EQ(group.streams[0].overflows, 0);
+	CHECK_EQ(group.streams[1].overflows, 0);
+	CHECK(sets >= 530);
+	CHECK(group.dropped >= 1 && group.dropped <= 2);
+	CHECK_EQ(skipped, group.dropped);
+	MPU6050_groupStreamStop(&group);
+}
+
+static void TestCommitWithoutShadow(void){
+	uint8_t back;
+
+	VirtualI2CReset();
+	MPU6050ModelInit(&model, MPU6050_ADDRESS_AD0_HIGH);
+	/* Only the default address has a shadow copy */
+	MPU6050_Address(MPU6050_ADDRESS_AD0_HIGH);
+	MPU6050_beginConfig();
+	MPU6050_setRate(4);
+	CHECK(MPU6050_commitConfig());
+	CHECK_EQ(I2C_readByte(MPU6050_ADDRESS_AD0_HIGH, MPU6050_RA_SMPLRT_DIV, &back, I2C_MASTER_TIMEOUT_MS), 1);
+	CHECK_EQ(back, 4);
+	VirtualI2CFail(MPU6050_ADDRESS_AD0_HIGH, 0, 1, ESP_FAIL);
+	CHECK_EQ(I2C_readByte(MPU6050_ADDRESS_AD0_HIGH, MPU6050_RA_SMPLRT_DIV, &back, I2C_MASTER_TIMEOUT_MS), -1);
+	MPU6050_Address(MPU6050_DEFAULT_ADDRESS);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	I2C_initialize(400000);
+	TEST_RUN(TestInitialize);
+	TEST_RUN(TestConfigure);
+	TEST_RUN(TestMotion6);
+	TEST_RUN(TestStream);
+	TEST_RUN(TestStreamReadFailure);
+	TEST_RUN(TestDataReady);
+	TEST_RUN(TestDmp);
+	TEST_RUN(TestCommitWithoutShadow);
+	TEST_RUN(TestDeviceGetMotion6);
+	TEST_RUN(TestDeviceDataReady);
+	TEST_RUN(TestGroupSample);
+	TEST_RUN(TestGroupStream);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
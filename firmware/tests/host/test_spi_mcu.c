@@ -0,0 +1,154 @@
+/**
+ * @file test_spi_mcu.c
+ * @brief Host tests of the SPI driver on the fake ESP-IDF SPI master: device
+ * registry, queued and asynchronous transfers, and one device used by two tasks.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spi_mcu.h"
+#include "fake_spi_master.h"
+#include "test.h"
+/*==================[macros and definitions]=================================*/
+#define WRITES		2000	/*!< Queued writes of each task */
+#define FLUSH_EVERY	50		/*!< Writes between flushes of each task */
+/*==================[internal data definition]===============================*/
+static uint8_t data[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+static uint8_t rx[2][16];
+static spi_trans_t trans[2];
+static volatile uint32_t notified;
+static TaskHandle_t main_task;
+/*==================[internal functions definition]==========================*/
+static void Notified(void *param){
+	(void)param;
+	__atomic_fetch_add(&notified, 1, __ATOMIC_RELAXED);
+}
+
+static void Writer(void *param){
+	(void)param;
+	for(int i = 1; i <= WRITES; i++){
+		SpiWriteQueued(SPI_1, data, sizeof(data), true);
+		if(i % FLUSH_EVERY == 0){
+			SpiFlush(SPI_1);
+		}
+	}
+	xTaskNotifyGive(main_task);
+	vTaskDelete(NULL);
+}
+
+static void TestRegistry(void){
+	spi_mcu_config_t lcd = {.device = SPI_1, .clk_mode = MODE0, .bitrate = 1000000, .transfer_mode = SPI_POLLING};
+	spi_mcu_config_t sd = {.device = SPI_2, .clk_mode = MODE3, .bitrate = 2000000, .transfer_mode = SPI_INTERRUPT,
+		.dc_en = true, .dc_gpio = GPIO_5};
+	const fake_spi_device_state_t *dev1, *dev2;
+
+	/* Same configuration again: not added again */
+	CHECK(SpiInit(&lcd));
+	CHECK(SpiInit(&lcd));
+	dev1 = FakeSpiDevice(GPIO_19);
+	CHECK(dev1 != NULL && dev1->adds == 1 && dev1->added);
+
+	/* Devices keep their own mode and clock */
+	CHECK(SpiInit(&sd));
+	dev2 = FakeSpiDevice(GPIO_18);
+	CHECK(dev2 != NULL && dev2->adds == 1);
+	CHECK_EQ(dev2->mode, 3);
+	CHECK_EQ(dev2->clock_speed_hz, 2000000);
+	CHECK_EQ(dev1->mode, 0);
+	CHECK_EQ(dev1->clock_speed_hz, 1000000);
+
+	/* Same bitrate: nothing to do. New bitrate: added again once */
+	CHECK(SpiSetBitrate(SPI_1, 1000000));
+	CHECK_EQ(dev1->adds, 1);
+	CHECK(SpiSetBitrate(SPI_1, 4000000));
+	CHECK_EQ(dev1->adds, 2);
+	CHECK_EQ(dev1->removes, 1);
+	CHECK_EQ(dev1->clock_speed_hz, 4000000);
+	CHECK_EQ(dev1->mode, 0);
+	CHECK_EQ(dev2->adds, 1);
+
+	/* The registry keeps the new bitrate: init with it is the same configuration */
+	lcd.bitrate = 4000000;
+	CHECK(SpiInit(&lcd));
+	CHECK_EQ(dev1->adds, 2);
+	lcd.clk_mode = MODE1;
+	CHECK(SpiInit(&lcd));
+	CHECK_EQ(dev1->adds, 3);
+	CHECK_EQ(dev1->mode, 1);
+
+	CHECK(SpiDeInit(SPI_2));
+	CHECK(!dev2->added);
+	CHECK(!SpiDeInit(SPI_2));
+	CHECK(!SpiSetBitrate(SPI_2, 1000000));
+	CHECK_EQ(FakeSpiErrors(), 0);
+}
+
+static void TestAsync(void){
+	spi_mcu_config_t lcd = {.device = SPI_1, .clk_mode = MODE0, .bitrate = 1000000, .transfer_mode = SPI_POLLING,
+		.func_p = Notified};
+	const fake_spi_device_state_t *dev;
+
+	CHECK(SpiInit(&lcd));
+	dev = FakeSpiDevice(GPIO_19);
+	notified = 0;
+	for(int i = 0; i < 2; i++){
+		memset(&trans[i], 0, sizeof(spi_trans_t));
+		trans[i].tx_buffer = &data[i];
+		trans[i].rx_buffer = rx[i];
+		trans[i].size = 8;
+	}
+	/* Queued writes in between are skipped, asynchronous transfers come back in order */
+	SpiWriteQueued(SPI_1, data, sizeof(data), true);
+	SpiTransferAsync(SPI_1, &trans[0]);
+	SpiWriteQueued(SPI_1, data, sizeof(data), false);
+	SpiTransferAsync(SPI_1, &trans[1]);
+	SpiWriteQueued(SPI_1, data, sizeof(data), true);
+	CHECK_EQ(dev->pending, 5);
+	CHECK(SpiGetResult(SPI_1, true) == &trans[0]);
+	CHECK(SpiGetResult(SPI_1, true) == &trans[1]);
+	CHECK(trans[0].done && trans[1].done);
+	CHECK(memcmp(rx[1], &data[1], 8) == 0);
+	CHECK_EQ(dev->pending, 1);
+	CHECK(SpiGetResult(SPI_1, false) == NULL);
+	CHECK_EQ(dev->pending, 0);
+	CHECK_EQ(notified, 2);
+
+	/* Polling device: only the segment with notify calls back */
+	spi_segment_t segments[] = {
+		{.tx_buffer = data, .size = 1, .command = true},
+		{.tx_buffer = data, .size = sizeof(data), .notify = true},
+	};
+	SpiTransferList(SPI_1, segments, 2);
+	CHECK_EQ(notified, 3);
+	CHECK_EQ(FakeSpiErrors(), 0);
+}
+
+static void TestTwoTasks(void){
+	const fake_spi_device_state_t *dev = FakeSpiDevice(GPIO_19);
+	uint32_t before = dev->transfers;
+
+	/* Two tasks queue to the same device and flush it: the queue must stay consistent */
+	notified = 0;
+	main_task = xTaskGetCurrentTaskHandle();
+	xTaskCreate(Writer, "writer1", 2048, NULL, 5, NULL);
+	xTaskCreate(Writer, "writer2", 2048, NULL, 5, NULL);
+	ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	SpiFlush(SPI_1);
+	CHECK_EQ(dev->transfers - before, 2 * WRITES);
+	CHECK_EQ(notified, 2 * WRITES);
+	CHECK_EQ(dev->pending, 0);
+	CHECK(dev->max_pending <= SPI_QUEUE_SIZE);
+	CHECK_EQ(FakeSpiErrors(), 0);
+}
+/*==================[external functions definition]==========================*/
+int main(void){
+	TEST_RUN(TestRegistry);
+	TEST_RUN(TestAsync);
+	TEST_RUN(TestTwoTasks);
+	return TEST_END();
+}
+
+/*==================[end of file]============================================*/
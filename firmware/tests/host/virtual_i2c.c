@@ -0,0 +1,368 @@
+/**
+ * @file virtual_i2c.c
+ * @brief Virtual I2C bus for host tests (see virtual_i2c.h).
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "driver/i2c.h"
+#include "esp_timer.h"
+#include "virtual_i2c.h"
+/*==================[macros and definitions]=================================*/
+#define WRITE_PHASE_SIZE	512		/*!< Maximum number of bytes written in a single phase */
+#define DYNAMIC_LINK_OPS	32		/*!< Commands of links from i2c_cmd_link_create() */
+
+typedef enum {
+	OP_START,
+	OP_STOP,
+	OP_WRITE,
+	OP_READ,
+} op_type_t;
+
+typedef struct {
+	op_type_t type;
+	uint8_t byte;				/*!< Single byte write */
+	const uint8_t *data;		/*!< Multiple byte write (kept by reference, as the ESP-IDF driver does) */
+	uint8_t *rx;				/*!< Read buffer */
+	size_t length;
+} i2c_op_t;
+
+struct i2c_cmd_link {
+	bool dynamic;
+	uint16_t count;
+	uint16_t capacity;
+	i2c_op_t op[];
+};
+/*==================[internal data definition]===============================*/
+static pthread_once_t bus_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t bus_lock;
+static int64_t clock_us;
+static uint32_t clock_hz = 100000;
+static uint32_t overhead_us = VIRTUAL_I2C_OVERHEAD_US;
+static virtual_i2c_device_t *devices[VIRTUAL_I2C_DEVICES];
+static uint8_t fail_address;
+static uint32_t fail_skip, fail_count;
+static esp_err_t fail_rc;
+static uint32_t transactions, bytes;
+static virtual_i2c_transaction_t trans_log[VIRTUAL_I2C_LOG];
+static uint8_t write_phase[WRITE_PHASE_SIZE];
+/*==================[internal functions definition]==========================*/
+static void LockInit(void){
+	pthread_mutexattr_t attr;
+
+	/* Device callbacks may read the clock */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&bus_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+static void Lock(void){
+	pthread_once(&bus_once, LockInit);
+	pthread_mutex_lock(&bus_lock);
+}
+
+static void Unlock(void){
+	pthread_mutex_unlock(&bus_lock);
+}
+
+static void Tick(void){
+	for(uint8_t i = 0; i < VIRTUAL_I2C_DEVICES; i++){
+		if(devices[i] != NULL && devices[i]->tick != NULL){
+			devices[i]->tick(devices[i]->ctx, clock_us);
+		}
+	}
+}
+
+static virtual_i2c_device_t* Find(uint8_t address){
+	for(uint8_t i = 0; i < VIRTUAL_I2C_DEVICES; i++){
+		if(devices[i] != NULL && devices[i]->address == address){
+			return devices[i];
+		}
+	}
+	return NULL;
+}
+
+static bool Failed(uint8_t address){
+	if(fail_count == 0 || (fail_address != 0 && fail_address != address)){
+		return false;
+	}
+	if(fail_skip > 0){
+		fail_skip--;
+		return false;
+	}
+	fail_count--;
+	return true;
+}
+
+static esp_err_t Add(i2c_cmd_handle_t cmd, i2c_op_t op){
+	if(cmd->count >= cmd->capacity){
+		return ESP_ERR_NO_MEM;
+	}
+	cmd->op[cmd->count++] = op;
+	return ESP_OK;
+}
+
+/** Number of SCL cycles of a command link */
+static uint32_t Bits(i2c_cmd_handle_t cmd){
+	uint32_t bits = 0;
+
+	for(uint16_t i = 0; i < cmd->count; i++){
+		switch(cmd->op[i].type){
+		case OP_START:
+		case OP_STOP:
+			bits += 1;
+			break;
+		case OP_WRITE:
+		case OP_READ:
+			bits += 9 * cmd->op[i].length;
+			break;
+		}
+	}
+	return bits;
+}
+
+static void Garbage(i2c_cmd_handle_t cmd){
+	for(uint16_t i = 0; i < cmd->count; i++){
+		if(cmd->op[i].type == OP_READ){
+			memset(cmd->op[i].rx, VIRTUAL_I2C_GARBAGE, cmd->op[i].length);
+		}
+	}
+}
+/*==================[external functions definition]==========================*/
+int64_t esp_timer_get_time(void){
+	int64_t now;
+
+	Lock();
+	now = clock_us;
+	Unlock();
+	return now;
+}
+
+void VirtualI2CReset(void){
+	Lock();
+	memset(devices, 0, sizeof(devices));
+	fail_count = 0;
+	transactions = 0;
+	bytes = 0;
+	overhead_us = VIRTUAL_I2C_OVERHEAD_US;
+	Unlock();
+}
+
+bool VirtualI2CAttach(virtual_i2c_device_t *dev){
+	bool attached = false;
+
+	Lock();
+	for(uint8_t i = 0; i < VIRTUAL_I2C_DEVICES && !attached; i++){
+		if(devices[i] == NULL){
+			devices[i] = dev;
+			attached = true;
+		}
+	}
+	Unlock();
+	return attached;
+}
+
+void VirtualI2CAdvance(int64_t us){
+	Lock();
+	clock_us += us;
+	Tick();
+	Unlock();
+}
+
+void VirtualI2CSetOverhead(uint32_t us){
+	Lock();
+	overhead_us = us;
+	Unlock();
+}
+
+void VirtualI2CFail(uint8_t address, uint32_t skip, uint32_t count, esp_err_t rc){
+	Lock();
+	fail_address = address;
+	fail_skip = skip;
+	fail_count = count;
+	fail_rc = rc;
+	Unlock();
+}
+
+uint32_t VirtualI2CTransactions(void){
+	return transactions;
+}
+
+uint32_t VirtualI2CBytes(void){
+	return bytes;
+}
+
+bool VirtualI2CTransaction(uint32_t index, virtual_i2c_transaction_t *trans){
+	bool found;
+
+	Lock();
+	found = index < transactions && transactions - index <= VIRTUAL_I2C_LOG;
+	if(found){
+		*trans = trans_log[index % VIRTUAL_I2C_LOG];
+	}
+	Unlock();
+	return found;
+}
+
+void VirtualI2CResetCounters(void){
+	Lock();
+	transactions = 0;
+	bytes = 0;
+	Unlock();
+}
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *conf){
+	(void)port;
+	clock_hz = conf->master.clk_speed;
+	return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t rx_buf, size_t tx_buf, int flags){
+	(void)port;
+	(void)mode;
+	(void)rx_buf;
+	(void)tx_buf;
+	(void)flags;
+	return ESP_OK;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void){
+	i2c_cmd_handle_t cmd = calloc(1, sizeof(struct i2c_cmd_link) + DYNAMIC_LINK_OPS * sizeof(i2c_op_t));
+
+	cmd->dynamic = true;
+	cmd->capacity = DYNAMIC_LINK_OPS;
+	return cmd;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size){
+	i2c_cmd_handle_t cmd = (i2c_cmd_handle_t)buffer;
+
+	if(size < sizeof(struct i2c_cmd_link)){
+		return NULL;
+	}
+	cmd->dynamic = false;
+	cmd->count = 0;
+	cmd->capacity = (size - sizeof(struct i2c_cmd_link)) / sizeof(i2c_op_t);
+	return cmd;
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd){
+	free(cmd);
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd){
+	(void)cmd;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd){
+	return Add(cmd, (i2c_op_t){.type = OP_START});
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd){
+	return Add(cmd, (i2c_op_t){.type = OP_STOP});
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en){
+	(void)ack_en;
+	return Add(cmd, (i2c_op_t){.type = OP_WRITE, .byte = data, .length = 1});
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t length, bool ack_en){
+	(void)ack_en;
+	return Add(cmd, (i2c_op_t){.type = OP_WRITE, .data = data, .length = length});
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd, uint8_t *data, i2c_ack_type_t ack){
+	(void)ack;
+	return Add(cmd, (i2c_op_t){.type = OP_READ, .rx = data, .length = 1});
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t length, i2c_ack_type_t ack){
+	(void)ack;
+	if(length == 0){
+		return ESP_ERR_INVALID_ARG;
+	}
+	return Add(cmd, (i2c_op_t){.type = OP_READ, .rx = data, .length = length});
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks){
+	virtual_i2c_device_t *dev = NULL;
+	virtual_i2c_transaction_t *logged;
+	esp_err_t rc = ESP_OK;
+	uint16_t written = 0;
+	bool address = false, first = true;
+	const uint8_t *data;
+	size_t k;
+
+	(void)port;
+	Lock();
+	Tick();
+	logged = &trans_log[transactions % VIRTUAL_I2C_LOG];
+	logged->address = 0;
+	logged->start = clock_us;
+	transactions++;
+	for(uint16_t i = 0; i < cmd->count && rc == ESP_OK; i++){
+		i2c_op_t *op = &cmd->op[i];
+		switch(op->type){
+		case OP_START:
+		case OP_STOP:
+			if(dev != NULL && written > 0){
+				dev->write(dev->ctx, write_phase, written);
+			}
+			written = 0;
+			address = (op->type == OP_START);
+			break;
+		case OP_WRITE:
+			data = (op->data != NULL) ? op->data : &op->byte;
+			for(k = 0; k < op->length; k++){
+				if(address){
+					address = false;
+					if(first){
+						logged->address = data[k] >> 1;
+					}
+					dev = Find(data[k] >> 1);
+					/* Failures are counted once per transaction, repeated STARTs included */
+					if(dev == NULL){
+						rc = ESP_FAIL;
+						break;
+					}
+					if(first && Failed(data[k] >> 1)){
+						rc = fail_rc;
+						break;
+					}
+					first = false;
+				} else if(written < WRITE_PHASE_SIZE){
+					write_phase[written++] = data[k];
+					bytes++;
+				}
+			}
+			break;
+		case OP_READ:
+			if(dev == NULL){
+				rc = ESP_ERR_INVALID_STATE;
+				break;
+			}
+			dev->read(dev->ctx, op->rx, op->length);
+			bytes += op->length;
+			break;
+		}
+	}
+	if(rc != ESP_OK){
+		Garbage(cmd);
+	}
+	if(rc == ESP_ERR_TIMEOUT){
+		/* Bus held: the driver gives up after the whole timeout */
+		clock_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+	} else{
+		clock_us += overhead_us + ((int64_t)Bits(cmd) * 1000000 + clock_hz - 1) / clock_hz;
+	}
+	logged->end = clock_us;
+	logged->failed = (rc != ESP_OK);
+	Unlock();
+	return rc;
+}
+
+/*==================[end of file]============================================*/
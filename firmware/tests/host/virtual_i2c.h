@@ -0,0 +1,98 @@
+#ifndef VIRTUAL_I2C_H_
+#define VIRTUAL_I2C_H_
+/**
+ * @file virtual_i2c.h
+ * @brief Virtual I2C bus for host tests of the I2C and MPU6050 drivers.
+ *
+ * @note Implements the legacy driver/i2c.h master API. Each i2c_master_cmd_begin()
+ * is one transaction: it is delivered to the device at the addressed slave
+ * address, and advances a virtual clock by the time the bytes take on the wire
+ * at the configured clock, plus a fixed software overhead. esp_timer_get_time()
+ * returns that clock, so timestamps and sample rates measured by the drivers are
+ * repeatable and independent of the host speed.
+ *
+ * @note Failures are injected per slave address. A failed transaction stops at the
+ * address byte: the device sees nothing, read buffers are filled with
+ * VIRTUAL_I2C_GARBAGE and the injected result is returned (ESP_FAIL for a NACK,
+ * ESP_ERR_TIMEOUT for a bus held until the timeout, which advances the clock by
+ * the whole timeout). Addresses without a device are always NACKed.
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+/*==================[macros]=================================================*/
+#define VIRTUAL_I2C_DEVICES			8		/*!< Maximum number of devices on the bus */
+#define VIRTUAL_I2C_OVERHEAD_US		30		/*!< Default software time of each transaction (us) */
+#define VIRTUAL_I2C_GARBAGE			0xEE	/*!< Value left in read buffers by failed transactions */
+#define VIRTUAL_I2C_LOG				64		/*!< Number of last transactions kept in the log */
+/*==================[typedef]================================================*/
+/**
+ * @brief Device on the virtual bus. Callbacks are called with the bus taken.
+ */
+typedef struct {
+	uint8_t address;										/*!< 7 bits slave address */
+	void *ctx;												/*!< Device state */
+	void (*write)(void *ctx, const uint8_t *data, uint16_t length);	/*!< Bytes written after the address, up to a START or STOP */
+	void (*read)(void *ctx, uint8_t *data, uint16_t length);		/*!< Bytes read by the master */
+	void (*tick)(void *ctx, int64_t now);					/*!< Virtual time has advanced (may be NULL) */
+} virtual_i2c_device_t;
+
+/**
+ * @brief Transaction kept in the log
+ */
+typedef struct {
+	uint8_t address;		/*!< Slave address of the first START (0 if none) */
+	int64_t start;			/*!< Virtual time at the start (us) */
+	int64_t end;			/*!< Virtual time at the end (us) */
+	bool failed;			/*!< Not ACKed or not completed */
+} virtual_i2c_transaction_t;
+
+/*==================[external functions declaration]=========================*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+/** Remove devices, pending failures and counters. The clock keeps running. */
+void VirtualI2CReset(void);
+
+/** Connect a device to the bus. */
+bool VirtualI2CAttach(virtual_i2c_device_t *dev);
+
+/** Advance the virtual clock, letting devices produce data. */
+void VirtualI2CAdvance(int64_t us);
+
+/** Set the software time added to each transaction (us). */
+void VirtualI2CSetOverhead(uint32_t us);
+
+/**
+ * @brief Fail transactions to a device
+ * @param address Slave address (0 for any device)
+ * @param skip Number of transactions to let through first
+ * @param count Number of transactions to fail
+ * @param rc Result of the failed transactions (ESP_FAIL: NACK, ESP_ERR_TIMEOUT: timeout,
+ * other: driver error)
+ */
+void VirtualI2CFail(uint8_t address, uint32_t skip, uint32_t count, esp_err_t rc);
+
+/** Number of transactions since the last reset (failed ones included). */
+uint32_t VirtualI2CTransactions(void);
+
+/** Number of bytes after the address bytes since the last reset. */
+uint32_t VirtualI2CBytes(void);
+
+/**
+ * @brief Get a logged transaction
+ * @param index Transaction number since the last counter reset (0 for the first)
+ * @param trans Transaction
+ * @return false if the transaction wasn't made or is no longer in the log
+ */
+bool VirtualI2CTransaction(uint32_t index, virtual_i2c_transaction_t *trans);
+
+/** Set transaction and byte counters to zero (and empty the log). */
+void VirtualI2CResetCounters(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VIRTUAL_I2C_H_ */
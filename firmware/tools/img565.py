@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Convert images to the compressed RGB565 format used by ILI9341DrawCompressedPicture().
+
+The format is described in firmware/drivers/devices/inc/img565.h. The output is a C
+file with a const uint8_t array, to be added to a project.
+
+Usage:
+    python img565.py splash.png splash > splash.c          (needs Pillow)
+    python img565.py picture.bin picture --size 240x320     (raw RGB565, big endian)
+    python img565.py esp_edu_pic.c picture_565 --size 240x320   (C array of RGB565 bytes)
+"""
+import argparse
+import re
+import sys
+
+INDEX_SIZE = 64
+
+
+def red(c):
+    return c >> 11
+
+
+def green(c):
+    return (c >> 5) & 0x3F
+
+
+def blue(c):
+    return c & 0x1F
+
+
+def color_hash(c):
+    return (red(c) * 3 + green(c) * 5 + blue(c) * 7) % INDEX_SIZE
+
+
+def wrap(value, bits):
+    """Difference between two components as a signed value of the given bits."""
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value >= 1 << (bits - 1) else value
+
+
+def encode(pixels, width, height):
+    out = bytearray(b"R565")
+    out += width.to_bytes(2, "big") + height.to_bytes(2, "big")
+    index = [0] * INDEX_SIZE
+    previous = 0
+    run = 0
+
+    def flush_run():
+        nonlocal run
+        while run > 0:
+            n = min(run, 1 << 16)
+            if n <= 62:
+                out.append(0xC0 | (n - 1))
+            else:
+                out.append(0xFF)
+                out.extend((n - 1).to_bytes(2, "big"))
+            run -= n
+
+    for c in pixels:
+        if c == previous:
+            run += 1
+            continue
+        flush_run()
+        h = color_hash(c)
+        if index[h] == c:
+            out.append(h)
+        else:
+            index[h] = c
+            dr = wrap(red(c) - red(previous), 5)
+            dg = wrap(green(c) - green(previous), 6)
+            db = wrap(blue(c) - blue(previous), 5)
+            half = (dg + 32) // 2 - 16
+            dr_dg = wrap(dr - half, 5)
+            db_dg = wrap(db - half, 5)
+            if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                out.append(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2))
+            elif -8 <= dr_dg <= 7 and -8 <= db_dg <= 7:
+                out.append(0x80 | (dg + 32))
+                out.append((dr_dg + 8) << 4 | (db_dg + 8))
+            else:
+                out.append(0xFE)
+                out += c.to_bytes(2, "big")
+        previous = c
+    flush_run()
+    return bytes(out)
+
+
+def read_pixels(path, size):
+    if path.endswith(".bin") or path.endswith(".c"):
+        if size is None:
+            sys.exit("--size is needed for raw pictures")
+        width, height = size
+        if path.endswith(".c"):
+            with open(path) as f:
+                data = bytes(int(b, 16) for b in re.findall(r"0x([0-9a-fA-F]{2})", f.read()))
+        else:
+            with open(path, "rb") as f:
+                data = f.read()
+        if len(data) != width * height * 2:
+            sys.exit("%s has %d bytes, %dx%d needs %d" % (path, len(data), width, height, width * height * 2))
+        pixels = [data[i] << 8 | data[i + 1] for i in range(0, len(data), 2)]
+        return pixels, width, height
+    from PIL import Image
+    img = Image.open(path).convert("RGB")
+    width, height = img.size
+    pixels = [(r >> 3) << 11 | (g >> 2) << 5 | (b >> 3) for r, g, b in img.getdata()]
+    return pixels, width, height
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="PNG/BMP image, raw RGB565 .bin file or C array .c file")
+    parser.add_argument("name", help="name of the C array")
+    parser.add_argument("--size", help="WIDTHxHEIGHT of raw pictures")
+    args = parser.parse_args()
+
+    size = tuple(int(v) for v in args.size.lower().split("x")) if args.size else None
+    pixels, width, height = read_pixels(args.input, size)
+    data = encode(pixels, width, height)
+
+    print("#include <stdint.h>\n")
+    print("/* %dx%d pixels, %d bytes (%d bytes uncompressed) */" % (width, height, len(data), width * height * 2))
+    print("const uint8_t %s[] = {" % args.name)
+    for i in range(0, len(data), 32):
+        print(" " + ",".join("0x%02x" % b for b in data[i:i + 32]) + ",")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()